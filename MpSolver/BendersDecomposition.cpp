@@ -0,0 +1,172 @@
+#include "BendersDecomposition.h"
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+BendersDecomposition::BendersDecomposition(MpSolver &masterProblem, const List<DecisionVar> &masterDecisions, int scenarioCount,
+    BuildSubproblem buildSubproblem, const Configuration &config, const List<double> &probabilities)
+    : cfg(config), master(masterProblem), masterVars(masterDecisions), scenarioNum(scenarioCount), build(buildSubproblem),
+    weights(probabilities), pool(config.threadNum), subproblems(scenarioCount), cuts(scenarioCount),
+    hasCut(scenarioCount, false), hasFailed(scenarioCount, false), isAborted(false) {
+    if (weights.empty()) { weights.assign(scenarioNum, 1); }
+}
+
+void BendersDecomposition::init() {
+    int clusterNum = getClusterCount();
+    List<double> clusterWeights(clusterNum, 0);
+    for (int s = 0; s < scenarioNum; ++s) { clusterWeights[getCluster(s)] += weights[s]; }
+
+    recourseVars.clear();
+    recourseExpr = 0;
+    for (int c = 0; c < clusterNum; ++c) {
+        recourseVars.push_back(master.addVar(MpSolver::VariableType::Real,
+            cfg.recourseLowerBound * clusterWeights[c], MpSolver::Infinity, 0, MpSolver::Name::str("theta", c)));
+        recourseExpr += recourseVars.back();
+    }
+
+    master.setMipSlnEvent([this](MpSolver::MpEvent &e) { separate(e); });
+}
+
+bool BendersDecomposition::optimize() {
+    isAborted = false;
+    bool isSolved = master.optimize() && !isAborted;
+    Log(LogSwitch::Szx::MpSolver) << "benders: separation=" << stat.separationNum << " optCut=" << stat.optimalityCutNum
+        << " feaCut=" << stat.feasibilityCutNum << endl;
+    return isSolved;
+}
+
+void BendersDecomposition::separate(MpSolver::MpEvent &e) {
+    ++stat.separationNum;
+    masterValues = Arr<double>(static_cast<int>(masterVars.size()));
+    for (size_t i = 0; i < masterVars.size(); ++i) { masterValues[static_cast<int>(i)] = e.getValue(masterVars[i]); }
+
+    // each worker solves the scenarios it owns.
+    int threadNum = pool.size();
+    pool.broadcast([&](int threadIndex) {
+        for (int s = threadIndex; s < scenarioNum; s += threadNum) { solveScenario(s); }
+    });
+    stat.subproblemSolveNum += scenarioNum;
+
+    // the incumbent can be neither cut off nor certified without a valid cut from every scenario.
+    for (int s = 0; s < scenarioNum; ++s) {
+        if (!hasFailed[s]) { continue; }
+        Log(LogSwitch::Szx::MpSolver) << "benders: abort since subproblem " << s << " is neither solved nor certified infeasible." << endl;
+        isAborted = true;
+        e.stop();
+        return;
+    }
+
+    // aggregate the optimality cuts in each cluster.
+    int clusterNum = getClusterCount();
+    List<LinearExpr> clusterExprs(clusterNum);
+    List<double> clusterCosts(clusterNum, 0);
+    List<char> isClusterComplete(clusterNum, true);
+    for (int s = 0; s < scenarioNum; ++s) {
+        int c = getCluster(s);
+        if (!hasCut[s]) { isClusterComplete[c] = false; continue; }
+        const Cut &cut(cuts[s]);
+        LinearExpr expr = cut.constant;
+        double value = cut.constant;
+        for (size_t k = 0; k < cut.masterVarIndices.size(); ++k) {
+            expr += cut.coefs[k] * masterVars[cut.masterVarIndices[k]];
+            value += cut.coefs[k] * masterValues[cut.masterVarIndices[k]];
+        }
+        if (cut.isFeasibilityCut) {
+            isClusterComplete[c] = false;
+            e.addLazy(expr, MpSolver::ConstraintSense::LessEqual, 0);
+            ++stat.feasibilityCutNum;
+        } else {
+            clusterExprs[c] += weights[s] * expr;
+            clusterCosts[c] += weights[s] * value;
+        }
+    }
+    for (int c = 0; c < clusterNum; ++c) {
+        if (!isClusterComplete[c]) { continue; }
+        double recourse = e.getValue(recourseVars[c]);
+        if (recourse >= clusterCosts[c] - cfg.violationTolerance * (max)(1.0, abs(clusterCosts[c]))) { continue; }
+        e.addLazy(recourseVars[c] - clusterExprs[c], MpSolver::ConstraintSense::GreaterEqual, 0);
+        ++stat.optimalityCutNum;
+    }
+}
+
+void BendersDecomposition::solveScenario(int scenario) {
+    hasCut[scenario] = false;
+    hasFailed[scenario] = true;
+    unique_ptr<Subproblem> &sub(subproblems[scenario]);
+    if (!sub) {
+        sub.reset(new Subproblem());
+        build(scenario, *sub);
+        sub->model.setInfeasibilityCertificate();
+    }
+
+    // fix the master decisions in the linking rows.
+    for (auto row = sub->linkingRows.begin(); row != sub->linkingRows.end(); ++row) {
+        double rhs = row->constant;
+        for (size_t k = 0; k < row->masterVarIndices.size(); ++k) { rhs += row->coefs[k] * masterValues[row->masterVarIndices[k]]; }
+        sub->model.setRhs(row->constr, rhs);
+    }
+    sub->model.optimize();
+
+    // the gradient of the recourse cost on the master decisions.
+    Cut &cut(cuts[scenario]);
+    cut.masterVarIndices.clear();
+    cut.coefs.clear();
+    Map<int, double> gradient;
+    MpSolver::ResultStatus status = sub->model.getStatus();
+    if (status == MpSolver::ResultStatus::Optimal) { // the duals of a suboptimal solution may not give a valid cut.
+        // Q(x) >= Q(x*) + sum(pi[i] * (rhs[i](x) - rhs[i](x*))).
+        cut.isFeasibilityCut = false;
+        cut.constant = sub->model.getObjectiveValue();
+        for (auto row = sub->linkingRows.begin(); row != sub->linkingRows.end(); ++row) {
+            double pi = sub->model.getDual(row->constr);
+            if (pi == 0) { continue; }
+            for (size_t k = 0; k < row->masterVarIndices.size(); ++k) { gradient[row->masterVarIndices[k]] += pi * row->coefs[k]; }
+        }
+        hasCut[scenario] = true;
+    } else if (status == MpSolver::ResultStatus::InsolubleModel) {
+        // y'b(x) >= min{y'Ay} must hold for feasible x, i.e., (min{y'Ay} - y'b(x)) <= 0.
+        Arr<double> multipliers;
+        double minActivity;
+        if (sub->model.getFarkasCertificate(multipliers, minActivity)) {
+            Arr<MpSolver::Constraint> constrs(sub->model.getAllConstraints());
+            double aggregatedRhs = 0;
+            for (int r = 0; r < constrs.size(); ++r) {
+                if (multipliers[r] != 0) { aggregatedRhs += multipliers[r] * sub->model.getRhs(constrs[r]); }
+            }
+            cut.isFeasibilityCut = true;
+            cut.constant = minActivity - aggregatedRhs;
+            for (auto row = sub->linkingRows.begin(); row != sub->linkingRows.end(); ++row) {
+                double y = multipliers[row->constr.index()];
+                if (y == 0) { continue; }
+                for (size_t k = 0; k < row->masterVarIndices.size(); ++k) { gradient[row->masterVarIndices[k]] -= y * row->coefs[k]; }
+            }
+            hasCut[scenario] = true;
+        }
+    }
+    hasFailed[scenario] = !hasCut[scenario]; // e.g., unbounded, out of limits or infeasible without a certificate.
+    if (hasCut[scenario]) { // move the cut from the master values to the master variables.
+        for (auto g = gradient.begin(); g != gradient.end(); ++g) {
+            if (g->second == 0) { continue; }
+            cut.masterVarIndices.push_back(g->first);
+            cut.coefs.push_back(g->second);
+            cut.constant -= g->second * masterValues[g->first];
+        }
+    }
+
+    if (!cfg.cacheSubproblems) { sub.reset(); }
+}
+
+void BendersDecomposition::releaseSubproblems() {
+    // the models must be freed before the environments of the worker threads.
+    int threadNum = pool.size();
+    pool.broadcast([&](int threadIndex) {
+        for (int s = threadIndex; s < scenarioNum; s += threadNum) { subproblems[s].reset(); }
+    });
+}
+
+}
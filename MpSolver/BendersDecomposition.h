@@ -0,0 +1,154 @@
+////////////////////////////////
+/// usage : 1.	solve two-stage models by Benders decomposition on the lazy constraint callback of the master.
+///         2.	the subproblems are built and solved in parallel on worker threads with their own solver environments.
+///
+/// note  : 1.	the subproblems should be LPs which minimize the recourse cost.
+///         2.	the master objective must include getRecourseExpr() after init().
+///         3.	each scenario is always built and solved on the same worker thread, so that its model
+///             stays in the environment of that thread.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_BENDERS_DECOMPOSITION_H
+#define SMART_SZX_GATE_REASSIGNMENT_BENDERS_DECOMPOSITION_H
+
+
+#include "Config.h"
+
+#include <functional>
+#include <memory>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+
+
+namespace szx {
+
+class BendersDecomposition {
+    #pragma region Constant
+public:
+    static constexpr int MultiCut = 0; // one recourse variable for each scenario.
+    static constexpr int SingleCut = 1; // one recourse variable for all scenarios.
+    #pragma endregion Constant
+
+    #pragma region Type
+public:
+    using DecisionVar = MpSolver::DecisionVar;
+    using Constraint = MpSolver::Constraint;
+    using LinearExpr = MpSolver::LinearExpr;
+
+    struct Configuration {
+        static constexpr double DefaultRecourseLowerBound = 0;
+        static constexpr double DefaultViolationTolerance = 1e-6;
+
+        Configuration(int threads = ThreadPool::getHardwareConcurrency(), int clusters = MultiCut,
+            double recourseLb = DefaultRecourseLowerBound, bool shouldCacheSubproblems = true)
+            : threadNum(threads), clusterNum(clusters), recourseLowerBound(recourseLb),
+            violationTolerance(DefaultViolationTolerance), cacheSubproblems(shouldCacheSubproblems) {}
+
+        int threadNum;
+        int clusterNum; // the scenarios in the same cluster share an aggregated cut. MultiCut for no aggregation.
+        double recourseLowerBound; // a valid lower bound on the recourse cost of any scenario.
+        double violationTolerance; // relative tolerance on the recourse cost to regard a cut as violated.
+        bool cacheSubproblems; // keep the subproblems after solving, or rebuild them every time to save memory.
+    };
+
+    // a constraint in the subproblem whose rhs depends on the master decisions:
+    // rhs = constant + sum(coefs[k] * masterVars[masterVarIndices[k]]).
+    struct LinkingRow {
+        Constraint constr;
+        double constant;
+        List<int> masterVarIndices;
+        List<double> coefs;
+    };
+
+    struct Subproblem {
+        void addLinkingRow(const Constraint &constr, double constant, const List<int> &masterVarIndices, const List<double> &coefs) {
+            linkingRows.push_back({ constr, constant, masterVarIndices, coefs });
+        }
+
+        MpSolver model;
+        List<LinkingRow> linkingRows;
+    };
+
+    // build the model of the scenario in sub.model and register its linking rows.
+    using BuildSubproblem = std::function<void(int scenario, Subproblem &sub)>;
+
+    // (constant + sum(coefs[k] * masterVars[masterVarIndices[k]])) is the recourse cost for optimality cut,
+    // or should not be greater than 0 for feasibility cut.
+    struct Cut {
+        bool isFeasibilityCut;
+        double constant;
+        List<int> masterVarIndices;
+        List<double> coefs;
+    };
+
+    struct Statistics {
+        int separationNum = 0;
+        int subproblemSolveNum = 0;
+        int optimalityCutNum = 0;
+        int feasibilityCutNum = 0;
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    /// probabilities[s] is the weight of the recourse cost of scenario s, which are all 1 if it is empty.
+    BendersDecomposition(MpSolver &masterProblem, const List<DecisionVar> &masterDecisions, int scenarioCount,
+        BuildSubproblem buildSubproblem, const Configuration &config = Configuration(), const List<double> &probabilities = List<double>());
+    ~BendersDecomposition() { releaseSubproblems(); }
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// add the recourse variables to the master and take over its MIP solution event.
+    void init();
+
+    /// the weighted sum of the recourse costs to be added into the master objective.
+    const LinearExpr& getRecourseExpr() const { return recourseExpr; }
+
+    /// return false if the master is not solved or any subproblem is neither solved to optimality
+    /// nor certified infeasible by a Farkas certificate, where the incumbent of the master is untrustworthy.
+    bool optimize();
+
+    const Statistics& getStatistics() const { return stat; }
+
+protected:
+    void separate(MpSolver::MpEvent &e);
+    void solveScenario(int scenario);
+    void releaseSubproblems();
+
+    int getClusterCount() const { return (cfg.clusterNum == MultiCut) ? scenarioNum : (std::min)(cfg.clusterNum, scenarioNum); }
+    int getCluster(int scenario) const { return static_cast<int>(static_cast<long long>(scenario) * getClusterCount() / scenarioNum); }
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    MpSolver &master;
+    List<DecisionVar> masterVars;
+    int scenarioNum;
+    BuildSubproblem build;
+    List<double> weights;
+
+    List<DecisionVar> recourseVars; // recourseVars[c] is the recourse cost of cluster c.
+    LinearExpr recourseExpr;
+
+    ThreadPool pool;
+    List<std::unique_ptr<Subproblem>> subproblems;
+    List<Cut> cuts; // cuts[s] is the cut generated by scenario s in the current separation.
+    List<char> hasCut;
+    List<char> hasFailed; // hasFailed[s] is set if scenario s generates no valid cut.
+    bool isAborted; // the master is stopped since a subproblem failed.
+    Arr<double> masterValues;
+
+    Statistics stat;
+    #pragma endregion Field
+}; // BendersDecomposition
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_BENDERS_DECOMPOSITION_H
@@ -0,0 +1,94 @@
+#include "ColumnGeneration.h"
+
+#include <algorithm>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+bool ColumnGeneration::optimize(const CancellationToken &cancellation) {
+    CancellationToken token(cancellation.createChild());
+    token.setDeadlineInSecond(cfg.timeoutInSecond);
+
+    // relax the integrality of the existing variables during column generation.
+    Arr<DecisionVar> vars(master.getAllVars());
+    List<MpSolver::VariableType> types;
+    types.reserve(vars.size());
+    for (auto v = vars.begin(); v != vars.end(); ++v) {
+        types.push_back(master.getType(*v));
+        master.setType(*v, MpSolver::VariableType::Real);
+    }
+    master.setLpMethod(MpSolver::LpMethod::PrimalSimplex);
+
+    Arr<Constraint> masterRows(static_cast<int>(rows.size()));
+    copy(rows.begin(), rows.end(), masterRows.begin());
+    Arr<double> duals;
+    for (stat.iterationNum = 0; stat.iterationNum < cfg.maxIterationNum; ++stat.iterationNum) {
+        if (token.isCancelled()) { break; }
+        master.setTimeLimitInSecond(token.restSeconds(MpSolver::Configuration::Forever));
+        if (!master.optimize() || (master.getStatus() != MpSolver::ResultStatus::Optimal)) { break; }
+        stat.lpObj = master.getObjectiveValue();
+
+        master.getAllDuals(masterRows, duals);
+        int addedColumnNum = generateColumns(duals);
+        Log(LogSwitch::Szx::MpSolver) << "cg[" << stat.iterationNum << "]: lp=" << stat.lpObj << " columns=" << addedColumnNum << endl;
+        if (addedColumnNum == 0) {
+            stat.isLpOptimal = true;
+            break;
+        }
+    }
+    stat.columnNum = static_cast<int>(columns.size());
+
+    // restore the integrality and take the generated columns into account.
+    for (int i = 0; i < vars.size(); ++i) { master.setType(vars[i], types[i]); }
+    master.setLpMethod(MpSolver::LpMethod::DefaultLpMethod);
+    if (!cfg.solveIntegerMaster) { return stat.isLpOptimal; }
+    for (size_t i = 0; i < columns.size(); ++i) { master.setType(columnVars[i], columns[i].type); }
+
+    if (token.isCancelled()) { return false; }
+    master.setTimeLimitInSecond(token.restSeconds(MpSolver::Configuration::Forever));
+    return master.optimize();
+}
+
+int ColumnGeneration::generateColumns(const Arr<double> &duals) {
+    List<List<Column>> candidates(pricerNum);
+    int threadNum = pool.size();
+    pool.broadcast([&](int threadIndex) {
+        for (int p = threadIndex; p < pricerNum; p += threadNum) { price(p, duals, candidates[p]); }
+    });
+
+    // keep the improving columns in the order of their reduced costs.
+    List<Column*> improvingColumns;
+    for (auto p = candidates.begin(); p != candidates.end(); ++p) {
+        for (auto c = p->begin(); c != p->end(); ++c) {
+            c->reducedCost = c->objCoef;
+            for (size_t i = 0; i < c->rowIndices.size(); ++i) { c->reducedCost -= duals[c->rowIndices[i]] * c->coefs[i]; }
+            if (isImproving(c->reducedCost)) { improvingColumns.push_back(&(*c)); }
+        }
+    }
+    bool isMinimizing = (cfg.orientation == MpSolver::OptimaOrientation::Minimize);
+    sort(improvingColumns.begin(), improvingColumns.end(), [&](const Column *l, const Column *r) {
+        return isMinimizing ? (l->reducedCost < r->reducedCost) : (l->reducedCost > r->reducedCost);
+    });
+    if ((cfg.maxColumnNumPerIteration != Configuration::AllColumns)
+        && (static_cast<int>(improvingColumns.size()) > cfg.maxColumnNumPerIteration)) {
+        improvingColumns.resize(cfg.maxColumnNumPerIteration);
+    }
+
+    List<Constraint> columnRows;
+    for (auto c = improvingColumns.begin(); c != improvingColumns.end(); ++c) {
+        columnRows.clear();
+        for (auto r = (*c)->rowIndices.begin(); r != (*c)->rowIndices.end(); ++r) { columnRows.push_back(rows[*r]); }
+        // the bounds of a binary column are kept and it is relaxed to a real variable until the final integer solve.
+        double ub = ((*c)->type == MpSolver::VariableType::Bool) ? (std::min)((*c)->ub, 1.0) : (*c)->ub;
+        columnVars.push_back(master.addColumn(MpSolver::VariableType::Real, (*c)->lb, ub, (*c)->objCoef, columnRows, (*c)->coefs, (*c)->name));
+        columns.push_back(std::move(**c));
+    }
+    return static_cast<int>(improvingColumns.size());
+}
+
+}
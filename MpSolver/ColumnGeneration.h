@@ -0,0 +1,123 @@
+////////////////////////////////
+/// usage : 1.	solve the LP relaxation of a restricted master problem by column generation,
+///             then optionally solve the master with integrality over the generated columns (price-and-branch).
+///         2.	the pricing subproblems are solved in parallel on worker threads with their own solver environments.
+///
+/// note  : 1.	the master is re-solved warm by primal simplex since adding columns keeps the basis primal feasible.
+///         2.	each pricer is always invoked on the same worker thread, so that it may cache its model in that thread.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_COLUMN_GENERATION_H
+#define SMART_SZX_GATE_REASSIGNMENT_COLUMN_GENERATION_H
+
+
+#include "Config.h"
+
+#include <functional>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+
+
+namespace szx {
+
+class ColumnGeneration {
+    #pragma region Type
+public:
+    using DecisionVar = MpSolver::DecisionVar;
+    using Constraint = MpSolver::Constraint;
+
+    struct Configuration {
+        static constexpr int DefaultMaxIterationNum = (std::numeric_limits<int>::max)();
+        static constexpr int AllColumns = 0;
+        static constexpr double DefaultReducedCostTolerance = 1e-6;
+
+        Configuration(int threads = ThreadPool::getHardwareConcurrency(), double timeoutInSec = MpSolver::Configuration::Forever,
+            bool shouldSolveIntegerMaster = true, MpSolver::OptimaOrientation masterOrientation = MpSolver::OptimaOrientation::Minimize)
+            : threadNum(threads), timeoutInSecond(timeoutInSec), solveIntegerMaster(shouldSolveIntegerMaster), orientation(masterOrientation),
+            maxIterationNum(DefaultMaxIterationNum), maxColumnNumPerIteration(AllColumns), reducedCostTolerance(DefaultReducedCostTolerance) {}
+
+        int threadNum;
+        double timeoutInSecond; // total timeout including the final integer solve.
+        bool solveIntegerMaster; // solve the master with integrality after the LP relaxation is solved.
+        MpSolver::OptimaOrientation orientation; // the optima orientation of the master.
+        int maxIterationNum;
+        int maxColumnNumPerIteration; // only add the most improving columns in each iteration.
+        double reducedCostTolerance;
+    };
+
+    struct Column {
+        MpSolver::VariableType type = MpSolver::VariableType::Bool; // the type in the final integer solve.
+        double lb = 0;
+        double ub = MpSolver::Infinity;
+        double objCoef = 0;
+        List<int> rowIndices; // indices in the master rows given to the constructor.
+        List<double> coefs;
+        String name;
+        int tag = 0; // user defined identifier.
+
+        double reducedCost = 0; // filled by the engine.
+    };
+
+    // append columns which may improve the master to columns based on the duals of the master rows.
+    using Price = std::function<void(int pricer, const Arr<double> &duals, List<Column> &columns)>;
+
+    struct Statistics {
+        int iterationNum = 0;
+        int columnNum = 0;
+        double lpObj = 0;
+        bool isLpOptimal = false;
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    /// masterRows are the constraints which the generated columns may enter.
+    ColumnGeneration(MpSolver &masterProblem, const List<Constraint> &masterRows, int pricerCount,
+        Price pricing, const Configuration &config = Configuration())
+        : cfg(config), master(masterProblem), rows(masterRows), pricerNum(pricerCount), price(pricing), pool(config.threadNum) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// generate columns until no improving column is found, then solve the integer master if required.
+    /// the token is checked between the master solves, each of which is clamped to its deadline.
+    bool optimize(const CancellationToken &cancellation = CancellationToken());
+
+    const List<DecisionVar>& getColumnVars() const { return columnVars; }
+    const List<Column>& getColumns() const { return columns; }
+    const Statistics& getStatistics() const { return stat; }
+
+protected:
+    bool isImproving(double reducedCost) const {
+        return (cfg.orientation == MpSolver::OptimaOrientation::Minimize)
+            ? (reducedCost < -cfg.reducedCostTolerance) : (reducedCost > cfg.reducedCostTolerance);
+    }
+
+    // returns the number of added columns.
+    int generateColumns(const Arr<double> &duals);
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    MpSolver &master;
+    List<Constraint> rows;
+    int pricerNum;
+    Price price;
+
+    ThreadPool pool;
+    List<DecisionVar> columnVars;
+    List<Column> columns;
+
+    Statistics stat;
+    #pragma endregion Field
+}; // ColumnGeneration
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_COLUMN_GENERATION_H
@@ -0,0 +1,212 @@
+#include "ConditioningAnalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+ostream& operator<<(ostream &os, const ConditioningAnalyzer::Report &r) {
+    os << "matrix=" << r.coefs << " rhs=" << r.rhs << " bound=" << r.bounds << " warning=" << r.warningNum;
+    for (auto f = r.rowFamilies.begin(); f != r.rowFamilies.end(); ++f) {
+        os << "\n  row \"" << f->name << "\" num=" << f->rowNum << " coef=" << f->coefs << " rhs=" << f->rhs;
+    }
+    for (auto f = r.varFamilies.begin(); f != r.varFamilies.end(); ++f) {
+        os << "\n  var \"" << f->name << "\" num=" << f->varNum << " bound=" << f->bounds << " obj=" << f->objCoefs;
+    }
+    for (auto o = r.objectives.begin(); o != r.objectives.end(); ++o) {
+        os << "\n  obj \"" << o->name << "\" coef=" << o->coefs;
+    }
+    return os;
+}
+
+void ConditioningAnalyzer::analyze(const MpModelView &view, const List<String> &varNames, const List<String> &rowNames,
+    Report &report, const List<Objective> &objectives) {
+    int varNum = view.getVariableCount();
+    int rowNum = view.getConstraintCount();
+    report = Report();
+
+    Map<String, int> familyIndices;
+    for (int r = 0; r < rowNum; ++r) {
+        String name(rowNames.empty() ? String() : getFamilyName(rowNames[r]));
+        auto f = familyIndices.find(name);
+        if (f == familyIndices.end()) {
+            f = familyIndices.emplace(name, static_cast<int>(report.rowFamilies.size())).first;
+            report.rowFamilies.emplace_back();
+            report.rowFamilies.back().name = name;
+        }
+        RowFamily &family(report.rowFamilies[f->second]);
+        ++family.rowNum;
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) { family.coefs.add(view.coefs[i]); }
+        family.rhs.add(view.rhs[r]);
+    }
+
+    familyIndices.clear();
+    for (int v = 0; v < varNum; ++v) {
+        String name(varNames.empty() ? String() : getFamilyName(varNames[v]));
+        auto f = familyIndices.find(name);
+        if (f == familyIndices.end()) {
+            f = familyIndices.emplace(name, static_cast<int>(report.varFamilies.size())).first;
+            report.varFamilies.emplace_back();
+            report.varFamilies.back().name = name;
+        }
+        VarFamily &family(report.varFamilies[f->second]);
+        ++family.varNum;
+        family.bounds.add(view.lb[v]);
+        family.bounds.add(view.ub[v]);
+        family.objCoefs.add(view.obj[v]);
+    }
+
+    if (objectives.empty()) {
+        report.objectives.push_back({ "obj", Range() });
+        for (int v = 0; v < varNum; ++v) { report.objectives.back().coefs.add(view.obj[v]); }
+    } else { // merge the terms of the same variable before taking their ranges.
+        List<double> coefs(varNum, 0);
+        for (auto o = objectives.begin(); o != objectives.end(); ++o) {
+            report.objectives.push_back({ o->name, Range() });
+            for (size_t i = 0; i < o->vars.size(); ++i) { coefs[o->vars[i]] += o->coefs[i]; }
+            for (auto v = o->vars.begin(); v != o->vars.end(); ++v) {
+                report.objectives.back().coefs.add(coefs[*v]);
+                coefs[*v] = 0;
+            }
+        }
+    }
+
+    for (auto f = report.rowFamilies.begin(); f != report.rowFamilies.end(); ++f) {
+        report.coefs.add(f->coefs);
+        report.rhs.add(f->rhs);
+        review(report, "coef of row \"" + f->name + "\"", f->coefs, true);
+        review(report, "rhs of row \"" + f->name + "\"", f->rhs, false);
+    }
+    for (auto f = report.varFamilies.begin(); f != report.varFamilies.end(); ++f) {
+        report.bounds.add(f->bounds);
+        review(report, "bound of var \"" + f->name + "\"", f->bounds, false);
+    }
+    for (auto o = report.objectives.begin(); o != report.objectives.end(); ++o) {
+        review(report, "coef of obj \"" + o->name + "\"", o->coefs, true);
+    }
+    // the rows of different families are combined in the factorization, so their coefficients are related.
+    if (report.coefs.getRatio() > cfg.maxRangeRatio) {
+        ++report.warningNum;
+        Log(LogSwitch::Szx::MpSolver) << "conditioning: coef of matrix " << report.coefs << " spans more than " << cfg.maxRangeRatio << endl;
+    }
+    report.isWellScaled = (report.warningNum == 0);
+
+    Log(LogSwitch::Szx::MpSolver) << "conditioning: matrix=" << report.coefs << " rhs=" << report.rhs << " bound=" << report.bounds
+        << " warning=" << report.warningNum << endl;
+}
+
+void ConditioningAnalyzer::computeScaling(const MpModelView &view, bool scaleColumns, Scaling &scaling) const {
+    int varNum = view.getVariableCount();
+    int rowNum = view.getConstraintCount();
+    scaling.rowScales.assign(rowNum, 1);
+    scaling.colScales.assign(varNum, 1);
+
+    List<char> isScalable(varNum, false);
+    if (scaleColumns) {
+        for (int v = 0; v < varNum; ++v) { isScalable[v] = (view.type[v] == Continuous); }
+    }
+
+    // the geometric mean scaling divides each row or column by the square root of the product of its extreme values.
+    double initialRatio = getScaledRatio(view, scaling);
+    double lastRatio = initialRatio;
+    Scaling next;
+    List<Range> colRanges(varNum);
+    int passNum = 0;
+    for (; passNum < cfg.maxScalingPassNum; ++passNum) {
+        next = scaling;
+        for (int r = 0; r < rowNum; ++r) {
+            Range range;
+            for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) { range.add(view.coefs[i] * next.colScales[view.cols[i]]); }
+            if (!range.empty()) { next.rowScales[r] = 1 / sqrt(range.minValue * range.maxValue); }
+        }
+        fill(colRanges.begin(), colRanges.end(), Range());
+        for (int r = 0; r < rowNum; ++r) {
+            for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) { colRanges[view.cols[i]].add(view.coefs[i] * next.rowScales[r]); }
+        }
+        for (int v = 0; v < varNum; ++v) {
+            if (isScalable[v] && !colRanges[v].empty()) { next.colScales[v] = 1 / sqrt(colRanges[v].minValue * colRanges[v].maxValue); }
+        }
+
+        double ratio = getScaledRatio(view, next);
+        if (ratio >= lastRatio) { break; }
+        swap(scaling, next);
+        bool isSlow = (ratio > cfg.minScalingImprovement * lastRatio);
+        lastRatio = ratio;
+        if (isSlow) { ++passNum; break; }
+    }
+
+    // the equilibration brings the largest absolute value in each row and then in each column to 1.
+    for (int r = 0; r < rowNum; ++r) {
+        Range range;
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) { range.add(view.coefs[i] * scaling.colScales[view.cols[i]]); }
+        if (!range.empty()) { scaling.rowScales[r] = 1 / range.maxValue; }
+    }
+    fill(colRanges.begin(), colRanges.end(), Range());
+    for (int r = 0; r < rowNum; ++r) {
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) { colRanges[view.cols[i]].add(view.coefs[i] * scaling.rowScales[r]); }
+    }
+    for (int v = 0; v < varNum; ++v) {
+        if (isScalable[v] && !colRanges[v].empty()) { scaling.colScales[v] = 1 / colRanges[v].maxValue; }
+    }
+
+    for (auto s = scaling.rowScales.begin(); s != scaling.rowScales.end(); ++s) { *s = roundToPowerOf2(*s); }
+    for (auto s = scaling.colScales.begin(); s != scaling.colScales.end(); ++s) { *s = roundToPowerOf2(*s); }
+    double ratio = getScaledRatio(view, scaling);
+    if (ratio > initialRatio) { // the rounding and the equilibration may spoil a well scaled model.
+        fill(scaling.rowScales.begin(), scaling.rowScales.end(), 1.0);
+        fill(scaling.colScales.begin(), scaling.colScales.end(), 1.0);
+        ratio = initialRatio;
+    }
+    Log(LogSwitch::Szx::MpSolver) << "scaling: pass=" << passNum << " ratio=" << initialRatio << "->" << ratio << endl;
+}
+
+String ConditioningAnalyzer::getFamilyName(const String &name) {
+    String family;
+    family.reserve(name.size());
+    for (auto c = name.begin(); c != name.end(); ++c) {
+        if ((*c < '0') || (*c > '9')) { family.push_back(*c); }
+    }
+    return family;
+}
+
+void ConditioningAnalyzer::review(Report &report, const String &item, const Range &range, bool checkRatio) const {
+    if (range.empty()) { return; }
+    if (checkRatio && (range.getRatio() > cfg.maxRangeRatio)) {
+        ++report.warningNum;
+        Log(LogSwitch::Szx::MpSolver) << "conditioning: " << item << " " << range << " spans more than " << cfg.maxRangeRatio << endl;
+    }
+    if (range.maxValue > cfg.maxMagnitude) {
+        ++report.warningNum;
+        Log(LogSwitch::Szx::MpSolver) << "conditioning: " << item << " " << range << " exceeds " << cfg.maxMagnitude << endl;
+    }
+    if (range.minValue < cfg.minMagnitude) {
+        ++report.warningNum;
+        Log(LogSwitch::Szx::MpSolver) << "conditioning: " << item << " " << range << " falls below " << cfg.minMagnitude << endl;
+    }
+}
+
+double ConditioningAnalyzer::getScaledRatio(const MpModelView &view, const Scaling &scaling) {
+    Range range;
+    int rowNum = view.getConstraintCount();
+    for (int r = 0; r < rowNum; ++r) {
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) {
+            range.add(view.coefs[i] * scaling.rowScales[r] * scaling.colScales[view.cols[i]]);
+        }
+    }
+    return range.getRatio();
+}
+
+double ConditioningAnalyzer::roundToPowerOf2(double scale) {
+    int maxExponent = MaxScaleExponent;
+    int exponent = static_cast<int>(round(log2(scale)));
+    exponent = (min)((max)(exponent, -maxExponent), maxExponent);
+    return ldexp(1.0, exponent);
+}
+
+}
@@ -0,0 +1,168 @@
+////////////////////////////////
+/// usage : 1.	report the ranges of the absolute values of the coefficients, the rhs, the bounds and the objectives
+///             by the families of the rows and the variables, which are named by their names without digits,
+///             e.g., "gateCap[3]" and "gateCap[12]" are both in the family "gateCap[]".
+///         2.	compute the row and column scaling factors of the geometric mean scaling followed by the equilibration,
+///             which are rounded to the powers of 2 so that scaling and unscaling introduce no rounding error.
+///
+/// note  : 1.	the zeros and the infinite values are excluded from the ranges.
+///         2.	only the continuous variables are scaled, since scaling an integer variable breaks its integrality.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_CONDITIONING_ANALYZER_H
+#define SMART_SZX_GATE_REASSIGNMENT_CONDITIONING_ANALYZER_H
+
+
+#include "Config.h"
+
+#include <iostream>
+
+#include "Common.h"
+#include "MpModelData.h"
+
+
+namespace szx {
+
+class ConditioningAnalyzer {
+    #pragma region Constant
+public:
+    static constexpr char Continuous = 'C'; // the type of the variables which can be scaled.
+
+    static constexpr double Infinity = 1e100; // any value whose absolute value is not less than it is infinite.
+    static constexpr int MaxScaleExponent = 32; // the scaling factors are in [2^-32, 2^32].
+    #pragma endregion Constant
+
+    #pragma region Type
+public:
+    struct Configuration {
+        static constexpr double DefaultMaxRangeRatio = 1e6;
+        static constexpr double DefaultMaxMagnitude = 1e6;
+        static constexpr double DefaultMinMagnitude = 1e-6; // the default feasibility tolerance.
+        static constexpr int DefaultMaxScalingPassNum = 8;
+        static constexpr double DefaultMinScalingImprovement = 0.9;
+
+        Configuration() : maxRangeRatio(DefaultMaxRangeRatio), maxMagnitude(DefaultMaxMagnitude), minMagnitude(DefaultMinMagnitude),
+            maxScalingPassNum(DefaultMaxScalingPassNum), minScalingImprovement(DefaultMinScalingImprovement) {}
+
+        // the model is badly scaled if any range exceeds the thresholds.
+        double maxRangeRatio;
+        double maxMagnitude;
+        double minMagnitude;
+
+        int maxScalingPassNum; // the geometric mean scaling passes.
+        double minScalingImprovement; // stop if the ratio of the matrix range does not drop below (improvement * last ratio).
+    };
+
+    // the range of the nonzero finite absolute values.
+    struct Range {
+        friend std::ostream& operator<<(std::ostream &os, const Range &r) {
+            if (r.empty()) { return os << "[]"; }
+            return os << "[" << r.minValue << ", " << r.maxValue << "]";
+        }
+
+        void add(double value) {
+            value = (value < 0) ? -value : value;
+            if ((value == 0) || (value >= Infinity)) { return; }
+            if (value < minValue) { minValue = value; }
+            if (value > maxValue) { maxValue = value; }
+            ++count;
+        }
+        void add(const Range &r) {
+            if (r.empty()) { return; }
+            if (r.minValue < minValue) { minValue = r.minValue; }
+            if (r.maxValue > maxValue) { maxValue = r.maxValue; }
+            count += r.count;
+        }
+
+        bool empty() const { return (count <= 0); }
+        double getRatio() const { return empty() ? 1 : (maxValue / minValue); }
+
+        double minValue = Infinity;
+        double maxValue = 0;
+        int count = 0;
+    };
+
+    struct RowFamily {
+        String name;
+        int rowNum = 0;
+        Range coefs;
+        Range rhs;
+    };
+
+    struct VarFamily {
+        String name;
+        int varNum = 0;
+        Range bounds;
+        Range objCoefs; // the objective coefficients in the flat model.
+    };
+
+    // the objective in sparse form, e.g., each sub-objective or their weighted sum.
+    struct Objective {
+        String name;
+        List<int> vars;
+        List<double> coefs;
+    };
+
+    struct ObjectiveRange {
+        String name;
+        Range coefs;
+    };
+
+    struct Report {
+        friend std::ostream& operator<<(std::ostream &os, const Report &r);
+
+        Range coefs;
+        Range rhs;
+        Range bounds;
+        List<ObjectiveRange> objectives;
+        List<RowFamily> rowFamilies;
+        List<VarFamily> varFamilies;
+        int warningNum = 0;
+        bool isWellScaled = true;
+    };
+
+    // the model is scaled into (R * A * C) (x / c) (sense) (R * b) with (lb / c) <= (x / c) <= (ub / c) and
+    // the objective coefficients (obj * c), where R and C are the diagonal matrices of the row and the column scales.
+    struct Scaling {
+        List<double> rowScales;
+        List<double> colScales;
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    ConditioningAnalyzer(const Configuration &config = Configuration()) : cfg(config) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// varNames and rowNames are either empty or of the same size as the variables and the rows.
+    /// the objectives are analyzed instead of view.obj if there is any.
+    void analyze(const MpModelView &view, const List<String> &varNames, const List<String> &rowNames, Report &report,
+        const List<Objective> &objectives = List<Objective>());
+
+    /// the columns are left unscaled if scaleColumns is not set, e.g., the variables are referred by nonlinear constraints.
+    void computeScaling(const MpModelView &view, bool scaleColumns, Scaling &scaling) const;
+
+    /// the name without digits.
+    static String getFamilyName(const String &name);
+
+protected:
+    // check the range and log it if it is badly scaled, where the ratio is ignored for the values unrelated to each other.
+    void review(Report &report, const String &item, const Range &range, bool checkRatio) const;
+
+    // the ratio of the matrix range after scaling.
+    static double getScaledRatio(const MpModelView &view, const Scaling &scaling);
+    static double roundToPowerOf2(double scale);
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+    #pragma endregion Field
+}; // ConditioningAnalyzer
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_CONDITIONING_ANALYZER_H
@@ -97,6 +97,11 @@
 #pragma region DebugHelper
 // [off] activate test codes like additional check for data consistency..
 #define SZX_DEBUG  _CC_MS_VC
+
+// [on] the most verbose log level which is compiled, i.e., 0 (Off), 1 (On), 2 (Info) or 3 (Debug).
+#ifndef SZX_LOG_LEVEL
+#define SZX_LOG_LEVEL  3
+#endif // SZX_LOG_LEVEL
 #pragma endregion DebugHelper
 
 
@@ -0,0 +1,224 @@
+#include "InfeasibilityDiagnoser.h"
+
+#include <algorithm>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+bool InfeasibilityDiagnoser::diagnose(MpSolver &model, Diagnosis &diagnosis, const CancellationToken &cancellation) {
+    CancellationToken token(cancellation.createChild());
+    token.setDeadlineInSecond(cfg.timeoutInSecond);
+    Timer timer(0ms); // only for the elapsed time.
+    if (!model.isLinear() || model.isPresolved() || model.isScaled()) {
+        Log(LogSwitch::Szx::MpSolver) << "diagnose: skipped since the model is not linear or is reduced." << endl;
+        return false;
+    }
+    MpModelData data;
+    model.save(data);
+    const MpModelView &view(data.getView());
+
+    for (int m = 0; m < MethodNum; ++m) { engineTokens[m] = token.createChild(); }
+    isDecided = false;
+    Result results[MethodNum];
+    pool.broadcast([&](int threadIndex) {
+        Method method = static_cast<Method>(threadIndex);
+        if (!cfg.enabled[method]) { return; }
+        Timer engineTimer(0ms);
+        {
+            MpSolver solver; // each engine solves in the environment of its own thread.
+            solver.setCancellationToken(engineTokens[method]);
+            solver.setTimeLimitInSecond(token.restSeconds(MpSolver::Configuration::Forever)); // the IIS is not clamped by the token.
+            if (!isRaceOver()) {
+                if (method == Method::Iis) { runIis(view, solver, results[method]); } else { runRelaxation(view, solver, results[method]); }
+            }
+            results[method].elapsedSeconds = engineTimer.elapsedSeconds();
+            leave(method, results[method]);
+        }
+    });
+
+    // prefer the first conclusive result, then the partial IIS.
+    const Result *best = nullptr;
+    Method bestMethod = Method::Iis;
+    for (int m = 0; m < MethodNum; ++m) {
+        if (!results[m].isFound) { continue; }
+        bool isBetter = !best || (results[m].isConclusive && (!best->isConclusive || (results[m].elapsedSeconds < best->elapsedSeconds)));
+        if (!isBetter) { continue; }
+        best = &results[m];
+        bestMethod = static_cast<Method>(m);
+    }
+    if (!best) { return false; }
+
+    // map the indices back to the original model.
+    Arr<DecisionVar> vars(model.getAllVars());
+    Arr<Constraint> constraints(model.getAllConstraints());
+    diagnosis = Diagnosis();
+    diagnosis.method = bestMethod;
+    diagnosis.isConclusive = best->isConclusive;
+    diagnosis.totalViolation = best->totalViolation;
+    diagnosis.elapsedSeconds = timer.elapsedSeconds();
+    for (size_t i = 0; i < best->constraints.size(); ++i) {
+        int r = best->constraints[i];
+        diagnosis.constraints.push_back({ constraints[r], r, model.getName(constraints[r]), best->constraintViolations[i] });
+    }
+    for (size_t i = 0; i < best->bounds.size(); ++i) {
+        int v = best->bounds[i];
+        diagnosis.bounds.push_back({ vars[v], v, model.getName(vars[v]), (best->isLowerBounds[i] != 0), best->boundViolations[i] });
+    }
+    Log(LogSwitch::Szx::MpSolver) << "diagnose: method=" << bestMethod << " constraints=" << diagnosis.constraints.size()
+        << " bounds=" << diagnosis.bounds.size() << " conclusive=" << diagnosis.isConclusive << endl;
+    return true;
+}
+
+void InfeasibilityDiagnoser::runIis(const MpModelView &view, MpSolver &solver, Result &result) {
+    solver.load(view);
+    if (isRaceOver()) { return; }
+    List<int> lbs;
+    List<int> ubs;
+    if (!solver.computeIIS(MpSolver::IisMethod::FastIis, result.constraints, lbs, ubs, result.isConclusive)) { return; }
+    result.isFound = true;
+    result.constraintViolations.assign(result.constraints.size(), 0);
+    for (auto v = lbs.begin(); v != lbs.end(); ++v) {
+        result.bounds.push_back(*v);
+        result.isLowerBounds.push_back(true);
+    }
+    for (auto v = ubs.begin(); v != ubs.end(); ++v) {
+        result.bounds.push_back(*v);
+        result.isLowerBounds.push_back(false);
+    }
+    result.boundViolations.assign(result.bounds.size(), 0);
+}
+
+void InfeasibilityDiagnoser::runRelaxation(const MpModelView &view, MpSolver &solver, Result &result) {
+    int varNum = view.getVariableCount();
+    int rowNum = view.getConstraintCount();
+
+    // the bounds moved into the rows, where the domain of the fixed binaries is kept by changing them into integers.
+    List<int> boundVars;
+    List<char> isLowerBounds;
+    if (cfg.relaxBounds) {
+        for (int v = 0; v < varNum; ++v) {
+            double domainLb = (view.type[v] == MpSolver::VariableType::Bool) ? 0 : -MpSolver::Infinity;
+            double domainUb = (view.type[v] == MpSolver::VariableType::Bool) ? 1 : MpSolver::Infinity;
+            if (view.lb[v] > domainLb) {
+                boundVars.push_back(v);
+                isLowerBounds.push_back(true);
+            }
+            if (view.ub[v] < domainUb) {
+                boundVars.push_back(v);
+                isLowerBounds.push_back(false);
+            }
+        }
+    }
+
+    // a slack for each side which can be violated.
+    int slackNum = 0;
+    for (int r = 0; r < rowNum; ++r) { slackNum += (view.senses[r] == MpSolver::ConstraintSense::Equal) ? 2 : 1; }
+    int boundNum = static_cast<int>(boundVars.size());
+    int relaxedVarNum = varNum + slackNum + boundNum;
+    int relaxedRowNum = rowNum + boundNum;
+    int64_t relaxedNnz = view.getNonzeroCount() + slackNum + 2 * static_cast<int64_t>(boundNum);
+
+    MpModelData relaxedData;
+    MpModelView &relaxed(relaxedData.init(relaxedVarNum, relaxedRowNum, relaxedNnz));
+    relaxed.header->orientation = MpSolver::OptimaOrientation::Minimize;
+    for (int v = 0; v < varNum; ++v) {
+        relaxed.lb[v] = view.lb[v];
+        relaxed.ub[v] = view.ub[v];
+        relaxed.obj[v] = 0;
+        relaxed.type[v] = view.type[v];
+    }
+    for (int v = varNum; v < relaxedVarNum; ++v) {
+        relaxed.lb[v] = 0;
+        relaxed.ub[v] = MpSolver::Infinity;
+        relaxed.obj[v] = 1;
+        relaxed.type[v] = static_cast<char>(MpSolver::VariableType::Real);
+    }
+    for (int b = 0; b < boundNum; ++b) {
+        int v = boundVars[b];
+        bool isBool = (view.type[v] == MpSolver::VariableType::Bool);
+        relaxed.type[v] = isBool ? static_cast<char>(MpSolver::VariableType::Integer) : view.type[v];
+        if (isLowerBounds[b]) { relaxed.lb[v] = isBool ? 0 : -MpSolver::Infinity; } else { relaxed.ub[v] = isBool ? 1 : MpSolver::Infinity; }
+    }
+
+    // (a x - s <= b), (a x + s >= b) and (a x + s - s' = b).
+    List<int> rowSlacks(rowNum);
+    int64_t nnz = 0;
+    int slack = varNum;
+    for (int r = 0; r < rowNum; ++r) {
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i, ++nnz) {
+            relaxed.cols[nnz] = view.cols[i];
+            relaxed.coefs[nnz] = view.coefs[i];
+        }
+        rowSlacks[r] = slack;
+        if (view.senses[r] != MpSolver::ConstraintSense::LessEqual) {
+            relaxed.cols[nnz] = slack++;
+            relaxed.coefs[nnz++] = 1;
+        }
+        if (view.senses[r] != MpSolver::ConstraintSense::GreaterEqual) {
+            relaxed.cols[nnz] = slack++;
+            relaxed.coefs[nnz++] = -1;
+        }
+        relaxed.rowBegin[r + 1] = nnz;
+        relaxed.senses[r] = view.senses[r];
+        relaxed.rhs[r] = view.rhs[r];
+    }
+    // (x + s >= lb) and (x - s <= ub).
+    for (int b = 0; b < boundNum; ++b, ++slack) {
+        int v = boundVars[b];
+        int r = rowNum + b;
+        relaxed.cols[nnz] = v;
+        relaxed.coefs[nnz++] = 1;
+        relaxed.cols[nnz] = slack;
+        relaxed.coefs[nnz++] = isLowerBounds[b] ? 1 : -1;
+        relaxed.rowBegin[r + 1] = nnz;
+        relaxed.senses[r] = static_cast<char>(isLowerBounds[b] ? MpSolver::ConstraintSense::GreaterEqual : MpSolver::ConstraintSense::LessEqual);
+        relaxed.rhs[r] = isLowerBounds[b] ? view.lb[v] : view.ub[v];
+    }
+
+    solver.load(relaxed);
+    if (isRaceOver()) { return; }
+    solver.optimize();
+    solver.saveSolution(relaxed);
+    if (relaxed.header->solutionCount <= 0) { return; }
+    result.isConclusive = (relaxed.header->status == MpSolver::ResultStatus::Optimal);
+    result.totalViolation = relaxed.header->obj;
+
+    const double *values = relaxed.values;
+    for (int r = 0; r < rowNum; ++r) {
+        int nextSlack = (r + 1 < rowNum) ? rowSlacks[r + 1] : (varNum + slackNum);
+        double violation = 0;
+        for (int s = rowSlacks[r]; s < nextSlack; ++s) { violation += values[s]; }
+        if (violation <= cfg.violationTolerance) { continue; }
+        result.constraints.push_back(r);
+        result.constraintViolations.push_back(violation);
+    }
+    for (int b = 0; b < boundNum; ++b) {
+        double violation = values[varNum + slackNum + b];
+        if (violation <= cfg.violationTolerance) { continue; }
+        result.bounds.push_back(boundVars[b]);
+        result.isLowerBounds.push_back(isLowerBounds[b]);
+        result.boundViolations.push_back(violation);
+    }
+    result.isFound = (!result.constraints.empty() || !result.bounds.empty()); // nothing is violated if it is feasible.
+}
+
+bool InfeasibilityDiagnoser::isRaceOver() {
+    lock_guard<mutex> raceLock(raceMutex);
+    return isDecided;
+}
+
+void InfeasibilityDiagnoser::leave(Method method, const Result &result) {
+    lock_guard<mutex> raceLock(raceMutex);
+    if (isDecided || !result.isConclusive) { return; }
+    isDecided = true;
+    for (int m = 0; m < MethodNum; ++m) {
+        if (m != method) { engineTokens[m].cancel(); }
+    }
+}
+
+}
@@ -0,0 +1,138 @@
+////////////////////////////////
+/// usage : 1.	explain why a model is infeasible in seconds by racing two engines on separate threads:
+///             a fast IIS, and a feasibility relaxation which minimizes the total violation of the constraints
+///             (and optionally the bounds) with slack variables.
+///         2.	the conflicting constraints and bounds are returned in memory with their handles and names
+///             in the original model, instead of being written into a file.
+///
+/// note  : 1.	the first engine which finishes conclusively (a minimal IIS or an optimal relaxation) wins and
+///             stops the other, otherwise the best partial result at the time limit is returned.
+///         2.	the IIS tells a minimal set of conflicting constraints, while the relaxation tells a cheapest set
+///             of constraints to violate and by how much.
+///         3.	the engines work on their own copies of the model, so the original model is not touched.
+///         4.	only the linear models which are neither presolved nor scaled are diagnosed, since the engines work on
+///             the flat layout of the model in the original units.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_INFEASIBILITY_DIAGNOSER_H
+#define SMART_SZX_GATE_REASSIGNMENT_INFEASIBILITY_DIAGNOSER_H
+
+
+#include "Config.h"
+
+#include <mutex>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+#include "MpModelData.h"
+
+
+namespace szx {
+
+class InfeasibilityDiagnoser {
+    #pragma region Type
+public:
+    using DecisionVar = MpSolver::DecisionVar;
+    using Constraint = MpSolver::Constraint;
+
+    enum Method {
+        Iis,
+        FeasibilityRelaxation,
+        MethodNum
+    };
+
+    struct Configuration {
+        static constexpr double DefaultTimeoutInSecond = 30;
+        static constexpr double DefaultViolationTolerance = 1e-6;
+
+        Configuration(double timeoutInSec = DefaultTimeoutInSecond)
+            : timeoutInSecond(timeoutInSec), relaxBounds(true), violationTolerance(DefaultViolationTolerance) {
+            enabled[Method::Iis] = true;
+            enabled[Method::FeasibilityRelaxation] = true;
+        }
+
+        double timeoutInSecond;
+        bool enabled[MethodNum];
+        bool relaxBounds; // allow the relaxation to violate the variable bounds.
+        double violationTolerance; // the slacks under it are not reported.
+    };
+
+    struct ConstraintConflict {
+        Constraint constraint;
+        int index;
+        String name;
+        double violation; // always 0 in an IIS.
+    };
+
+    struct BoundConflict {
+        DecisionVar var;
+        int index;
+        String name;
+        bool isLowerBound;
+        double violation; // always 0 in an IIS.
+    };
+
+    struct Diagnosis {
+        Method method = Method::Iis;
+        bool isConclusive = false; // the IIS is minimal or the total violation is optimal.
+        double totalViolation = 0;
+        double elapsedSeconds = 0;
+        List<ConstraintConflict> constraints;
+        List<BoundConflict> bounds;
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    InfeasibilityDiagnoser(const Configuration &config = Configuration()) : cfg(config), pool(MethodNum) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// returns false if no conflict is found, e.g., the model is feasible, not linear, reduced or the time limit is too short.
+    /// the engines are stopped once the token is cancelled and never run beyond its deadline.
+    bool diagnose(MpSolver &model, Diagnosis &diagnosis, const CancellationToken &cancellation = CancellationToken());
+
+protected:
+    // the results are in indices of the flat model, which are mapped to the handles by diagnose().
+    struct Result {
+        bool isFound = false;
+        bool isConclusive = false;
+        double totalViolation = 0;
+        double elapsedSeconds = 0;
+        List<int> constraints;
+        List<double> constraintViolations;
+        List<int> bounds;
+        List<char> isLowerBounds;
+        List<double> boundViolations;
+    };
+
+    void runIis(const MpModelView &view, MpSolver &solver, Result &result);
+    void runRelaxation(const MpModelView &view, MpSolver &solver, Result &result);
+
+    // the engines check it after the setup to skip the solve, while the solve in progress is stopped by the token.
+    bool isRaceOver();
+    // record the result and cancel the token of the other engine if it is conclusive.
+    void leave(Method method, const Result &result);
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    ThreadPool pool;
+
+    std::mutex raceMutex;
+    // each engine binds its token to the solver before the setup, so that the cancellation is never missed
+    // even if it comes before the solve starts, which terminate() does not guarantee.
+    CancellationToken engineTokens[MethodNum];
+    bool isDecided;
+    #pragma endregion Field
+}; // InfeasibilityDiagnoser
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_INFEASIBILITY_DIAGNOSER_H
@@ -0,0 +1,241 @@
+#include "LagrangianRelaxation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+void LagrangianRelaxation::optimize(const CancellationToken &cancellation) {
+    CancellationToken token(cancellation.createChild());
+    token.setDeadlineInSecond(cfg.timeoutInSecond);
+    int couplingNum = getCouplingCount();
+
+    List<double> multipliers(couplingNum, 0);
+    List<double> subgradient;
+    double bound = evaluate(multipliers, subgradient, token);
+    if (bound == -MpSolver::Infinity) { return; }
+    stat.lowerBound = bound;
+    bestMultipliers = multipliers;
+    tryUpdateUpperBound(subgradient);
+
+    // the cutting plane model of the dual function for bundle steps.
+    unique_ptr<MpSolver> bundle;
+    List<DecisionVar> bundleMultipliers;
+    DecisionVar bundleValue;
+    List<double> center(multipliers);
+    double centerBound = bound;
+    double radius = cfg.trustRadius;
+    if (cfg.update == MultiplierUpdate::Bundle) {
+        bundle.reset(new MpSolver());
+        for (int k = 0; k < couplingNum; ++k) {
+            bundleMultipliers.push_back(bundle->addVar(MpSolver::VariableType::Real, -MpSolver::Infinity, MpSolver::Infinity));
+        }
+        bundleValue = bundle->addVar(MpSolver::VariableType::Real, -MpSolver::Infinity, MpSolver::Infinity);
+        bundle->addObjective(bundleValue, MpSolver::OptimaOrientation::Maximize);
+    }
+
+    int stallNum = 0;
+    double stepScale = cfg.stepScale;
+    for (stat.iterationNum = 1; stat.iterationNum < cfg.maxIterationNum; ++stat.iterationNum) {
+        if (token.isCancelled()) { break; }
+        if (stat.upperBound - stat.lowerBound <= cfg.gapTolerance * (max)(1.0, abs(stat.upperBound))) { break; }
+
+        double predictedBound = MpSolver::Infinity;
+        if (cfg.update == MultiplierUpdate::Subgradient) {
+            multipliers = subgradientStep(multipliers, subgradient, bound, stepScale);
+            if (multipliers.empty()) { break; } // the subgradient vanishes so the multipliers are optimal.
+        } else {
+            // v <= f(l_j) + g_j * (l - l_j).
+            LinearExpr cut = bundleValue;
+            double rhs = bound;
+            for (int k = 0; k < couplingNum; ++k) {
+                if (subgradient[k] == 0) { continue; }
+                cut -= subgradient[k] * bundleMultipliers[k];
+                rhs -= subgradient[k] * multipliers[k];
+            }
+            bundle->addConstraint(cut <= rhs);
+
+            // maximize the cutting plane model in the box around the stability center.
+            for (int k = 0; k < couplingNum; ++k) {
+                double lb = (senses[k] == LessEqual) ? 0 : -MpSolver::Infinity;
+                double ub = (senses[k] == GreaterEqual) ? 0 : MpSolver::Infinity;
+                bundle->setBounds(bundleMultipliers[k], (max)(lb, center[k] - radius), (min)(ub, center[k] + radius));
+            }
+            if (!bundle->optimize() || (bundle->getStatus() != MpSolver::ResultStatus::Optimal)) { break; }
+            predictedBound = bundle->getObjectiveValue();
+            if (predictedBound - centerBound <= cfg.gapTolerance * (max)(1.0, abs(centerBound))) { break; }
+            for (int k = 0; k < couplingNum; ++k) { multipliers[k] = bundle->getValue(bundleMultipliers[k]); }
+            project(multipliers);
+        }
+
+        bound = evaluate(multipliers, subgradient, token);
+        if (bound == -MpSolver::Infinity) { break; }
+        tryUpdateUpperBound(subgradient);
+        Log(LogSwitch::Szx::MpSolver) << "lr[" << stat.iterationNum << "]: bound=" << bound
+            << " lb=" << stat.lowerBound << " ub=" << stat.upperBound << endl;
+
+        if (bound > stat.lowerBound) {
+            stat.lowerBound = bound;
+            bestMultipliers = multipliers;
+            stallNum = 0;
+        } else if (++stallNum >= cfg.stepHalvingInterval) {
+            stallNum = 0;
+            stepScale /= 2;
+            if ((cfg.update == MultiplierUpdate::Subgradient) && (stepScale < cfg.minStepScale)) { break; }
+        }
+
+        if (cfg.update == MultiplierUpdate::Bundle) {
+            // serious step moves the center, otherwise the cut only enriches the model (null step).
+            double predictedImprovement = predictedBound - centerBound;
+            if (bound - centerBound >= cfg.seriousStepRatio * predictedImprovement) {
+                if (bound - centerBound >= 0.5 * predictedImprovement) { radius *= 2; }
+                center = multipliers;
+                centerBound = bound;
+            } else {
+                radius /= 2;
+            }
+        }
+    }
+}
+
+double LagrangianRelaxation::evaluate(const List<double> &multipliers, List<double> &subgradient, const CancellationToken &token) {
+    int couplingNum = getCouplingCount();
+    blockBounds.assign(blockNum, -MpSolver::Infinity);
+    blockObjs.assign(blockNum, 0);
+    blockActivities.assign(blockNum, List<double>(couplingNum, 0));
+    relaxedSolution.resize(blockNum);
+
+    double timeLimit = (min)(cfg.blockTimeoutInSecond, token.restSeconds(cfg.blockTimeoutInSecond));
+    int threadNum = pool.size();
+    pool.broadcast([&](int threadIndex) {
+        for (int b = threadIndex; b < blockNum; b += threadNum) { solveBlock(b, multipliers, timeLimit, token); }
+    });
+
+    // L(l) = sum(min{f_b(x_b) + l * A_b x_b}) - l * rhs.
+    double bound = 0;
+    subgradient.resize(couplingNum);
+    for (int k = 0; k < couplingNum; ++k) {
+        bound -= multipliers[k] * rhs_[k];
+        subgradient[k] = -rhs_[k];
+    }
+    for (int b = 0; b < blockNum; ++b) {
+        if (blockBounds[b] == -MpSolver::Infinity) { return -MpSolver::Infinity; }
+        bound += blockBounds[b];
+        for (int k = 0; k < couplingNum; ++k) { subgradient[k] += blockActivities[b][k]; }
+    }
+    return bound;
+}
+
+void LagrangianRelaxation::solveBlock(int block, const List<double> &multipliers, double timeLimitInSecond, const CancellationToken &token) {
+    unique_ptr<Block> &b(blocks[block]);
+    if (!b) {
+        b.reset(new Block());
+        build(block, *b);
+    }
+
+    LinearExpr obj = b->objective;
+    for (size_t i = 0; i < b->couplingVars.size(); ++i) {
+        double coef = multipliers[b->couplingIndices[i]] * b->couplingCoefs[i];
+        if (coef != 0) { obj += coef * b->couplingVars[i]; }
+    }
+    b->model.clearObjectives();
+    b->model.addObjective(obj, MpSolver::OptimaOrientation::Minimize);
+    b->model.setTimeLimitInSecond(timeLimitInSecond);
+    b->model.setCancellationToken(token);
+    b->model.optimize();
+
+    MpSolver::ResultStatus status = b->model.getStatus();
+    if ((status != MpSolver::ResultStatus::Optimal) && (status != MpSolver::ResultStatus::Feasible)) { return; }
+    // the best bound of a MIP keeps the Lagrangian bound valid on early termination,
+    // while an LP stopped early has no dual bound, so it gives no Lagrangian bound in this iteration.
+    if ((status == MpSolver::ResultStatus::Optimal) || b->model.isMip()) { blockBounds[block] = b->model.getBestBound(); }
+    blockObjs[block] = b->model.getValue(b->objective);
+    List<double> &activities(blockActivities[block]);
+    for (size_t i = 0; i < b->couplingVars.size(); ++i) {
+        activities[b->couplingIndices[i]] += b->couplingCoefs[i] * b->model.getValue(b->couplingVars[i]);
+    }
+    List<double> &values(relaxedSolution[block]);
+    values.resize(b->vars.size());
+    for (size_t i = 0; i < b->vars.size(); ++i) { values[i] = b->model.getValue(b->vars[i]); }
+}
+
+void LagrangianRelaxation::tryUpdateUpperBound(const List<double> &subgradient) {
+    bool isFeasible = true;
+    for (int k = 0; isFeasible && (k < getCouplingCount()); ++k) {
+        double tolerance = cfg.gapTolerance * (max)(1.0, abs(rhs_[k]));
+        if (senses[k] == LessEqual) {
+            isFeasible = (subgradient[k] <= tolerance);
+        } else if (senses[k] == GreaterEqual) {
+            isFeasible = (subgradient[k] >= -tolerance);
+        } else {
+            isFeasible = (abs(subgradient[k]) <= tolerance);
+        }
+    }
+
+    double obj = 0;
+    if (isFeasible) {
+        for (int b = 0; b < blockNum; ++b) { obj += blockObjs[b]; }
+        if (obj < stat.upperBound) {
+            stat.upperBound = obj;
+            bestSolution = relaxedSolution;
+        }
+    } else if (repair) {
+        Solution solution(relaxedSolution);
+        if (repair(solution, obj) && (obj < stat.upperBound)) {
+            stat.upperBound = obj;
+            bestSolution.swap(solution);
+        }
+    }
+}
+
+List<double> LagrangianRelaxation::subgradientStep(const List<double> &multipliers, const List<double> &subgradient,
+    double bound, double stepScale) {
+    // the components which would leave the feasible sign region do not contribute to the direction.
+    List<double> direction(subgradient);
+    for (int k = 0; k < getCouplingCount(); ++k) {
+        if (((senses[k] == LessEqual) && (multipliers[k] <= 0) && (direction[k] < 0))
+            || ((senses[k] == GreaterEqual) && (multipliers[k] >= 0) && (direction[k] > 0))) {
+            direction[k] = 0;
+        }
+    }
+    double squaredNorm = 0;
+    for (auto d = direction.begin(); d != direction.end(); ++d) { squaredNorm += (*d) * (*d); }
+    if (squaredNorm == 0) { return List<double>(); }
+
+    // Polyak step towards the upper bound, or an estimated target before any feasible solution is found.
+    double target = (stat.upperBound < MpSolver::Infinity)
+        ? stat.upperBound : (stat.lowerBound + cfg.targetRatio * (max)(1.0, abs(stat.lowerBound)));
+    double step = stepScale * (max)(target - bound, 0.0) / squaredNorm;
+    if (step == 0) { return List<double>(); }
+
+    List<double> next(multipliers);
+    for (int k = 0; k < getCouplingCount(); ++k) { next[k] += step * direction[k]; }
+    project(next);
+    return next;
+}
+
+void LagrangianRelaxation::project(List<double> &multipliers) const {
+    for (int k = 0; k < getCouplingCount(); ++k) {
+        if (senses[k] == LessEqual) {
+            multipliers[k] = (max)(multipliers[k], 0.0);
+        } else if (senses[k] == GreaterEqual) {
+            multipliers[k] = (min)(multipliers[k], 0.0);
+        }
+    }
+}
+
+void LagrangianRelaxation::releaseBlocks() {
+    // the models must be freed before the environments of the worker threads.
+    int threadNum = pool.size();
+    pool.broadcast([&](int threadIndex) {
+        for (int b = threadIndex; b < blockNum; b += threadNum) { blocks[b].reset(); }
+    });
+}
+
+}
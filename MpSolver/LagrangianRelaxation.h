@@ -0,0 +1,187 @@
+////////////////////////////////
+/// usage : 1.	bound a block-angular minimization model by dualizing its coupling constraints into the objective.
+///         2.	the blocks are built and solved in parallel on worker threads with their own solver environments.
+///         3.	the multipliers are updated by subgradient steps or trust-region bundle steps.
+///
+/// note  : 1.	the lower bound is valid even if a MIP block is stopped early, since its best bound (ObjBound) is used.
+///             an LP block which is not solved to optimality has no dual bound, so the lower bound is not updated by
+///             the iteration where it is stopped early by the time limit or the cancellation.
+///         2.	the upper bound comes from the relaxed solutions which happen to satisfy the coupling constraints,
+///             or from the repair heuristic of the user.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_LAGRANGIAN_RELAXATION_H
+#define SMART_SZX_GATE_REASSIGNMENT_LAGRANGIAN_RELAXATION_H
+
+
+#include "Config.h"
+
+#include <functional>
+#include <memory>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+
+
+namespace szx {
+
+class LagrangianRelaxation {
+    #pragma region Constant
+public:
+    static constexpr char LessEqual = GRB_LESS_EQUAL;
+    static constexpr char GreaterEqual = GRB_GREATER_EQUAL;
+    static constexpr char Equal = GRB_EQUAL;
+    #pragma endregion Constant
+
+    #pragma region Type
+public:
+    using DecisionVar = MpSolver::DecisionVar;
+    using LinearExpr = MpSolver::LinearExpr;
+
+    enum MultiplierUpdate { Subgradient, Bundle };
+
+    struct Configuration {
+        static constexpr int DefaultMaxIterationNum = 200;
+        static constexpr double DefaultStepScale = 2;
+        static constexpr int DefaultStepHalvingInterval = 10; // halve the step scale if the bound does not improve in the iterations.
+        static constexpr double DefaultMinStepScale = 1e-4;
+        static constexpr double DefaultTargetRatio = 0.05; // the relative distance of the step target above the lower bound without upper bound.
+        static constexpr double DefaultTrustRadius = 1;
+        static constexpr double DefaultSeriousStepRatio = 0.1; // the ratio of the predicted improvement to accept a bundle step.
+        static constexpr double DefaultGapTolerance = 1e-6;
+        static constexpr double DefaultBlockTimeoutInSecond = MpSolver::Configuration::Forever;
+
+        Configuration(int threads = ThreadPool::getHardwareConcurrency(), MultiplierUpdate updateMethod = MultiplierUpdate::Subgradient,
+            double timeoutInSec = MpSolver::Configuration::Forever)
+            : threadNum(threads), update(updateMethod), timeoutInSecond(timeoutInSec), maxIterationNum(DefaultMaxIterationNum),
+            stepScale(DefaultStepScale), stepHalvingInterval(DefaultStepHalvingInterval), minStepScale(DefaultMinStepScale),
+            targetRatio(DefaultTargetRatio), trustRadius(DefaultTrustRadius), seriousStepRatio(DefaultSeriousStepRatio), gapTolerance(DefaultGapTolerance),
+            blockTimeoutInSecond(DefaultBlockTimeoutInSecond) {}
+
+        int threadNum;
+        MultiplierUpdate update;
+        double timeoutInSecond;
+        int maxIterationNum;
+
+        // subgradient.
+        double stepScale;
+        int stepHalvingInterval;
+        double minStepScale;
+        double targetRatio;
+
+        // bundle.
+        double trustRadius; // the initial half width of the box around the stability center.
+        double seriousStepRatio;
+
+        double gapTolerance;
+        double blockTimeoutInSecond;
+    };
+
+    // a block of the original model which is independent of the others except for the coupling constraints.
+    struct Block {
+        void addCouplingTerm(int couplingIndex, const DecisionVar &var, double coef) {
+            couplingIndices.push_back(couplingIndex);
+            couplingVars.push_back(var);
+            couplingCoefs.push_back(coef);
+        }
+
+        MpSolver model;
+        LinearExpr objective; // the part of the original objective (to minimize) on this block.
+        List<DecisionVar> vars; // the variables to report in the solutions.
+
+        List<int> couplingIndices;
+        List<DecisionVar> couplingVars;
+        List<double> couplingCoefs;
+    };
+
+    // build the block in b.model, set its objective and register its terms in the coupling constraints.
+    using BuildBlock = std::function<void(int block, Block &b)>;
+
+    // blockValues[b][i] is the value of the i_th reported variable in block b.
+    using Solution = List<List<double>>;
+    // make the relaxed solution feasible for the original model in place and set its objective value.
+    // returns true if it succeeds.
+    using Repair = std::function<bool(Solution &solution, double &obj)>;
+
+    struct Statistics {
+        int iterationNum = 0;
+        double lowerBound = -MpSolver::Infinity;
+        double upperBound = MpSolver::Infinity;
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    LagrangianRelaxation(int blockCount, BuildBlock buildBlock, const Configuration &config = Configuration(), Repair repairSolution = Repair())
+        : cfg(config), blockNum(blockCount), build(buildBlock), repair(repairSolution), pool(config.threadNum), blocks(blockCount) {}
+    ~LagrangianRelaxation() { releaseBlocks(); }
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// mark a coupling constraint (sum of the coupling terms in all blocks) (sense) rhs, which will be dualized.
+    /// returns its index.
+    int addCouplingConstraint(char sense, double rhs) {
+        senses.push_back(sense);
+        rhs_.push_back(rhs);
+        return static_cast<int>(senses.size()) - 1;
+    }
+
+    /// maximize the Lagrangian dual.
+    /// the block solves are stopped once the token is cancelled and never run beyond its deadline.
+    void optimize(const CancellationToken &cancellation = CancellationToken());
+
+    double getLowerBound() const { return stat.lowerBound; }
+    double getUpperBound() const { return stat.upperBound; }
+    bool hasFeasibleSolution() const { return !bestSolution.empty(); }
+    const Solution& getBestSolution() const { return bestSolution; }
+    const List<double>& getMultipliers() const { return bestMultipliers; }
+    const Statistics& getStatistics() const { return stat; }
+
+protected:
+    /// solve all blocks with the given multipliers. returns the Lagrangian bound and sets the subgradient.
+    double evaluate(const List<double> &multipliers, List<double> &subgradient, const CancellationToken &token);
+    void solveBlock(int block, const List<double> &multipliers, double timeLimitInSecond, const CancellationToken &token);
+    void tryUpdateUpperBound(const List<double> &subgradient);
+
+    // returns empty list if the multipliers can not move.
+    List<double> subgradientStep(const List<double> &multipliers, const List<double> &subgradient, double bound, double stepScale);
+    // project the multipliers onto the sign constraints.
+    void project(List<double> &multipliers) const;
+
+    void releaseBlocks();
+
+    int getCouplingCount() const { return static_cast<int>(senses.size()); }
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    int blockNum;
+    BuildBlock build;
+    Repair repair;
+
+    List<char> senses;
+    List<double> rhs_;
+
+    ThreadPool pool;
+    List<std::unique_ptr<Block>> blocks;
+    // the results of each block in the last evaluation.
+    List<double> blockBounds;
+    List<double> blockObjs; // the original objective value of the relaxed solution.
+    List<List<double>> blockActivities; // blockActivities[b][k] is the activity of block b in coupling constraint k.
+    Solution relaxedSolution;
+
+    Solution bestSolution;
+    List<double> bestMultipliers;
+    Statistics stat;
+    #pragma endregion Field
+}; // LagrangianRelaxation
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_LAGRANGIAN_RELAXATION_H
@@ -0,0 +1,269 @@
+#include "LargeNeighborhoodSearch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+LargeNeighborhoodSearch::LargeNeighborhoodSearch(BuildModel buildModel, const Configuration &config)
+    : cfg(config), build(buildModel), pool(config.threadNum), instances(pool.size()), orientation(MpSolver::OptimaOrientation::Minimize),
+    varNum(0), incumbentObj(0), sizeRatios(NeighborhoodKindNum, config.initialSizeRatio), scores(NeighborhoodKindNum, 1), iterationNum(0) {}
+
+bool LargeNeighborhoodSearch::optimize(const CancellationToken &cancellation) {
+    CancellationToken token(cancellation.createChild());
+    token.setDeadlineInSecond(cfg.timeoutInSecond);
+
+    pool.broadcast([&](int threadIndex) {
+        unique_ptr<Instance> &ins(instances[threadIndex]);
+        if (ins) { return; }
+        ins.reset(new Instance());
+        build(threadIndex, *ins);
+        ins->model.addObjective(ins->objective, ins->orientation);
+        ins->model.updateModel();
+    });
+    // every solve of the workers is clamped to the deadline and stopped on cancellation by the token.
+    pool.broadcast([&](int threadIndex) { instances[threadIndex]->model.setCancellationToken(token); });
+
+    bool hasInitialSolution = hasSolution();
+    pool.broadcast([&](int threadIndex) {
+        if (threadIndex != 0) { return; }
+        extractStructure(*instances[threadIndex]);
+        if (!hasInitialSolution) { solveInitial(*instances[threadIndex]); }
+    });
+    if (!hasSolution()) { return false; }
+    if (hasInitialSolution) {
+        incumbentObj = instances[0]->objective.getConstant();
+        for (int v = 0; v < varNum; ++v) { incumbentObj += objCoefs[v] * incumbent[v]; }
+    }
+    Log(LogSwitch::Szx::MpSolver) << "lns: initial obj=" << incumbentObj << endl;
+
+    iterationNum = 0;
+    pool.broadcast([&](int threadIndex) { search(threadIndex, token); });
+
+    Log(LogSwitch::Szx::MpSolver) << "lns: iteration=" << stat.iterationNum << " improvement=" << stat.improvementNum
+        << " obj=" << incumbentObj << endl;
+    return true;
+}
+
+void LargeNeighborhoodSearch::extractStructure(Instance &instance) {
+    MpSolver &model(instance.model);
+    orientation = instance.orientation;
+
+    Arr<DecisionVar> vars(model.getAllVars());
+    varNum = vars.size();
+    isInteger.assign(varNum, false);
+    lbs.resize(varNum);
+    ubs.resize(varNum);
+    integerVars.clear();
+    for (int v = 0; v < varNum; ++v) {
+        lbs[v] = model.getLowerBound(vars[v]);
+        ubs[v] = model.getUpperBound(vars[v]);
+        if (model.getType(vars[v]) == MpSolver::VariableType::Real) { continue; }
+        isInteger[v] = true;
+        integerVars.push_back(v);
+    }
+
+    objCoefs.assign(varNum, 0);
+    for (unsigned i = 0; i < instance.objective.size(); ++i) {
+        objCoefs[instance.objective.getVar(i).index()] += instance.objective.getCoeff(i);
+    }
+    objVars.clear();
+    for (auto v = integerVars.begin(); v != integerVars.end(); ++v) {
+        if (objCoefs[*v] != 0) { objVars.push_back(*v); }
+    }
+
+    rows = model.getMatrix();
+    cols = rows.toLayout(SparseMatrix::Layout::ColumnMajor);
+}
+
+bool LargeNeighborhoodSearch::solveInitial(Instance &instance) {
+    instance.model.setTimeLimitInSecond(cfg.initialTimeoutInSecond);
+    instance.model.optimize();
+    if (instance.model.getSolutionCount() <= 0) { return false; }
+
+    Arr<DecisionVar> vars(instance.model.getAllVars());
+    incumbent.resize(varNum);
+    for (int v = 0; v < varNum; ++v) { incumbent[v] = instance.model.getValue(vars[v]); }
+    incumbentObj = instance.model.getObjectiveValue();
+    return true;
+}
+
+void LargeNeighborhoodSearch::search(int worker, const CancellationToken &cancellation) {
+    MpSolver &model(instances[worker]->model);
+    Random rand(cfg.seed, worker);
+    Arr<DecisionVar> vars(model.getAllVars());
+    int integerVarNum = static_cast<int>(integerVars.size());
+    if (integerVarNum <= 0) { return; }
+
+    // the bounds and starts applied to the model of this worker, so that only the differences are updated.
+    List<char> isFixed(varNum, false);
+    List<double> fixedValues(varNum, 0);
+    List<double> startValues(varNum, numeric_limits<double>::quiet_NaN());
+
+    List<char> isFree(varNum);
+    List<double> values;
+    double obj;
+    while (!cancellation.isCancelled() && (iterationNum++ < cfg.maxIterationNum)) {
+        Neighborhood kind;
+        double sizeRatio;
+        {
+            lock_guard<mutex> l(incumbentMutex);
+            values = incumbent;
+            obj = incumbentObj;
+            kind = selectNeighborhood(rand);
+            sizeRatio = sizeRatios[kind];
+            ++stat.selectionNums[kind];
+        }
+
+        int freeNum = static_cast<int>(sizeRatio * integerVarNum);
+        freeNum = (min)((max)(freeNum, cfg.minFreeVarNum), integerVarNum);
+        fill(isFree.begin(), isFree.end(), false);
+        if (kind == Neighborhood::RandomVars) {
+            pickRandomVars(rand, freeNum, isFree);
+        } else {
+            pickConnectedVars(rand, freeNum, (kind == Neighborhood::ObjectiveGuided), values, isFree);
+        }
+
+        for (auto v = integerVars.begin(); v != integerVars.end(); ++v) {
+            double value = round(values[*v]);
+            if (isFree[*v]) {
+                if (isFixed[*v]) {
+                    model.setBounds(vars[*v], lbs[*v], ubs[*v]);
+                    isFixed[*v] = false;
+                }
+            } else if (!isFixed[*v] || (fixedValues[*v] != value)) {
+                model.setBounds(vars[*v], value, value);
+                isFixed[*v] = true;
+                fixedValues[*v] = value;
+            }
+            if (startValues[*v] != value) {
+                model.setInitValue(vars[*v], value);
+                startValues[*v] = value;
+            }
+        }
+
+        model.setTimeLimitInSecond(cfg.subTimeoutInSecond);
+        model.optimize();
+        MpSolver::ResultStatus status = model.getStatus();
+
+        bool isImproved = false;
+        if ((model.getSolutionCount() > 0) && isBetter(model.getObjectiveValue(), obj)) {
+            isImproved = true;
+            double subObj = model.getObjectiveValue();
+            List<double> subValues(varNum);
+            for (int v = 0; v < varNum; ++v) { subValues[v] = model.getValue(vars[v]); }
+
+            lock_guard<mutex> l(incumbentMutex);
+            if (isBetter(subObj, incumbentObj)) {
+                incumbent.swap(subValues);
+                incumbentObj = subObj;
+                ++stat.improvementNum;
+                ++stat.improvementNums[kind];
+                Log(LogSwitch::Szx::MpSolver) << "lns[" << worker << "]: obj=" << incumbentObj << " free=" << freeNum << endl;
+            }
+        }
+        adapt(kind, isImproved, (status == MpSolver::ResultStatus::Optimal));
+    }
+}
+
+LargeNeighborhoodSearch::Neighborhood LargeNeighborhoodSearch::selectNeighborhood(Random &rand) {
+    double total = 0;
+    for (int k = 0; k < NeighborhoodKindNum; ++k) {
+        if ((k == Neighborhood::ObjectiveGuided) && objVars.empty()) { continue; }
+        total += scores[k];
+    }
+
+    double r = total * rand.uniform();
+    for (int k = 0; k < NeighborhoodKindNum; ++k) {
+        if ((k == Neighborhood::ObjectiveGuided) && objVars.empty()) { continue; }
+        if ((r -= scores[k]) < 0) { return static_cast<Neighborhood>(k); }
+    }
+    return Neighborhood::RandomVars;
+}
+
+int LargeNeighborhoodSearch::pickRandomVars(Random &rand, int freeNum, List<char> &isFree) const {
+    // partial Fisher-Yates shuffle for large neighborhoods, or rejection sampling for small ones.
+    int integerVarNum = static_cast<int>(integerVars.size());
+    if (freeNum * 2 > integerVarNum) {
+        List<int> candidates(integerVars);
+        for (int i = 0; i < freeNum; ++i) {
+            swap(candidates[i], candidates[rand.pick(i, integerVarNum)]);
+            isFree[candidates[i]] = true;
+        }
+        return freeNum;
+    }
+    for (int picked = 0; picked < freeNum;) {
+        int v = integerVars[rand.pick(integerVarNum)];
+        if (isFree[v]) { continue; }
+        isFree[v] = true;
+        ++picked;
+    }
+    return freeNum;
+}
+
+int LargeNeighborhoodSearch::pickConnectedVars(Random &rand, int freeNum, bool isObjectiveGuided,
+    const List<double> &values, List<char> &isFree) const {
+    // the larger contribution means the worse objective.
+    double direction = (orientation == MpSolver::OptimaOrientation::Minimize) ? 1 : -1;
+    auto contribution = [&](int v) { return direction * objCoefs[v] * values[v]; };
+
+    int picked = 0;
+    int failedSeedNum = 0;
+    List<int> queue;
+    queue.reserve(freeNum);
+    while ((picked < freeNum) && (failedSeedNum < freeNum)) {
+        int seed;
+        if (isObjectiveGuided) { // binary tournament on the objective contribution.
+            int v1 = objVars[rand.pick(static_cast<int>(objVars.size()))];
+            int v2 = objVars[rand.pick(static_cast<int>(objVars.size()))];
+            seed = (contribution(v1) >= contribution(v2)) ? v1 : v2;
+        } else {
+            seed = integerVars[rand.pick(static_cast<int>(integerVars.size()))];
+        }
+        if (isFree[seed]) { ++failedSeedNum; continue; }
+
+        // breadth first expansion through the shared constraints.
+        queue.clear();
+        queue.push_back(seed);
+        isFree[seed] = true;
+        ++picked;
+        for (size_t head = 0; (head < queue.size()) && (picked < freeNum); ++head) {
+            int v = queue[head];
+            for (int64_t c = cols.begins[v]; (c < cols.begins[v + 1]) && (picked < freeNum); ++c) {
+                int r = cols.indices[c];
+                for (int64_t i = rows.begins[r]; (i < rows.begins[r + 1]) && (picked < freeNum); ++i) {
+                    int u = rows.indices[i];
+                    if (!isInteger[u] || isFree[u]) { continue; }
+                    isFree[u] = true;
+                    queue.push_back(u);
+                    ++picked;
+                }
+            }
+        }
+    }
+    return picked;
+}
+
+void LargeNeighborhoodSearch::adapt(Neighborhood kind, bool isImproved, bool isProvenOptimal) {
+    lock_guard<mutex> l(incumbentMutex);
+    ++stat.iterationNum;
+    scores[kind] = (max)(cfg.minScore, cfg.scoreDecay * scores[kind] + (1 - cfg.scoreDecay) * (isImproved ? 1 : 0));
+    if (isImproved) { return; }
+    // a neighborhood solved to optimality without improvement is too small, and a timed out one is too large.
+    double &ratio(sizeRatios[kind]);
+    ratio *= (isProvenOptimal ? cfg.growthRatio : cfg.shrinkRatio);
+    ratio = (min)((max)(ratio, cfg.minSizeRatio), cfg.maxSizeRatio);
+}
+
+void LargeNeighborhoodSearch::releaseInstances() {
+    // the models must be freed before the environments of the worker threads.
+    pool.broadcast([&](int threadIndex) { instances[threadIndex].reset(); });
+}
+
+}
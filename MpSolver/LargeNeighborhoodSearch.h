@@ -0,0 +1,184 @@
+////////////////////////////////
+/// usage : 1.	improve the incumbent of a MIP by repeatedly fixing most integer variables to their incumbent values
+///             and re-optimizing the neighborhood formed by the rest.
+///         2.	each worker thread owns a copy of the model built in its own solver environment and solves
+///             neighborhoods concurrently, improvements are merged into the shared incumbent.
+///         3.	the neighborhood kind is selected adaptively by its recent success, and the neighborhood size
+///             grows if the sub-MIP is solved to optimality without improvement and shrinks if it times out.
+///
+/// note  : 1.	every copy of the model must be built identically so that the variables match by index.
+///         2.	only the bounds of the integer variables are changed, and only if they differ from the last
+///             neighborhood solved by the same worker.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_LARGE_NEIGHBORHOOD_SEARCH_H
+#define SMART_SZX_GATE_REASSIGNMENT_LARGE_NEIGHBORHOOD_SEARCH_H
+
+
+#include "Config.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+
+
+namespace szx {
+
+class LargeNeighborhoodSearch {
+    #pragma region Type
+public:
+    using DecisionVar = MpSolver::DecisionVar;
+    using LinearExpr = MpSolver::LinearExpr;
+
+    enum Neighborhood {
+        RandomVars, // uniformly random integer variables.
+        ConstraintBlock, // integer variables connected by constraints to a random seed.
+        ObjectiveGuided, // integer variables connected to the seeds with the worst objective contribution.
+        NeighborhoodKindNum
+    };
+
+    struct Configuration {
+        static constexpr int DefaultMaxIterationNum = (std::numeric_limits<int>::max)();
+        static constexpr double DefaultSubTimeoutInSecond = 10;
+        static constexpr double DefaultInitialTimeoutInSecond = 60;
+        static constexpr double DefaultInitialSizeRatio = 0.1;
+        static constexpr double DefaultMinSizeRatio = 0.001;
+        static constexpr double DefaultMaxSizeRatio = 0.6;
+        static constexpr int DefaultMinFreeVarNum = 8;
+        static constexpr double DefaultGrowthRatio = 1.25;
+        static constexpr double DefaultShrinkRatio = 0.8;
+        static constexpr double DefaultScoreDecay = 0.8;
+        static constexpr double DefaultMinScore = 0.05;
+        static constexpr double DefaultImprovementTolerance = 1e-6;
+
+        Configuration(int threads = ThreadPool::getHardwareConcurrency(), double timeoutInSec = MpSolver::Configuration::Forever,
+            int randSeed = Random::generateSeed())
+            : threadNum(threads), timeoutInSecond(timeoutInSec), seed(randSeed), maxIterationNum(DefaultMaxIterationNum),
+            subTimeoutInSecond(DefaultSubTimeoutInSecond), initialTimeoutInSecond(DefaultInitialTimeoutInSecond),
+            initialSizeRatio(DefaultInitialSizeRatio), minSizeRatio(DefaultMinSizeRatio), maxSizeRatio(DefaultMaxSizeRatio),
+            minFreeVarNum(DefaultMinFreeVarNum), growthRatio(DefaultGrowthRatio), shrinkRatio(DefaultShrinkRatio),
+            scoreDecay(DefaultScoreDecay), minScore(DefaultMinScore), improvementTolerance(DefaultImprovementTolerance) {}
+
+        int threadNum;
+        double timeoutInSecond;
+        int seed; // the worker t uses the t_th independent stream of the seed.
+        int maxIterationNum; // the total number of neighborhoods solved by all workers.
+
+        double subTimeoutInSecond; // the time limit for each neighborhood.
+        double initialTimeoutInSecond; // the time limit for finding the initial solution if it is not provided.
+
+        // the neighborhood size is the ratio of free integer variables.
+        double initialSizeRatio;
+        double minSizeRatio;
+        double maxSizeRatio;
+        int minFreeVarNum;
+        double growthRatio;
+        double shrinkRatio;
+
+        // score = decay * score + (1 - decay) * (is improved).
+        double scoreDecay;
+        double minScore;
+
+        double improvementTolerance; // relative.
+    };
+
+    struct Instance {
+        MpSolver model;
+        LinearExpr objective;
+        MpSolver::OptimaOrientation orientation = MpSolver::OptimaOrientation::Minimize;
+    };
+
+    // build the model in instance.model and set the objective in instance, which will be registered by the engine.
+    using BuildModel = std::function<void(int worker, Instance &instance)>;
+
+    struct Statistics {
+        int iterationNum = 0;
+        int improvementNum = 0;
+        List<int> selectionNums = List<int>(NeighborhoodKindNum, 0);
+        List<int> improvementNums = List<int>(NeighborhoodKindNum, 0);
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    LargeNeighborhoodSearch(BuildModel buildModel, const Configuration &config = Configuration());
+    ~LargeNeighborhoodSearch() { releaseInstances(); }
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// values[i] is the value of the i_th variable in the model.
+    void setInitialSolution(const List<double> &values) { incumbent = values; }
+
+    /// returns true if a feasible solution is found.
+    /// the search and the running sub-MIPs stop once the given token is cancelled or its deadline is reached.
+    bool optimize(const CancellationToken &cancellation = CancellationToken());
+
+    bool hasSolution() const { return !incumbent.empty(); }
+    const List<double>& getIncumbent() const { return incumbent; }
+    double getObjectiveValue() const { return incumbentObj; }
+    const Statistics& getStatistics() const { return stat; }
+
+protected:
+    // extract the variable and constraint structure from the instance of the calling worker.
+    void extractStructure(Instance &instance);
+    bool solveInitial(Instance &instance);
+    void search(int worker, const CancellationToken &cancellation);
+
+    Neighborhood selectNeighborhood(Random &rand);
+    // mark the free integer variables in isFree and return their number.
+    int pickRandomVars(Random &rand, int freeNum, List<char> &isFree) const;
+    int pickConnectedVars(Random &rand, int freeNum, bool isObjectiveGuided, const List<double> &values, List<char> &isFree) const;
+    void adapt(Neighborhood kind, bool isImproved, bool isProvenOptimal);
+
+    bool isBetter(double obj, double reference) const {
+        double tolerance = cfg.improvementTolerance * (std::max)(1.0, std::abs(reference));
+        return (orientation == MpSolver::OptimaOrientation::Minimize) ? (obj < reference - tolerance) : (obj > reference + tolerance);
+    }
+
+    void releaseInstances();
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    BuildModel build;
+    ThreadPool pool;
+    List<std::unique_ptr<Instance>> instances;
+
+    // the structure of the model shared by all workers.
+    MpSolver::OptimaOrientation orientation;
+    int varNum;
+    List<int> integerVars;
+    List<char> isInteger;
+    List<double> lbs;
+    List<double> ubs;
+    List<double> objCoefs;
+    List<int> objVars; // the integer variables with non-zero objective coefficients.
+    SparseMatrix rows; // the constraint matrix in CSR for finding the variables in a row.
+    SparseMatrix cols; // the constraint matrix in CSC for finding the rows containing a variable.
+
+    std::mutex incumbentMutex;
+    List<double> incumbent;
+    double incumbentObj;
+    List<double> sizeRatios; // sizeRatios[k] is the neighborhood size of kind k.
+    List<double> scores; // scores[k] is the recent success rate of kind k.
+    std::atomic<int> iterationNum;
+
+    Statistics stat;
+    #pragma endregion Field
+}; // LargeNeighborhoodSearch
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_LARGE_NEIGHBORHOOD_SEARCH_H
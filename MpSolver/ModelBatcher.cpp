@@ -0,0 +1,157 @@
+#include "ModelBatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+void ModelBatcher::solve(List<MpModelView> &jobs, const CancellationToken &cancellation) {
+    stat.batchNum = 0;
+    stat.failedBatchNum = 0;
+    stat.separateSolveNum = 0;
+
+    // pack the consecutive jobs greedily.
+    List<int> batchBegins;
+    int varNum = 0;
+    for (int j = 0; j < static_cast<int>(jobs.size()); ++j) {
+        int jobVarNum = jobs[j].getVariableCount();
+        bool isNewBatch = batchBegins.empty() || ((varNum + jobVarNum) > cfg.maxBatchVarNum)
+            || ((j - batchBegins.back()) >= cfg.maxBatchJobNum);
+        if (isNewBatch) {
+            batchBegins.push_back(j);
+            varNum = 0;
+        }
+        varNum += jobVarNum;
+    }
+    batchBegins.push_back(static_cast<int>(jobs.size()));
+
+    pool.parallelFor(0, static_cast<int>(batchBegins.size()) - 1, [&](int b, int) {
+        CancellationToken token(cancellation.createChild());
+        token.setDeadlineInSecond(cfg.timeoutInSecond);
+        if (cfg.splitMode == SplitMode::Split) {
+            for (int j = batchBegins[b]; j < batchBegins[b + 1]; ++j) { solveSeparately(jobs[j], token, batchBegins[b + 1] - j); }
+        } else {
+            solveBatch(jobs, batchBegins[b], batchBegins[b + 1], token);
+        }
+    });
+}
+
+void ModelBatcher::solveBatch(List<MpModelView> &jobs, int begin, int end, const CancellationToken &token) {
+    ++stat.batchNum;
+
+    int varNum = 0;
+    int rowNum = 0;
+    int64_t nnz = 0;
+    for (int j = begin; j < end; ++j) {
+        varNum += jobs[j].getVariableCount();
+        rowNum += jobs[j].getConstraintCount();
+        nnz += jobs[j].getNonzeroCount();
+    }
+
+    // concatenate the blocks with the variables and rows shifted.
+    MpModelData batch;
+    MpModelView &view(batch.init(varNum, rowNum, nnz));
+    view.header->orientation = MpSolver::OptimaOrientation::Minimize;
+    int varOffset = 0;
+    int rowOffset = 0;
+    int64_t nnzOffset = 0;
+    for (int j = begin; j < end; ++j) {
+        const MpModelView &job(jobs[j]);
+        int jobVarNum = job.getVariableCount();
+        int jobRowNum = job.getConstraintCount();
+        int64_t jobNnz = job.getNonzeroCount();
+        double weight = getObjectiveWeight(job);
+
+        copy(job.lb, job.lb + jobVarNum, view.lb + varOffset);
+        copy(job.ub, job.ub + jobVarNum, view.ub + varOffset);
+        copy(job.type, job.type + jobVarNum, view.type + varOffset);
+        for (int v = 0; v < jobVarNum; ++v) { view.obj[varOffset + v] = weight * job.obj[v]; }
+        view.header->objConstant += weight * job.header->objConstant;
+
+        for (int r = 0; r < jobRowNum; ++r) { view.rowBegin[rowOffset + r + 1] = nnzOffset + job.rowBegin[r + 1]; }
+        for (int64_t i = 0; i < jobNnz; ++i) { view.cols[nnzOffset + i] = varOffset + job.cols[i]; }
+        copy(job.coefs, job.coefs + jobNnz, view.coefs + nnzOffset);
+        copy(job.senses, job.senses + jobRowNum, view.senses + rowOffset);
+        copy(job.rhs, job.rhs + jobRowNum, view.rhs + rowOffset);
+
+        varOffset += jobVarNum;
+        rowOffset += jobRowNum;
+        nnzOffset += jobNnz;
+    }
+
+    MpSolver solver;
+    prepareSolver(solver, token, MpSolver::Configuration::Forever);
+    solver.setMipGap(0, 0); // the combined gap does not bound the gap of each block.
+    solver.load(view);
+    solver.optimize();
+    solver.saveSolution(view);
+
+    MpSolver::ResultStatus status = solver.getStatus();
+    int solutionCount = view.header->solutionCount;
+    if ((solutionCount <= 0) && (cfg.splitMode == SplitMode::SplitOnFailure)) {
+        ++stat.failedBatchNum;
+        Log(LogSwitch::Szx::MpSolver) << "batch[" << begin << ", " << end << "): status=" << status << ", split." << endl;
+        for (int j = begin; j < end; ++j) { solveSeparately(jobs[j], token, end - j); }
+        return;
+    }
+
+    // demultiplex the solution.
+    varOffset = 0;
+    for (int j = begin; j < end; varOffset += jobs[j].getVariableCount(), ++j) {
+        MpModelView &job(jobs[j]);
+        MpModelLayout &header(*job.header);
+        int jobVarNum = job.getVariableCount();
+        header.solutionCount = solutionCount;
+        if (solutionCount <= 0) {
+            header.status = status;
+            continue;
+        }
+        copy(view.values + varOffset, view.values + varOffset + jobVarNum, job.values);
+        header.obj = evaluate(job, job.values);
+        if (status == MpSolver::ResultStatus::Optimal) {
+            header.status = MpSolver::ResultStatus::Optimal;
+            header.bound = header.obj;
+        } else {
+            header.status = MpSolver::ResultStatus::Feasible;
+            header.bound = -header.orientation * numeric_limits<double>::infinity(); // unknown for a single block.
+        }
+    }
+}
+
+void ModelBatcher::solveSeparately(MpModelView &job, const CancellationToken &token, int restJobNum) {
+    ++stat.separateSolveNum;
+    MpSolver solver;
+    prepareSolver(solver, token, token.restSeconds(MpSolver::Configuration::Forever) / restJobNum);
+    solver.load(job);
+    solver.optimize();
+    solver.saveSolution(job);
+}
+
+void ModelBatcher::prepareSolver(MpSolver &solver, const CancellationToken &token, double timeoutInSecond) const {
+    solver.setMaxThread(cfg.solverThreadNum);
+    solver.setTimeLimitInSecond(timeoutInSecond);
+    solver.setCancellationToken(token);
+}
+
+double ModelBatcher::getObjectiveWeight(const MpModelView &job) const {
+    double weight = job.header->orientation;
+    if (!cfg.scaleObjective) { return weight; }
+    double maxCoef = 0;
+    for (int v = 0; v < job.getVariableCount(); ++v) { maxCoef = (max)(maxCoef, abs(job.obj[v])); }
+    return (maxCoef > 0) ? (weight / maxCoef) : weight;
+}
+
+double ModelBatcher::evaluate(const MpModelView &job, const double *values) {
+    double obj = job.header->objConstant;
+    for (int v = 0; v < job.getVariableCount(); ++v) { obj += job.obj[v] * values[v]; }
+    return obj;
+}
+
+}
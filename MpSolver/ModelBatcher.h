@@ -0,0 +1,106 @@
+////////////////////////////////
+/// usage : 1.	solve a stream of tiny independent models with less overhead by packing them into block-diagonal
+///             batches, so that the model creation, presolve setup and optimization entry are paid once per batch.
+///         2.	the objective of each block is normalized by its largest coefficient and turned into minimization
+///             before summed up, so that no block dominates the others in the combined objective.
+///         3.	the solution and status of each job are written back into the solution area of its own layout.
+///
+/// note  : 1.	the combined model is optimal iff every block is optimal, but a feasible combined solution
+///             does not tell the gap of each block, so the bound of a block is only reported if it is optimal.
+///             the batches are solved with zero gap tolerance for it, since the gap of the combined model
+///             could be spent on any block.
+///         2.	an infeasible or unbounded block fails its whole batch, in which case the jobs of the batch
+///             can be split into separate solves (the blocks are exactly the connected components of the batch).
+///         3.	the time limit applies to each batch, and the jobs split from a failed batch share the rest of it.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_MODEL_BATCHER_H
+#define SMART_SZX_GATE_REASSIGNMENT_MODEL_BATCHER_H
+
+
+#include "Config.h"
+
+#include <atomic>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+#include "MpModelData.h"
+
+
+namespace szx {
+
+class ModelBatcher {
+    #pragma region Type
+public:
+    enum SplitMode {
+        Together, // report the failure of a batch to all of its jobs.
+        Split, // solve each job separately, which only saves the environment creation.
+        SplitOnFailure // solve the jobs of a failed batch separately in the rest time of the batch.
+    };
+
+    struct Configuration {
+        static constexpr int DefaultMaxBatchVarNum = 20000;
+        static constexpr int DefaultMaxBatchJobNum = 256;
+        static constexpr int DefaultSolverThreadNum = 1;
+
+        Configuration(int threads = ThreadPool::getHardwareConcurrency(), double timeoutInSec = MpSolver::Configuration::Forever)
+            : threadNum(threads), timeoutInSecond(timeoutInSec), maxBatchVarNum(DefaultMaxBatchVarNum),
+            maxBatchJobNum(DefaultMaxBatchJobNum), splitMode(SplitMode::SplitOnFailure),
+            solverThreadNum(DefaultSolverThreadNum), scaleObjective(true) {}
+
+        int threadNum; // the number of batches solved concurrently.
+        double timeoutInSecond; // the time limit for each batch.
+        int maxBatchVarNum; // a job larger than it is solved in its own batch.
+        int maxBatchJobNum;
+        SplitMode splitMode;
+        int solverThreadNum; // the threads used by each solve.
+        bool scaleObjective;
+    };
+
+    struct Statistics {
+        std::atomic<int> batchNum = { 0 };
+        std::atomic<int> failedBatchNum = { 0 };
+        std::atomic<int> separateSolveNum = { 0 };
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    ModelBatcher(const Configuration &config = Configuration()) : cfg(config), pool(config.threadNum) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// solve the jobs and write the results into the solution area of each job.
+    /// the solves are stopped once the token is cancelled and never run beyond its deadline.
+    void solve(List<MpModelView> &jobs, const CancellationToken &cancellation = CancellationToken());
+
+    const Statistics& getStatistics() const { return stat; }
+
+protected:
+    // solve jobs[begin, end) in one model.
+    void solveBatch(List<MpModelView> &jobs, int begin, int end, const CancellationToken &token);
+    // the job shares the rest time of the token with the rest jobs.
+    void solveSeparately(MpModelView &job, const CancellationToken &token, int restJobNum);
+    void prepareSolver(MpSolver &solver, const CancellationToken &token, double timeoutInSecond) const;
+
+    // the weight which makes the block a minimization with the largest coefficient being 1.
+    double getObjectiveWeight(const MpModelView &job) const;
+    static double evaluate(const MpModelView &job, const double *values);
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    ThreadPool pool;
+    Statistics stat;
+    #pragma endregion Field
+}; // ModelBatcher
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_MODEL_BATCHER_H
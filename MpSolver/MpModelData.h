@@ -0,0 +1,224 @@
+////////////////////////////////
+/// usage : 1.	a flat MILP model in CSR form, which can be placed in a shared memory segment and
+///             loaded by MpSolver::load() in bulk without any intermediate copy.
+///         2.	MpModelView addresses the arrays in any buffer holding the layout, MpModelData owns such a buffer.
+///
+/// note  : 1.	the arrays are addressed by offsets from the beginning of the buffer and aligned to 8 bytes,
+///             so that the buffer can be mapped at different addresses in different processes.
+///         2.	the solution area is written back by the solver, i.e., the status, objective, bound and values.
+///         3.	a buffer from another process is untrusted, so attach() checks that every array lies in the buffer
+///             and every row refers to the existing columns before any of them is addressed.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_MP_MODEL_DATA_H
+#define SMART_SZX_GATE_REASSIGNMENT_MP_MODEL_DATA_H
+
+
+#include "Config.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "Common.h"
+
+
+namespace szx {
+
+struct MpModelLayout {
+    static constexpr std::uint32_t Magic = 0x444D504D; // "MPMD" in little endian.
+    static constexpr std::uint32_t Version = 1;
+    static constexpr std::uint64_t Alignment = 8;
+
+    static std::uint64_t align(std::uint64_t offset) { return (offset + Alignment - 1) / Alignment * Alignment; }
+
+    /// fill the header of a model with the given size and returns the total size of the buffer.
+    static std::uint64_t init(MpModelLayout &layout, int varNum, int rowNum, std::int64_t nnz) {
+        layout = MpModelLayout();
+        layout.magic = Magic;
+        layout.version = Version;
+        layout.varNum = varNum;
+        layout.rowNum = rowNum;
+        layout.nnz = nnz;
+
+        std::uint64_t offset = align(sizeof(MpModelLayout));
+        auto place = [&](std::uint64_t &arrayOffset, std::uint64_t byteNum) {
+            arrayOffset = offset;
+            offset = align(offset + byteNum);
+        };
+        place(layout.lbOffset, sizeof(double) * varNum);
+        place(layout.ubOffset, sizeof(double) * varNum);
+        place(layout.objOffset, sizeof(double) * varNum);
+        place(layout.typeOffset, sizeof(char) * varNum);
+        place(layout.rowBeginOffset, sizeof(std::int64_t) * (rowNum + 1));
+        place(layout.colOffset, sizeof(std::int32_t) * nnz);
+        place(layout.coefOffset, sizeof(double) * nnz);
+        place(layout.senseOffset, sizeof(char) * rowNum);
+        place(layout.rhsOffset, sizeof(double) * rowNum);
+        place(layout.valueOffset, sizeof(double) * varNum);
+        layout.totalSize = offset;
+        return offset;
+    }
+
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::int32_t varNum = 0;
+    std::int32_t rowNum = 0;
+    std::int64_t nnz = 0;
+    std::int32_t orientation = 1; // 1 for minimization and -1 for maximization.
+    std::int32_t reserved = 0;
+    double objConstant = 0;
+
+    std::uint64_t lbOffset = 0;
+    std::uint64_t ubOffset = 0;
+    std::uint64_t objOffset = 0;
+    std::uint64_t typeOffset = 0; // Gurobi variable types, e.g., 'B', 'I' and 'C'.
+    std::uint64_t rowBeginOffset = 0; // the entries of row r are [rowBegin[r], rowBegin[r + 1]).
+    std::uint64_t colOffset = 0;
+    std::uint64_t coefOffset = 0;
+    std::uint64_t senseOffset = 0; // '<', '>' or '='.
+    std::uint64_t rhsOffset = 0;
+    std::uint64_t valueOffset = 0;
+    std::uint64_t totalSize = 0;
+
+    // the solution area.
+    std::int32_t status = -1; // MpSolver::ResultStatus, or -1 if unsolved.
+    std::int32_t solutionCount = 0;
+    double obj = 0;
+    double bound = 0;
+};
+
+
+class MpModelView {
+public:
+    MpModelView() {}
+    MpModelView(void *buffer) { attach(buffer); }
+
+
+    /// returns false if the buffer of the given size does not hold a valid model.
+    /// it scans the rows, so it costs O(rowNum + nnz).
+    bool attach(void *buffer, std::uint64_t size = (std::numeric_limits<std::uint64_t>::max)()) {
+        if (bind(buffer, size) && isConsistent()) { return true; }
+        header = nullptr;
+        return false;
+    }
+
+    /// lay out a model of the given size in the buffer and attach to it.
+    /// returns false if the buffer is too small, whose size can be computed by MpModelLayout::init().
+    bool init(void *buffer, std::uint64_t size, int varNum, int rowNum, std::int64_t nnz) {
+        MpModelLayout layout;
+        if (MpModelLayout::init(layout, varNum, rowNum, nnz) > size) { return false; }
+        *static_cast<MpModelLayout*>(buffer) = layout;
+        if (!bind(buffer, size)) { return false; } // the arrays are left for the caller to fill.
+        rowBegin[0] = 0;
+        return true;
+    }
+
+    /// the rows are in order inside the nonzeros and the columns are in [0, varNum).
+    bool isConsistent() const {
+        if (!header) { return false; }
+        std::int64_t nnz = header->nnz;
+        if ((rowBegin[0] < 0) || (rowBegin[header->rowNum] > nnz)) { return false; }
+        for (std::int32_t r = 0; r < header->rowNum; ++r) {
+            if (rowBegin[r] > rowBegin[r + 1]) { return false; }
+        }
+        for (std::int64_t i = rowBegin[0]; i < rowBegin[header->rowNum]; ++i) {
+            if ((cols[i] < 0) || (cols[i] >= header->varNum)) { return false; }
+        }
+        return true;
+    }
+
+    bool isValid() const { return (header != nullptr); }
+    int getVariableCount() const { return header->varNum; }
+    int getConstraintCount() const { return header->rowNum; }
+    std::int64_t getNonzeroCount() const { return header->nnz; }
+
+
+    MpModelLayout *header = nullptr;
+    double *lb = nullptr;
+    double *ub = nullptr;
+    double *obj = nullptr;
+    char *type = nullptr;
+    std::int64_t *rowBegin = nullptr;
+    std::int32_t *cols = nullptr;
+    double *coefs = nullptr;
+    char *senses = nullptr;
+    double *rhs = nullptr;
+    double *values = nullptr;
+
+protected:
+    // address the arrays if each of them lies in the buffer, without reading them.
+    bool bind(void *buffer, std::uint64_t size) {
+        header = static_cast<MpModelLayout*>(buffer);
+        if (!buffer || (size < sizeof(MpModelLayout)) || (header->magic != MpModelLayout::Magic)
+            || (header->version != MpModelLayout::Version) || (header->totalSize > size)
+            || (header->varNum < 0) || (header->rowNum < 0) || (header->nnz < 0)) {
+            header = nullptr;
+            return false;
+        }
+        std::uint64_t totalSize = header->totalSize;
+        auto fits = [&](std::uint64_t offset, std::uint64_t itemSize, std::uint64_t itemNum) {
+            return (offset % MpModelLayout::Alignment == 0) && (offset >= sizeof(MpModelLayout))
+                && (offset <= totalSize) && (itemNum <= (totalSize - offset) / itemSize);
+        };
+        std::uint64_t varNum = static_cast<std::uint64_t>(header->varNum);
+        std::uint64_t rowNum = static_cast<std::uint64_t>(header->rowNum);
+        std::uint64_t nnz = static_cast<std::uint64_t>(header->nnz);
+        if (!fits(header->lbOffset, sizeof(double), varNum) || !fits(header->ubOffset, sizeof(double), varNum)
+            || !fits(header->objOffset, sizeof(double), varNum) || !fits(header->typeOffset, sizeof(char), varNum)
+            || !fits(header->rowBeginOffset, sizeof(std::int64_t), rowNum + 1) || !fits(header->colOffset, sizeof(std::int32_t), nnz)
+            || !fits(header->coefOffset, sizeof(double), nnz) || !fits(header->senseOffset, sizeof(char), rowNum)
+            || !fits(header->rhsOffset, sizeof(double), rowNum) || !fits(header->valueOffset, sizeof(double), varNum)) {
+            header = nullptr;
+            return false;
+        }
+        char *base = static_cast<char*>(buffer);
+        lb = reinterpret_cast<double*>(base + header->lbOffset);
+        ub = reinterpret_cast<double*>(base + header->ubOffset);
+        obj = reinterpret_cast<double*>(base + header->objOffset);
+        type = base + header->typeOffset;
+        rowBegin = reinterpret_cast<std::int64_t*>(base + header->rowBeginOffset);
+        cols = reinterpret_cast<std::int32_t*>(base + header->colOffset);
+        coefs = reinterpret_cast<double*>(base + header->coefOffset);
+        senses = base + header->senseOffset;
+        rhs = reinterpret_cast<double*>(base + header->rhsOffset);
+        values = reinterpret_cast<double*>(base + header->valueOffset);
+        return true;
+    }
+};
+
+
+class MpModelData {
+public:
+    MpModelData() {}
+    MpModelData(int varNum, int rowNum, std::int64_t nnz) { init(varNum, rowNum, nnz); }
+    MpModelData(const MpModelData&) = delete; // the view would refer to the buffer of the source.
+    MpModelData& operator=(const MpModelData&) = delete;
+    MpModelData(MpModelData&&) = default; // the moved buffer keeps its address.
+    MpModelData& operator=(MpModelData&&) = default;
+
+
+    /// allocate the buffer and fill the header, the arrays are left for the caller to fill.
+    MpModelView& init(int varNum, int rowNum, std::int64_t nnz) {
+        MpModelLayout layout;
+        std::uint64_t size = MpModelLayout::init(layout, varNum, rowNum, nnz);
+        buffer.assign(static_cast<std::size_t>(size / sizeof(std::uint64_t)), 0); // uint64_t keeps the alignment.
+        view.init(buffer.data(), size, varNum, rowNum, nnz);
+        return view;
+    }
+
+    void* data() { return buffer.data(); }
+    std::uint64_t size() const { return buffer.size() * sizeof(std::uint64_t); }
+    MpModelView& getView() { return view; }
+    const MpModelView& getView() const { return view; }
+
+protected:
+    std::vector<std::uint64_t> buffer;
+    MpModelView view;
+};
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_MP_MODEL_DATA_H
@@ -10,9 +10,15 @@
 
 #include "Config.h"
 
+#include <algorithm>
 #include <exception>
 #include <stdexcept>
 #include <string>
+#include <vector>
+#include <limits>
+#include <type_traits>
+#include <cmath>
+#include <cstdio>
 
 
 namespace szx {
@@ -31,21 +37,124 @@ public:
     };
 
 
+    /// format the names by appending the items into a reused buffer without temporary strings.
+    /// e.g., `Name::str("x", i, j)` is "x_1_2", which is stored inline without allocation if it is short.
     struct Name {
         static constexpr char Delimiter = '_';
 
 
-        static std::string str(const char *obj) { return std::string(obj); }
+        /// append the items joined by the delimiter to the buffer.
+        template<typename T>
+        static void append(std::string &buffer, const T &obj) { appendItem(buffer, obj, IsNumber<T>()); }
+        template<typename T, typename ... Ts>
+        static void append(std::string &buffer, const T &obj, const Ts& ... objs) {
+            append(buffer, obj);
+            buffer += Delimiter;
+            append(buffer, objs ...);
+        }
+
+        /// the buffer of the calling thread is overwritten by the next call on the same thread.
+        template<typename ... Ts>
+        static const std::string& format(const Ts& ... objs) {
+            thread_local std::string buffer;
+            buffer.clear();
+            append(buffer, objs ...);
+            return buffer;
+        }
+
+        template<typename ... Ts>
+        static std::string str(const Ts& ... objs) { return format(objs ...); }
+
+    protected:
+        // the enum values are written as their underlying integers.
+        template<typename T>
+        using IsNumber = std::integral_constant<bool, (std::is_arithmetic<T>::value || std::is_enum<T>::value)>;
+        template<typename T, bool IsEnum = std::is_enum<T>::value>
+        struct Number { using type = T; };
+        template<typename T>
+        struct Number<T, true> { using type = typename std::underlying_type<T>::type; };
 
+        static void appendItem(std::string &buffer, const char *obj, std::false_type) { buffer += obj; }
+        static void appendItem(std::string &buffer, const std::string &obj, std::false_type) { buffer += obj; }
         template<typename T>
-        static std::string str(const T &obj) { return std::to_string(obj); }
+        static void appendItem(std::string &buffer, const T &obj, std::true_type) {
+            using N = typename Number<T>::type;
+            appendNumber(buffer, static_cast<N>(obj), std::is_integral<N>());
+        }
 
-        template<typename T, typename ... Ts>
-        static std::string str(const T &obj, Ts ... objs) { return str(obj) + Delimiter + str(objs ...); }
+        template<typename T>
+        static void appendNumber(std::string &buffer, T obj, std::true_type) {
+            char digits[24];
+            char *end = digits + sizeof(digits);
+            char *begin = end;
+            bool isNegative = (obj < 0);
+            auto value = static_cast<unsigned long long>(obj);
+            if (isNegative) { value = 0 - value; }
+            do { *(--begin) = static_cast<char>('0' + (value % 10)); } while ((value /= 10) > 0);
+            if (isNegative) { *(--begin) = '-'; }
+            buffer.append(begin, end);
+        }
+        template<typename T>
+        static void appendNumber(std::string &buffer, T obj, std::false_type) {
+            char digits[64];
+            int len = std::snprintf(digits, sizeof(digits), "%f", static_cast<double>(obj)); // the same as std::to_string().
+            buffer.append(digits, static_cast<size_t>((std::max)(len, 0)));
+        }
+    };
+
+    /// a pattern such as "x_{i}_{j}" which names a block of items, where the k_th "{...}" is replaced by the k_th
+    /// index of the item in the row major order of the dimensions, e.g., the (i * m + j)_th item of {n, m}.
+    class NamePattern {
+    public:
+        NamePattern(const std::string &pattern, const std::vector<int> &dimensions) : dims(dimensions) {
+            literals.emplace_back();
+            for (size_t i = 0; i < pattern.size(); ++i) {
+                if (pattern[i] != '{') { literals.back() += pattern[i]; continue; }
+                i = pattern.find('}', i);
+                if (i == std::string::npos) { throw MpException("unclosed placeholder in name pattern " + pattern); }
+                literals.emplace_back();
+            }
+            if (literals.size() != dims.size() + 1) { throw MpException("the placeholders mismatch the dimensions in name pattern " + pattern); }
+            if (dims.size() > MaxDimension) { throw MpException("too many placeholders in name pattern " + pattern); }
+        }
+
+        int size() const {
+            int count = 1;
+            for (auto d = dims.begin(); d != dims.end(); ++d) { count *= *d; }
+            return count;
+        }
+
+        /// append the name of the item at the offset in the block to the buffer.
+        void format(int offset, std::string &buffer) const {
+            int indices[MaxDimension];
+            int dimNum = static_cast<int>(dims.size());
+            for (int d = dimNum - 1; d >= 0; --d) {
+                indices[d] = offset % dims[d];
+                offset /= dims[d];
+            }
+            buffer += literals[0];
+            for (int d = 0; d < dimNum; ++d) {
+                Name::append(buffer, indices[d]);
+                buffer += literals[d + 1];
+            }
+        }
+
+    protected:
+        static constexpr int MaxDimension = 16;
+
+        std::vector<std::string> literals; // the text around the placeholders.
+        std::vector<int> dims;
     };
 
 
     static bool isTrue(double value) { return (value > 0.5); }
+
+    // relative gap between the incumbent and the bound in the same way as the solvers do.
+    static double relativeGap(double obj, double bound) {
+        if (std::abs(obj) >= 1e100) { return std::numeric_limits<double>::infinity(); } // no incumbent.
+        if (obj == bound) { return 0; }
+        return std::abs(obj - bound) / (std::max)(std::abs(obj), 1e-10);
+    }
 };
 
 }
@@ -1,5 +1,7 @@
 #include "MpSolverGurobi.h"
 
+#include <algorithm>
+
 #include "LogSwitch.h"
 
 
@@ -10,11 +12,14 @@ namespace szx {
 
 thread_local GRBEnv MpSolverGurobi::globalEnv(true);
 
-MpSolverGurobi::MpSolverGurobi() : model(getGlobalEnv()), status(ResultStatus::Ready),
-    timer(Timer::toMillisecond(cfg.timeoutInSecond)), subObjTimer(0ms) {}
+MpSolverGurobi::MpSolverGurobi() : model(getGlobalEnv()), status(ResultStatus::Ready), presolved(false), scaled(false),
+    timer(Timer::toMillisecond(cfg.timeoutInSecond)), subObjTimer(0ms) {
+    mpEvent.postsolve = &postsolve;
+}
 
-MpSolverGurobi::MpSolverGurobi(Configuration &config) : model(getGlobalEnv()), cfg(config),
-    status(ResultStatus::Ready), timer(Timer::toMillisecond(config.timeoutInSecond)), subObjTimer(0ms) {
+MpSolverGurobi::MpSolverGurobi(Configuration &config) : model(getGlobalEnv()), cfg(config), status(ResultStatus::Ready),
+    presolved(false), scaled(false), timer(Timer::toMillisecond(config.timeoutInSecond)), subObjTimer(0ms) {
+    mpEvent.postsolve = &postsolve;
     if (cfg.timeoutInSecond < Configuration::Forever) { setTimeLimitInSecond(cfg.timeoutInSecond); }
     setOutput(cfg.enableOutput);
 }
@@ -67,6 +72,758 @@ bool MpSolverGurobi::reportStatus(ResultStatus status) {
     return false;
 }
 
+const Presolver::Statistics& MpSolverGurobi::presolve() {
+    if (presolved) { return presolveStat; }
+    if (scaled) { throw MpException("presolve() must be called before scale()."); }
+    updateModel();
+
+    // extract the skeleton.
+    int varNum = getVariableCount();
+    int rowNum = getConstraintCount();
+    Arr<DecisionVar> vars(getAllVars());
+    Arr<Constraint> constrs(rowNum, model.getConstrs());
+
+    Presolver::Model skeleton;
+    Arr<double> lbs(varNum, model.get(GRB_DoubleAttr_LB, vars.begin(), varNum));
+    Arr<double> ubs(varNum, model.get(GRB_DoubleAttr_UB, vars.begin(), varNum));
+    Arr<char> types(varNum, model.get(GRB_CharAttr_VType, vars.begin(), varNum));
+    skeleton.lb.assign(lbs.begin(), lbs.end());
+    skeleton.ub.assign(ubs.begin(), ubs.end());
+    skeleton.isInteger.resize(varNum);
+    skeleton.isFrozen.resize(varNum);
+    for (int v = 0; v < varNum; ++v) {
+        skeleton.isInteger[v] = ((types[v] == VariableType::Bool) || (types[v] == VariableType::Integer));
+        skeleton.isFrozen[v] = ((types[v] == VariableType::SemiInt) || (types[v] == VariableType::SemiReal));
+    }
+    for (auto v = frozenVars.begin(); v != frozenVars.end(); ++v) { skeleton.isFrozen[v->index()] = true; }
+
+    if (objectives.empty()) {
+        skeleton.objNum = 1;
+        Arr<double> objCoefs(varNum, model.get(GRB_DoubleAttr_Obj, vars.begin(), varNum));
+        skeleton.objCoefs.assign(objCoefs.begin(), objCoefs.end());
+    } else {
+        skeleton.objNum = getObjectiveCount();
+        skeleton.objCoefs.assign(static_cast<size_t>(varNum) * skeleton.objNum, 0);
+        for (auto o = objectives.begin(); o != objectives.end(); ++o) {
+            int itemNum = static_cast<int>(o->expr.size());
+            for (int i = 0; i < itemNum; ++i) {
+                skeleton.objCoefs[static_cast<size_t>(o->expr.getVar(i).index()) * skeleton.objNum + o->index] += o->expr.getCoeff(i);
+            }
+        }
+    }
+
+    Arr<char> senses(rowNum, model.get(GRB_CharAttr_Sense, constrs.begin(), rowNum));
+    Arr<double> rhs(rowNum, model.get(GRB_DoubleAttr_RHS, constrs.begin(), rowNum));
+    skeleton.senses.assign(senses.begin(), senses.end());
+    skeleton.rhs.assign(rhs.begin(), rhs.end());
+    skeleton.rowBegin.reserve(rowNum + 1);
+    skeleton.rowBegin.push_back(0);
+    for (int r = 0; r < rowNum; ++r) {
+        LinearExpr row = model.getRow(constrs[r]);
+        int itemNum = static_cast<int>(row.size());
+        for (int i = 0; i < itemNum; ++i) {
+            skeleton.cols.push_back(row.getVar(i).index());
+            skeleton.coefs.push_back(row.getCoeff(i));
+        }
+        skeleton.rowBegin.push_back(static_cast<int>(skeleton.cols.size()));
+    }
+
+    // reduce.
+    Presolver presolver(skeleton);
+    presolveStat = presolver.presolve();
+    presolved = true;
+    Log(LogSwitch::Szx::MpSolver) << "presolve: " << presolveStat << endl;
+    if (presolveStat.isInfeasible) { return presolveStat; } // leave it to the backend to report.
+
+    // apply the reductions in place so that the handles of the variables stay valid.
+    const List<int> &modifiedBounds(presolver.getModifiedBounds());
+    List<DecisionVar> boundVars;
+    List<double> newLbs;
+    List<double> newUbs;
+    for (auto v = modifiedBounds.begin(); v != modifiedBounds.end(); ++v) {
+        boundVars.push_back(vars[*v]);
+        newLbs.push_back(skeleton.lb[*v]);
+        newUbs.push_back(skeleton.ub[*v]);
+    }
+    int boundNum = static_cast<int>(boundVars.size());
+    model.set(GRB_DoubleAttr_LB, boundVars.data(), newLbs.data(), boundNum);
+    model.set(GRB_DoubleAttr_UB, boundVars.data(), newUbs.data(), boundNum);
+
+    const List<Presolver::Entry> &removedEntries(presolver.getRemovedEntries());
+    List<Constraint> entryConstrs;
+    List<DecisionVar> entryVars;
+    entryConstrs.reserve(removedEntries.size());
+    entryVars.reserve(removedEntries.size());
+    for (auto e = removedEntries.begin(); e != removedEntries.end(); ++e) {
+        entryConstrs.push_back(constrs[e->row]);
+        entryVars.push_back(vars[e->col]);
+    }
+    List<double> zeros(removedEntries.size(), 0);
+    model.chgCoeffs(entryConstrs.data(), entryVars.data(), zeros.data(), static_cast<int>(zeros.size()));
+
+    const List<char> &removedRows(presolver.getRemovedRows());
+    const List<int> &modifiedRows(presolver.getModifiedRows());
+    List<Constraint> rowConstrs;
+    List<char> newSenses;
+    List<double> newRhs;
+    for (auto r = modifiedRows.begin(); r != modifiedRows.end(); ++r) {
+        if (removedRows[*r]) { continue; }
+        rowConstrs.push_back(constrs[*r]);
+        newSenses.push_back(skeleton.senses[*r]);
+        newRhs.push_back(skeleton.rhs[*r]);
+    }
+    int modifiedRowNum = static_cast<int>(rowConstrs.size());
+    model.set(GRB_CharAttr_Sense, rowConstrs.data(), newSenses.data(), modifiedRowNum);
+    model.set(GRB_DoubleAttr_RHS, rowConstrs.data(), newRhs.data(), modifiedRowNum);
+    for (int r = 0; r < rowNum; ++r) {
+        if (removedRows[r]) { model.remove(constrs[r]); }
+    }
+
+    // the kept column represents the sum of its group, which may exceed the range of a binary.
+    const List<Presolver::ColumnGroup> &mergedColumns(presolver.getMergedColumns());
+    postsolve.groupIndices.assign(varNum, -1);
+    postsolve.groupPositions.assign(varNum, -1);
+    for (auto g = mergedColumns.begin(); g != mergedColumns.end(); ++g) {
+        DecisionVar &kept(vars[g->cols.front()]);
+        if (types[g->cols.front()] == VariableType::Bool) { kept.set(GRB_CharAttr_VType, static_cast<char>(VariableType::Integer)); }
+        int groupIndex = static_cast<int>(postsolve.groups.size());
+        for (int i = 0; i < static_cast<int>(g->cols.size()); ++i) {
+            postsolve.groupIndices[g->cols[i]] = groupIndex;
+            postsolve.groupPositions[g->cols[i]] = i;
+        }
+        postsolve.groups.push_back(*g);
+        postsolve.keptVars.push_back(kept);
+    }
+    if (postsolve.groups.empty()) {
+        postsolve.groupIndices.clear();
+        postsolve.groupPositions.clear();
+    }
+
+    updateModel();
+    return presolveStat;
+}
+
+void MpSolverGurobi::analyzeConditioning(ConditioningAnalyzer::Report &report, const ConditioningAnalyzer::Configuration &config) {
+    MpModelData data;
+    dump(data);
+    List<String> varNameList;
+    List<String> rowNameList;
+    getNames(varNames, getAllVars(), GRB_StringAttr_VarName, varNameList);
+    getNames(constraintNames, getAllConstraints(), GRB_StringAttr_ConstrName, rowNameList);
+
+    // the objectives added by addObjective() are not in the model until they are optimized.
+    List<ConditioningAnalyzer::Objective> objs;
+    auto addObjective = [&](const String &name, const LinearExpr &expr) {
+        LinearExpr scaledExpr(toScaled(expr));
+        objs.push_back({ name, List<int>(), List<double>() });
+        int itemNum = static_cast<int>(scaledExpr.size());
+        for (int i = 0; i < itemNum; ++i) {
+            objs.back().vars.push_back(scaledExpr.getVar(i).index());
+            objs.back().coefs.push_back(scaledExpr.getCoeff(i));
+        }
+    };
+    for (auto o = objectives.begin(); o != objectives.end(); ++o) { addObjective(Name::str("obj", o->priority), o->expr); }
+    if (!cfg.inPriorityMode && (getObjectiveCount() > 1)) { addObjective("weighted", getWeightedObjective()); }
+
+    ConditioningAnalyzer analyzer(config);
+    analyzer.analyze(data.getView(), varNameList, rowNameList, report, objs);
+}
+
+void MpSolverGurobi::scale(const ConditioningAnalyzer::Configuration &config) {
+    if (scaled) { return; }
+    MpModelData data;
+    dump(data);
+    const MpModelView &view(data.getView());
+    int varNum = view.getVariableCount();
+    int rowNum = view.getConstraintCount();
+
+    // the SOS and general constraints refer to the columns in the original units, e.g., the points of the piecewise linear functions.
+    // the quadratic terms would be scaled by the products of the column scales, which the flat layout does not hold.
+    bool scaleColumns = isLinear();
+    ConditioningAnalyzer analyzer(config);
+    ConditioningAnalyzer::Scaling scaling;
+    analyzer.computeScaling(view, scaleColumns, scaling);
+    scaled = true;
+    auto isOne = [](double s) { return (s == 1); };
+    bool isRowScaled = !all_of(scaling.rowScales.begin(), scaling.rowScales.end(), isOne);
+    bool isColScaled = !all_of(scaling.colScales.begin(), scaling.colScales.end(), isOne);
+    if (!isRowScaled && !isColScaled) { return; }
+
+    Arr<DecisionVar> vars(getAllVars());
+    Arr<Constraint> constrs(getAllConstraints());
+    List<Constraint> entryConstrs;
+    List<DecisionVar> entryVars;
+    List<double> entryCoefs;
+    for (int r = 0; r < rowNum; ++r) {
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) {
+            double factor = scaling.rowScales[r] * scaling.colScales[view.cols[i]];
+            if (factor == 1) { continue; }
+            entryConstrs.push_back(constrs[r]);
+            entryVars.push_back(vars[view.cols[i]]);
+            entryCoefs.push_back(view.coefs[i] * factor);
+        }
+    }
+    model.chgCoeffs(entryConstrs.data(), entryVars.data(), entryCoefs.data(), static_cast<int>(entryCoefs.size()));
+
+    if (isRowScaled) {
+        List<double> rhs(view.rhs, view.rhs + rowNum);
+        for (int r = 0; r < rowNum; ++r) { rhs[r] *= scaling.rowScales[r]; }
+        model.set(GRB_DoubleAttr_RHS, constrs.begin(), rhs.data(), rowNum);
+        postsolve.rowScales.swap(scaling.rowScales);
+    }
+    if (isColScaled) {
+        // the objective coefficients in the view may come from addObjective(), so they are read from the model.
+        Arr<double> objs(varNum, model.get(GRB_DoubleAttr_Obj, vars.begin(), varNum));
+        Arr<double> starts(varNum, model.get(GRB_DoubleAttr_Start, vars.begin(), varNum));
+        List<double> lbs(view.lb, view.lb + varNum);
+        List<double> ubs(view.ub, view.ub + varNum);
+        for (int v = 0; v < varNum; ++v) {
+            double colScale = scaling.colScales[v];
+            lbs[v] = toScaledValue(lbs[v], colScale);
+            ubs[v] = toScaledValue(ubs[v], colScale);
+            starts[v] = toScaledValue(starts[v], colScale);
+            objs[v] *= colScale;
+        }
+        model.set(GRB_DoubleAttr_LB, vars.begin(), lbs.data(), varNum);
+        model.set(GRB_DoubleAttr_UB, vars.begin(), ubs.data(), varNum);
+        model.set(GRB_DoubleAttr_Start, vars.begin(), starts.begin(), varNum);
+        model.set(GRB_DoubleAttr_Obj, vars.begin(), objs.begin(), varNum);
+        postsolve.colScales.swap(scaling.colScales);
+    }
+    updateModel();
+}
+
+MpSolverGurobi::LinearExpr MpSolverGurobi::Postsolve::toScaled(const LinearExpr &expr) const {
+    if (colScales.empty()) { return expr; }
+    int itemNum = static_cast<int>(expr.size());
+    List<DecisionVar> vars(itemNum);
+    List<double> coefs(itemNum);
+    for (int i = 0; i < itemNum; ++i) {
+        vars[i] = expr.getVar(i);
+        coefs[i] = expr.getCoeff(i) * getColScale(vars[i].index());
+    }
+    LinearExpr scaledExpr(expr.getConstant());
+    scaledExpr.addTerms(coefs.data(), vars.data(), itemNum);
+    return scaledExpr;
+}
+
+MpSolverGurobi::LinearExpr MpSolverGurobi::Postsolve::toReduced(const LinearExpr &expr, const char *method) const {
+    if (groups.empty()) { return expr; }
+    int itemNum = static_cast<int>(expr.size());
+    List<DecisionVar> vars;
+    List<double> coefs;
+    Map<int, double> mergedCoefs; // the coefficients of the merged columns, which may appear more than once.
+    for (int i = 0; i < itemNum; ++i) {
+        DecisionVar var(expr.getVar(i));
+        if (isMerged(var.index())) {
+            mergedCoefs[var.index()] += expr.getCoeff(i);
+        } else {
+            vars.push_back(var);
+            coefs.push_back(expr.getCoeff(i));
+        }
+    }
+    if (mergedCoefs.empty()) { return expr; }
+
+    Set<int> reducedGroups;
+    for (auto c = mergedCoefs.begin(); c != mergedCoefs.end(); ++c) {
+        int g = groupIndices[c->first];
+        if (!reducedGroups.insert(g).second) { continue; }
+        for (auto col = groups[g].cols.begin(); col != groups[g].cols.end(); ++col) {
+            auto coef = mergedCoefs.find(*col);
+            if ((coef == mergedCoefs.end()) || (coef->second != c->second)) {
+                throw MpException(String(method) + "() with different coefficients on the columns merged by presolve is unavailable.");
+            }
+        }
+        vars.push_back(keptVars[g]); // the kept column is the sum of its group.
+        coefs.push_back(c->second);
+    }
+    LinearExpr reducedExpr(expr.getConstant());
+    reducedExpr.addTerms(coefs.data(), vars.data(), static_cast<int>(vars.size()));
+    return reducedExpr;
+}
+
+double MpSolverGurobi::Postsolve::getMergedSum(int g, const Map<int, double> &values) const {
+    const Presolver::ColumnGroup &group(groups[g]);
+    double sum = 0;
+    for (int i = 0; i < static_cast<int>(group.cols.size()); ++i) {
+        auto value = values.find(group.cols[i]);
+        sum += (value != values.end()) ? value->second : Presolver::getAnchorValue(group, i);
+    }
+    return sum;
+}
+
+void MpSolverGurobi::reduceNewRow(const Constraint &constraint) {
+    updateModel();
+    LinearExpr row(getRow(constraint));
+    LinearExpr reducedRow;
+    try {
+        reducedRow = postsolve.toReduced(row, "addConstraint");
+    } catch (MpException&) {
+        model.remove(constraint);
+        throw;
+    }
+    List<Constraint> constrs;
+    List<DecisionVar> vars;
+    List<double> coefs;
+    int itemNum = static_cast<int>(row.size());
+    for (int i = 0; i < itemNum; ++i) { // the dropped columns of the groups leave the row.
+        DecisionVar var(row.getVar(i));
+        int index = var.index();
+        if (!postsolve.isMerged(index) || (postsolve.groupPositions[index] == 0)) { continue; }
+        constrs.push_back(constraint);
+        vars.push_back(var);
+        coefs.push_back(0);
+    }
+    itemNum = static_cast<int>(reducedRow.size());
+    for (int i = 0; i < itemNum; ++i) {
+        DecisionVar var(reducedRow.getVar(i));
+        double colScale = getColScale(var);
+        if ((colScale == 1) && !postsolve.isMerged(var.index())) { continue; }
+        constrs.push_back(constraint);
+        vars.push_back(var);
+        coefs.push_back(reducedRow.getCoeff(i) * colScale);
+    }
+    model.chgCoeffs(constrs.data(), vars.data(), coefs.data(), static_cast<int>(coefs.size()));
+}
+
+bool MpSolverGurobi::getFarkasCertificate(Arr<double> &multipliers, double &minActivity) {
+    int rowNum = getConstraintCount();
+    int varNum = getVariableCount();
+    Arr<Constraint> constrs(getAllConstraints());
+    try {
+        multipliers = Arr<double>(rowNum, model.get(GRB_DoubleAttr_FarkasDual, constrs.begin(), rowNum));
+    } catch (GRBException&) {
+        return false;
+    }
+
+    // aggregate the columns and bound y'Ax over the variable bounds.
+    Arr<double> aggregation(varNum, 0.0);
+    for (int r = 0; r < rowNum; ++r) {
+        if (multipliers[r] == 0) { continue; }
+        LinearExpr row = model.getRow(constrs[r]);
+        int itemNum = static_cast<int>(row.size());
+        for (int i = 0; i < itemNum; ++i) { aggregation[row.getVar(i).index()] += multipliers[r] * row.getCoeff(i); }
+    }
+    Arr<DecisionVar> vars(getAllVars());
+    Arr<double> lbs(varNum, model.get(GRB_DoubleAttr_LB, vars.begin(), varNum));
+    Arr<double> ubs(varNum, model.get(GRB_DoubleAttr_UB, vars.begin(), varNum));
+    double minAct = 0;
+    double maxAct = 0;
+    bool isMinFinite = true;
+    bool isMaxFinite = true;
+    for (int v = 0; v < varNum; ++v) {
+        if (aggregation[v] == 0) { continue; }
+        double lo = (aggregation[v] > 0) ? lbs[v] : ubs[v];
+        double hi = (aggregation[v] > 0) ? ubs[v] : lbs[v];
+        if (abs(lo) >= Infinity) { isMinFinite = false; } else { minAct += aggregation[v] * lo; }
+        if (abs(hi) >= Infinity) { isMaxFinite = false; } else { maxAct += aggregation[v] * hi; }
+    }
+    Arr<double> rhs(rowNum, model.get(GRB_DoubleAttr_RHS, constrs.begin(), rowNum));
+    double aggregatedRhs = 0;
+    for (int r = 0; r < rowNum; ++r) { aggregatedRhs += multipliers[r] * rhs[r]; }
+
+    // the sign convention of the multipliers differs among solvers, so take whichever direction proves infeasibility.
+    if (isMinFinite && (minAct > aggregatedRhs)) {
+        minActivity = minAct;
+    } else if (isMaxFinite && (maxAct < aggregatedRhs)) {
+        for (auto y = multipliers.begin(); y != multipliers.end(); ++y) { *y = -*y; }
+        minActivity = -maxAct;
+    } else {
+        return false;
+    }
+    // the multipliers of the scaled rows (R * A) and (R * b) are (y / R).
+    if (!postsolve.rowScales.empty()) {
+        for (int r = 0; r < rowNum; ++r) { multipliers[r] *= postsolve.getRowScale(r); }
+    }
+    return true;
+}
+
+void MpSolverGurobi::load(const MpModelView &view) {
+    if (!view.isConsistent()) { throw MpException("the flat model is malformed."); }
+    int varNum = view.getVariableCount();
+    int rowNum = view.getConstraintCount();
+    Arr<DecisionVar> vars(varNum, model.addVars(view.lb, view.ub, view.obj, view.type, nullptr, varNum));
+
+    List<LinearExpr> rows(rowNum);
+    List<DecisionVar> rowVars;
+    for (int r = 0; r < rowNum; ++r) {
+        int itemNum = static_cast<int>(view.rowBegin[r + 1] - view.rowBegin[r]);
+        const std::int32_t *cols = view.cols + view.rowBegin[r];
+        rowVars.resize(itemNum);
+        for (int i = 0; i < itemNum; ++i) { rowVars[i] = vars[cols[i]]; }
+        rows[r].addTerms(view.coefs + view.rowBegin[r], rowVars.data(), itemNum);
+    }
+    delete[] model.addConstrs(rows.data(), view.senses, view.rhs, nullptr, rowNum);
+
+    model.set(GRB_IntAttr_ModelSense, view.header->orientation);
+    model.set(GRB_DoubleAttr_ObjCon, view.header->objConstant);
+    updateModel();
+}
+
+void MpSolverGurobi::saveSolution(MpModelView &view) {
+    if (!view.isValid() || (view.getVariableCount() != getVariableCount())) {
+        throw MpException("the flat model mismatches the variables of the solver.");
+    }
+    MpModelLayout &header(*view.header);
+    header.status = status;
+    header.solutionCount = getSolutionCount();
+    if (header.solutionCount <= 0) { return; }
+    header.obj = getObjectiveValue();
+    header.bound = getBestBound();
+    Arr<DecisionVar> vars(getAllVars());
+    Arr<double> values(vars.size(), model.get(GRB_DoubleAttr_X, vars.begin(), vars.size()));
+    if (postsolve.empty()) {
+        copy(values.begin(), values.end(), view.values);
+        return;
+    }
+    // the same values as getValue(), i.e., the merged columns are split and the scaled columns are unscaled.
+    auto getRawValue = [&](const DecisionVar &var) { return values[var.index()]; };
+    for (int v = 0; v < vars.size(); ++v) { view.values[v] = postsolve.getValue(vars[v], getRawValue); }
+}
+
+void MpSolverGurobi::save(MpModelData &data) {
+    if (getObjectiveCount() > 1) { throw MpException("only a single objective can be saved into the flat layout."); }
+    // the flat layout only holds the linear rows, so dropping the others would save a relaxation silently.
+    if (!isLinear()) { throw MpException("the SOS, general or quadratic constraints and objectives can not be saved into the flat layout."); }
+    if (presolved || scaled) { throw MpException("the presolved or scaled model can not be saved into the flat layout."); }
+    dump(data);
+}
+
+void MpSolverGurobi::dump(MpModelData &data) {
+    updateModel();
+    Arr<DecisionVar> vars(getAllVars());
+    Arr<Constraint> constraints(getAllConstraints());
+    int varNum = static_cast<int>(vars.size());
+    int rowNum = static_cast<int>(constraints.size());
+
+    List<LinearExpr> rows(rowNum);
+    std::int64_t nnz = 0;
+    for (int r = 0; r < rowNum; ++r) {
+        rows[r] = getRow(constraints[r]);
+        nnz += rows[r].size();
+    }
+
+    MpModelView &view(data.init(varNum, rowNum, nnz));
+    Arr<double> lbs(varNum, model.get(GRB_DoubleAttr_LB, vars.begin(), varNum));
+    Arr<double> ubs(varNum, model.get(GRB_DoubleAttr_UB, vars.begin(), varNum));
+    Arr<char> types(varNum, model.get(GRB_CharAttr_VType, vars.begin(), varNum));
+    copy(lbs.begin(), lbs.end(), view.lb);
+    copy(ubs.begin(), ubs.end(), view.ub);
+    copy(types.begin(), types.end(), view.type);
+    if (objectives.empty()) {
+        Arr<double> objs(varNum, model.get(GRB_DoubleAttr_Obj, vars.begin(), varNum));
+        copy(objs.begin(), objs.end(), view.obj);
+        view.header->orientation = model.get(GRB_IntAttr_ModelSense);
+        view.header->objConstant = model.get(GRB_DoubleAttr_ObjCon);
+    } else {
+        LinearExpr expr(toScaled(objectives.front().expr));
+        fill(view.obj, view.obj + varNum, 0.0);
+        int itemNum = static_cast<int>(expr.size());
+        for (int i = 0; i < itemNum; ++i) { view.obj[expr.getVar(i).index()] += expr.getCoeff(i); }
+        view.header->orientation = objectives.front().optimaOrientation;
+        view.header->objConstant = expr.getConstant();
+    }
+
+    for (int r = 0; r < rowNum; ++r) {
+        int itemNum = static_cast<int>(rows[r].size());
+        std::int64_t begin = view.rowBegin[r];
+        for (int i = 0; i < itemNum; ++i) {
+            view.cols[begin + i] = rows[r].getVar(i).index();
+            view.coefs[begin + i] = rows[r].getCoeff(i);
+        }
+        view.rowBegin[r + 1] = begin + itemNum;
+    }
+    Arr<char> senses(rowNum, model.get(GRB_CharAttr_Sense, constraints.begin(), rowNum));
+    Arr<double> rhs(rowNum, model.get(GRB_DoubleAttr_RHS, constraints.begin(), rowNum));
+    copy(senses.begin(), senses.end(), view.senses);
+    copy(rhs.begin(), rhs.end(), view.rhs);
+}
+
+void MpSolverGurobi::setObjCoefs(const List<DecisionVar> &vars, const List<double> &coefs, int objIndex) {
+    checkSize("setObjCoefs", vars.size(), coefs.size());
+    if (objIndex >= getObjectiveCount()) {
+        List<double> scaledCoefs(coefs);
+        for (size_t i = 0; i < vars.size(); ++i) { scaledCoefs[i] *= getColScale(vars[i]); }
+        model.set(GRB_DoubleAttr_Obj, vars.data(), scaledCoefs.data(), static_cast<int>(vars.size()));
+        return;
+    }
+
+    // rebuild the expression in one pass instead of removing the terms one by one.
+    // the variables added since the last update have no index yet, so they are matched by sameAs() without updating.
+    LinearExpr &expr(objectives[objIndex].expr);
+    Map<int, int> lastChanges; // only the last change on the same variable counts.
+    List<int> pendingChanges; // the last changes on the variables without index.
+    auto findPending = [&](const DecisionVar &var) {
+        for (auto p = pendingChanges.begin(); p != pendingChanges.end(); ++p) {
+            DecisionVar changed(vars[*p]);
+            if (changed.sameAs(var)) { return p; }
+        }
+        return pendingChanges.end();
+    };
+    for (int i = 0; i < static_cast<int>(vars.size()); ++i) {
+        if (vars[i].index() >= 0) { lastChanges[vars[i].index()] = i; continue; }
+        auto p = findPending(vars[i]);
+        if (p != pendingChanges.end()) { *p = i; } else { pendingChanges.push_back(i); }
+    }
+    List<DecisionVar> newVars;
+    List<double> newCoefs;
+    int itemNum = static_cast<int>(expr.size());
+    newVars.reserve(itemNum + lastChanges.size() + pendingChanges.size());
+    newCoefs.reserve(itemNum + lastChanges.size() + pendingChanges.size());
+    for (int i = 0; i < itemNum; ++i) {
+        DecisionVar var = expr.getVar(i);
+        int index = var.index();
+        if ((index >= 0) ? (lastChanges.find(index) != lastChanges.end()) : (findPending(var) != pendingChanges.end())) { continue; }
+        newVars.push_back(var);
+        newCoefs.push_back(expr.getCoeff(i));
+    }
+    for (auto c = lastChanges.begin(); c != lastChanges.end(); ++c) {
+        newVars.push_back(vars[c->second]);
+        newCoefs.push_back(coefs[c->second]);
+    }
+    for (auto p = pendingChanges.begin(); p != pendingChanges.end(); ++p) {
+        newVars.push_back(vars[*p]);
+        newCoefs.push_back(coefs[*p]);
+    }
+    LinearExpr rebuilt(expr.getConstant());
+    rebuilt.addTerms(newCoefs.data(), newVars.data(), static_cast<int>(newVars.size()));
+    expr = rebuilt;
+}
+
+SparseMatrix MpSolverGurobi::getMatrix() {
+    updateModel();
+    Arr<Constraint> constraints(getAllConstraints());
+    List<int> rows;
+    List<int> cols;
+    List<double> coefs;
+    for (int r = 0; r < static_cast<int>(constraints.size()); ++r) {
+        LinearExpr row = getRow(constraints[r]);
+        int itemNum = static_cast<int>(row.size());
+        for (int i = 0; i < itemNum; ++i) {
+            rows.push_back(r);
+            cols.push_back(row.getVar(i).index());
+            coefs.push_back(row.getCoeff(i));
+        }
+    }
+    return SparseMatrix::fromTriplets(static_cast<int>(constraints.size()), getVariableCount(), rows, cols, coefs);
+}
+
+Arr<MpSolverGurobi::Constraint> MpSolverGurobi::addConstraints(const SparseMatrix &matrix, const List<DecisionVar> &vars,
+    const List<char> &senses, const List<double> &rhs, const List<String> &names) {
+    SparseMatrix rowMajor(matrix.toLayout(SparseMatrix::Layout::RowMajor));
+    int rowNum = rowMajor.getRowCount();
+    List<LinearExpr> exprs(rowNum);
+    List<DecisionVar> rowVars;
+    for (int r = 0; r < rowNum; ++r) {
+        SparseMatrix::Line line = rowMajor.getLine(r);
+        rowVars.resize(static_cast<size_t>(line.len));
+        for (int64_t i = 0; i < line.len; ++i) { rowVars[i] = vars[line.indices[i]]; }
+        exprs[r].addTerms(line.values, rowVars.data(), static_cast<int>(line.len));
+    }
+    return addConstraints(exprs, senses, rhs, names);
+}
+
+void MpSolverGurobi::addIndicator(const DecisionVar &indicator, bool indicatorValue, const LinearExpr &expr,
+    ConstraintSense sense, double rhs, const String &name) {
+    #if GUROBI_NATIVE_INDICATOR
+    checkUnscaled("addIndicator");
+    frozenVars.push_back(indicator);
+    for (int i = 0; i < static_cast<int>(expr.size()); ++i) { frozenVars.push_back(expr.getVar(i)); }
+    model.addGenConstrIndicator(indicator, indicatorValue, expr, static_cast<char>(sense), rhs, (cfg.enableNames ? name : String()));
+    #else
+    updateModel(); // the bounds of the new variables are only available after the update.
+    if (sense != ConstraintSense::GreaterEqual) { addBigM(indicator, indicatorValue, expr, rhs, name); }
+    if (sense != ConstraintSense::LessEqual) { addBigM(indicator, indicatorValue, -expr, -rhs, name); }
+    #endif // GUROBI_NATIVE_INDICATOR
+}
+
+void MpSolverGurobi::addPiecewiseLinear(const DecisionVar &x, const DecisionVar &y, const List<double> &xs,
+    const List<double> &ys, const String &name) {
+    int pointNum = static_cast<int>(xs.size());
+    #if GUROBI_NATIVE_PIECEWISE_LINEAR
+    checkUnscaled("addPiecewiseLinear");
+    frozenVars.push_back(x);
+    frozenVars.push_back(y);
+    model.addGenConstrPWL(x, y, pointNum, xs.data(), ys.data(), (cfg.enableNames ? name : String()));
+    #else
+    // extend the end segments to the bounds of x by the extra points as the native constraint extrapolates them.
+    List<double> pointXs(xs);
+    List<double> pointYs(ys);
+    if (pointNum > 0) {
+        auto getSlope = [&](int i, int j) { return (xs[j] != xs[i]) ? ((ys[j] - ys[i]) / (xs[j] - xs[i])) : 0; };
+        double lb = getLowerBound(x);
+        double ub = getUpperBound(x);
+        if (lb < xs.front()) {
+            if (lb <= -Infinity) { throw MpException("x of the piecewise linear constraint " + name + " is unbounded below the first point."); }
+            double slope = (pointNum > 1) ? getSlope(0, 1) : 0;
+            pointXs.insert(pointXs.begin(), lb);
+            pointYs.insert(pointYs.begin(), ys.front() - slope * (xs.front() - lb));
+        }
+        if (ub > xs.back()) {
+            if (ub >= Infinity) { throw MpException("x of the piecewise linear constraint " + name + " is unbounded above the last point."); }
+            double slope = (pointNum > 1) ? getSlope(pointNum - 2, pointNum - 1) : 0;
+            pointXs.push_back(ub);
+            pointYs.push_back(ys.back() + slope * (ub - xs.back()));
+        }
+        pointNum = static_cast<int>(pointXs.size());
+    }
+
+    // x = sum(w[i] * xs[i]), y = sum(w[i] * ys[i]) and sum(w[i]) = 1 where at most two adjacent w[i] are nonzero.
+    List<DecisionVar> weights(pointNum);
+    List<double> orders(pointNum);
+    LinearExpr total;
+    LinearExpr xExpr;
+    LinearExpr yExpr;
+    for (int i = 0; i < pointNum; ++i) {
+        weights[i] = model.addVar(0, 1, 0, GRB_CONTINUOUS);
+        orders[i] = i;
+        total += weights[i];
+        xExpr += pointXs[i] * weights[i];
+        yExpr += pointYs[i] * weights[i];
+    }
+    addConstraint(total == 1, name);
+    addConstraint(xExpr == x, name);
+    addConstraint(yExpr == y, name);
+    addSos(SosType::Sos2, weights, orders);
+    #endif // GUROBI_NATIVE_PIECEWISE_LINEAR
+}
+
+double MpSolverGurobi::getActivity(const LinearExpr &expr, bool isMax) const {
+    double activity = expr.getConstant();
+    int itemNum = static_cast<int>(expr.size());
+    for (int i = 0; i < itemNum; ++i) {
+        double coef = expr.getCoeff(i);
+        if (coef == 0) { continue; }
+        // the upper bound gives the maximum of a positive term and the minimum of a negative one.
+        double bound = ((coef > 0) == isMax) ? getUpperBound(expr.getVar(i)) : getLowerBound(expr.getVar(i));
+        if (std::abs(bound) >= Infinity) { return isMax ? Infinity : -Infinity; }
+        activity += coef * bound;
+    }
+    return activity;
+}
+
+void MpSolverGurobi::addBigM(const DecisionVar &indicator, bool indicatorValue, const LinearExpr &expr, double rhs, const String &name) {
+    double maxActivity = getMaxActivity(expr);
+    if (maxActivity >= Infinity) { throw MpException("the big-M of the indicator constraint " + name + " is unbounded."); }
+    double bigM = maxActivity - rhs;
+    if (bigM <= 0) { return; } // it holds anyway.
+    if (indicatorValue) {
+        addConstraint(expr + bigM * indicator <= rhs + bigM, name);
+    } else {
+        addConstraint(expr - bigM * indicator <= rhs, name);
+    }
+}
+
+void MpSolverGurobi::applyNamePatterns() {
+    updateModel();
+    if (!varNames.empty()) { applyNamePatterns(varNames, getAllVars(), GRB_StringAttr_VarName); }
+    if (!constraintNames.empty()) { applyNamePatterns(constraintNames, getAllConstraints(), GRB_StringAttr_ConstrName); }
+}
+
+bool MpSolverGurobi::computeIIS(IisMethod method, List<int> &constraintIndices, List<int> &lbIndices, List<int> &ubIndices, bool &isMinimal) {
+    constraintIndices.clear();
+    lbIndices.clear();
+    ubIndices.clear();
+    updateModel();
+    try {
+        model.set(GRB_IntParam_IISMethod, method);
+        model.computeIIS();
+
+        Arr<DecisionVar> vars(getAllVars());
+        Arr<Constraint> constraints(getAllConstraints());
+        Arr<int> inConstraints(constraints.size(), model.get(GRB_IntAttr_IISConstr, constraints.begin(), constraints.size()));
+        Arr<int> inLbs(vars.size(), model.get(GRB_IntAttr_IISLB, vars.begin(), vars.size()));
+        Arr<int> inUbs(vars.size(), model.get(GRB_IntAttr_IISUB, vars.begin(), vars.size()));
+        for (int r = 0; r < static_cast<int>(constraints.size()); ++r) { if (inConstraints[r]) { constraintIndices.push_back(r); } }
+        for (int v = 0; v < static_cast<int>(vars.size()); ++v) {
+            if (inLbs[v]) { lbIndices.push_back(v); }
+            if (inUbs[v]) { ubIndices.push_back(v); }
+        }
+        isMinimal = (model.get(GRB_IntAttr_IISMinimal) != 0);
+        return true;
+    } catch (GRBException &e) {
+        Log(LogSwitch::Szx::MpSolver) << "computeIIS: " << e.getMessage() << endl;
+        return false;
+    }
+}
+
+bool MpSolverGurobi::getBasis(List<int> &varBasis, List<int> &constraintBasis) {
+    try {
+        Arr<DecisionVar> vars(getAllVars());
+        Arr<Constraint> constraints(getAllConstraints());
+        Arr<int> vbasis(vars.size(), model.get(GRB_IntAttr_VBasis, vars.begin(), vars.size()));
+        Arr<int> cbasis(constraints.size(), model.get(GRB_IntAttr_CBasis, constraints.begin(), constraints.size()));
+        varBasis.assign(vbasis.begin(), vbasis.end());
+        constraintBasis.assign(cbasis.begin(), cbasis.end());
+        return true;
+    } catch (GRBException&) { // there is no basis for MIP or barrier without crossover.
+        return false;
+    }
+}
+
+void MpSolverGurobi::setBasis(const List<int> &varBasis, const List<int> &constraintBasis) {
+    Arr<DecisionVar> vars(getAllVars());
+    Arr<Constraint> constraints(getAllConstraints());
+    model.set(GRB_IntAttr_VBasis, vars.begin(), varBasis.data(), vars.size());
+    model.set(GRB_IntAttr_CBasis, constraints.begin(), constraintBasis.data(), constraints.size());
+}
+
+MpSolverGurobi::PartialStartReport MpSolverGurobi::setPartialInitValues(List<DecisionVar> &vars, const List<double> &values, double timeLimitInSecond) {
+    PartialStartReport report;
+    report.knownVarNum = static_cast<int>(vars.size());
+    Timer repairTimer(Timer::toMillisecond(timeLimitInSecond));
+
+    // fix the known variables, which are checked first so that no bound is left fixed by the failure.
+    for (auto v = vars.begin(); v != vars.end(); ++v) { checkUnmerged(*v, "setPartialInitValues"); }
+    List<double> lbs(vars.size());
+    List<double> ubs(vars.size());
+    for (size_t i = 0; i < vars.size(); ++i) {
+        lbs[i] = getLowerBound(vars[i]);
+        ubs[i] = getUpperBound(vars[i]);
+        VariableType type = getType(vars[i]);
+        bool isInteger = ((type == VariableType::Bool) || (type == VariableType::Integer) || (type == VariableType::SemiInt));
+        double value = isInteger ? std::round(values[i]) : values[i];
+        setBounds(vars[i], value, value);
+    }
+
+    // complete the others without disturbing the callbacks and parameters of the main optimization.
+    double timeLimit = model.get(GRB_DoubleParam_TimeLimit);
+    int solutionLimit = model.get(GRB_IntParam_SolutionLimit);
+    int mipFocus = model.get(GRB_IntParam_MIPFocus);
+    ResultStatus lastStatus = status;
+    GRBCallback *lastCallback = installedCallback;
+    installCallback(nullptr);
+    model.set(GRB_DoubleParam_TimeLimit, (std::max)(timeLimitInSecond, 0.0));
+    model.set(GRB_IntParam_SolutionLimit, 1);
+    model.set(GRB_IntParam_MIPFocus, MipFocusMode::ImproveFeasibleSolution);
+    solve();
+
+    Arr<DecisionVar> allVars;
+    Arr<double> completion;
+    if (getSolutionCount() > 0) {
+        report.isCompleted = true;
+        allVars = getAllVars();
+        completion = Arr<double>(allVars.size(), model.get(GRB_DoubleAttr_X, allVars.begin(), allVars.size()));
+    }
+
+    model.set(GRB_DoubleParam_TimeLimit, timeLimit);
+    model.set(GRB_IntParam_SolutionLimit, solutionLimit);
+    model.set(GRB_IntParam_MIPFocus, mipFocus);
+    status = lastStatus;
+    installCallback(lastCallback);
+    for (size_t i = 0; i < vars.size(); ++i) { setBounds(vars[i], lbs[i], ubs[i]); }
+
+    if (report.isCompleted) {
+        model.set(GRB_DoubleAttr_Start, allVars.begin(), completion.begin(), allVars.size());
+    } else {
+        for (size_t i = 0; i < vars.size(); ++i) { setInitValue(vars[i], values[i]); }
+    }
+    report.repairSeconds = repairTimer.elapsedSeconds();
+    Log(LogSwitch::Szx::MpSolver) << "partial start: known=" << report.knownVarNum << " completed=" << report.isCompleted
+        << " repair=" << report.repairSeconds << "s" << endl;
+    return report;
+}
+
 List<double> MpSolverGurobi::getObjectiveValues() const {
     List<double> objValues;
     objValues.reserve(getObjectiveCount());
@@ -82,14 +839,18 @@ bool MpSolverGurobi::optimizeWithGurobiMultiObjective() {
     // single objective optimization.
     if (getObjectiveCount() == 1) {
         setObjective(i->expr, i->optimaOrientation);
-        setTimeLimitInSecond((i->timeoutInSecond > 0) ? min(i->timeoutInSecond, timer.restSeconds()) : timer.restSeconds());
+        setTimeLimitInSecond((i->timeoutInSecond > 0) ? min(i->timeoutInSecond, getRestSeconds(timer)) : getRestSeconds(timer));
     } else {
         // multiple objective optimization.
         setOptimaOrientation();
+        // there is no chance to observe the progress of each objective, so the budget is split by weights only.
+        if (cfg.adaptiveTimeBudget) { resetTimeBudget(List<int>()); }
+        double restSeconds = getRestSeconds(timer);
         for (; i != objectives.end(); ++i) {
             totalTimeoutInSecond += max(i->timeoutInSecond, 0.0);
             setSubObjective(*i);
-            setTimeLimitInSecond(i->index, (i->timeoutInSecond > 0) ? min(i->timeoutInSecond, timer.restSeconds()) : timer.restSeconds());
+            double timeout = cfg.adaptiveTimeBudget ? timeBudget.getStaticShare(restSeconds, i->index) : restSeconds;
+            setTimeLimitInSecond(i->index, (i->timeoutInSecond > 0) ? min(i->timeoutInSecond, timeout) : timeout);
         }
     }
 
@@ -104,6 +865,16 @@ bool MpSolverGurobi::optimizeWithManualMultiObjective() {
     sort(objOrders.begin(), objOrders.end(),
         [this](int l, int r) { return (objectives[l].priority < objectives[r].priority); });
 
+    // the time limit of each objective resets the timer, so the global deadline is kept separately.
+    Timer totalTimer(timer);
+    if (cfg.adaptiveTimeBudget) {
+        resetTimeBudget(objOrders);
+        activeEvent->onMipProgress = [this](MpEvent &e) {
+            if (timeBudget.shouldStop(subObjTimer.elapsedSeconds(), e.getGap())) { e.stop(); }
+        };
+        installCallback(activeEvent);
+    }
+
     bool isSolved = false; // in case all objectives are constant which will be skipped.
     for (auto o = objOrders.begin(); o != objOrders.end(); ++o) {
         SubObjective &subObj(objectives[*o]);
@@ -111,7 +882,12 @@ bool MpSolverGurobi::optimizeWithManualMultiObjective() {
             Log(LogSwitch::Szx::MpSolver) << "obj[" << subObj.priority << "].opt = " << subObj.expr.getValue() << endl;
             continue;
         }
-        double restSeconds = (subObj.timeoutInSecond > 0) ? min(subObj.timeoutInSecond, timer.restSeconds()) : timer.restSeconds();
+        double restSeconds = (subObj.timeoutInSecond > 0) ? min(subObj.timeoutInSecond, getRestSeconds(timer)) : getRestSeconds(timer);
+        if (cfg.adaptiveTimeBudget) {
+            const TimeBudgetScheduler::Allocation &allocation(timeBudget.beginLevel(getRestSeconds(totalTimer), subObj.timeoutInSecond));
+            Log(LogSwitch::Szx::MpSolver) << "obj[" << subObj.priority << "].budget = " << allocation.softSeconds << "/" << allocation.hardSeconds << endl;
+            restSeconds = allocation.hardSeconds;
+        }
         if (restSeconds <= 0) { return reportStatus(status); }
         setTimeLimitInSecond(restSeconds);
         subObjTimer = Timer(Timer::toMillisecond(restSeconds));
@@ -131,20 +907,38 @@ bool MpSolverGurobi::optimizeWithManualMultiObjective() {
         if (isObjCutOffAdded) { continue; }
         double tolerance = max(abs(optimalValue * subObj.relTolerance), subObj.absTolerance);
         if (subObj.optimaOrientation == Maximize) {
-            addConstraint(subObj.expr >= optimalValue - tolerance);
+            addConstraint(subObj.expr, GreaterEqual, optimalValue - tolerance);
         } else if (subObj.optimaOrientation == Minimize) {
-            addConstraint(subObj.expr <= optimalValue + tolerance);
+            addConstraint(subObj.expr, LessEqual, optimalValue + tolerance);
         }
     }
     if (!isSolved) { return reportStatus(solve()); }
     return true;
 }
 
+void MpSolverGurobi::resetTimeBudget(const List<int> &objOrders) {
+    List<double> weights;
+    if (objOrders.empty()) { // in the order of index.
+        for (auto i = objectives.begin(); i != objectives.end(); ++i) { weights.push_back(i->budgetWeight); }
+    } else { // skip the constant objectives since they will not be solved.
+        for (auto o = objOrders.begin(); o != objOrders.end(); ++o) {
+            if (!isConstant(objectives[*o].expr)) { weights.push_back(objectives[*o].budgetWeight); }
+        }
+    }
+    timeBudget.reset(weights);
+}
+
 bool MpSolverGurobi::optimizeInPriorityMode(bool useGurobiMultiObjectiveMode) {
     return (useGurobiMultiObjectiveMode ? optimizeWithGurobiMultiObjective() : optimizeWithManualMultiObjective());
 }
 
 bool MpSolverGurobi::optimizeInWeightMode(double radix, int offset) {
+    setObjective(getWeightedObjective(radix, offset), Maximize);
+    setTimeLimitInSecond(cfg.timeoutInSecond);
+    return reportStatus(solve());
+}
+
+MpSolverGurobi::LinearExpr MpSolverGurobi::getWeightedObjective(double radix, int offset) const {
     LinearExpr objectiveExpr = 0;
     List<int> objOrders; // objectives[objOrders[i]] is the i_th prioritized objective.
     int objCount = getObjectiveCount();
@@ -155,7 +949,7 @@ bool MpSolverGurobi::optimizeInWeightMode(double radix, int offset) {
 
     int i = objCount + offset - 1;
     for (auto o = objOrders.begin(); o != objOrders.end(); ++o, --i) {
-        SubObjective &subObj(objectives[*o]);
+        const SubObjective &subObj(objectives[*o]);
         double weight = pow(radix, i);
         if (subObj.optimaOrientation == Maximize) {
             objectiveExpr += (weight * subObj.expr);
@@ -163,19 +957,52 @@ bool MpSolverGurobi::optimizeInWeightMode(double radix, int offset) {
             objectiveExpr -= (weight * subObj.expr);
         }
     }
-    setObjective(objectiveExpr, Maximize);
-    setTimeLimitInSecond(cfg.timeoutInSecond);
-    return reportStatus(solve());
+    return objectiveExpr;
 }
 
 bool MpSolverGurobi::optimize() {
+    if (cfg.enableScaling && !scaled) { scale(); }
+
     // non-objective optimization.
     if (objectives.empty()) { return reportStatus(solve()); }
 
     // single/multi-objective optimization.
     Log(LogSwitch::Szx::MpSolver) << "objectives.size() = " << getObjectiveCount() << endl;
 
-    return (cfg.inPriorityMode ? optimizeInPriorityMode() : optimizeInWeightMode());
+    bool isSolved = (cfg.inPriorityMode ? optimizeInPriorityMode() : optimizeInWeightMode());
+    activeEvent->onMipProgress = OnMipProgress(); // the time budget only takes effect in the current optimization.
+    return isSolved;
+}
+
+MpSolverGurobi::AsyncHandle MpSolverGurobi::optimizeAsync(const CancellationToken &cancellation) {
+    // the handle cancels a child, so that it only stops this optimization.
+    shared_ptr<AsyncState> state(make_shared<AsyncState>(cancellation.createChild()));
+    activeEvent->async = state;
+    installCallback(activeEvent);
+
+    future<bool> result = async(launch::async, [this, state]() {
+        bool isSolved = false;
+        try {
+            if (!state->cancellation.isCancelled()) { isSolved = optimize(); }
+        } catch (...) {
+            finishAsync(*state);
+            throw;
+        }
+        finishAsync(*state);
+        return isSolved;
+    });
+    return AsyncHandle(state, move(result));
+}
+
+void MpSolverGurobi::finishAsync(AsyncState &state) {
+    activeEvent->async.reset();
+    try {
+        state.solutionCount = getSolutionCount();
+        if (state.solutionCount > 0) { state.bestObj = getObjectiveValue(); }
+        state.bestBound = getBestBound();
+    } catch (GRBException &) {} // no solution or bound is available.
+    state.status = status;
+    state.isDone = true;
 }
 
 }
\ No newline at end of file
@@ -18,10 +18,17 @@
 #include <iostream>
 #include <functional>
 #include <limits>
+#include <memory>
+#include <atomic>
+#include <future>
 
 #include "Common.h"
 #include "Utility.h"
 #include "MpSolverBase.h"
+#include "TimeBudgetScheduler.h"
+#include "Presolver.h"
+#include "ConditioningAnalyzer.h"
+#include "MpModelData.h"
 
 #include "gurobi_c++.h"
 
@@ -48,6 +55,12 @@
 #pragma comment(lib, RESOLVED_STRINGIFY(RESOLVED_CONCAT2(gurobi_c++, LINK_TYPE, _CC_VERSION)))
 #pragma endregion AutoLinking
 
+#pragma region FeatureCheck
+/// the general constraints which are reformulated by the wrapper if the linked version lacks them.
+#define GUROBI_NATIVE_INDICATOR  (GUROBI_VERSION >= 70)
+#define GUROBI_NATIVE_PIECEWISE_LINEAR  (GUROBI_VERSION >= 90)
+#pragma endregion FeatureCheck
+
 
 namespace szx {
 
@@ -61,6 +74,11 @@ public:
 
     enum OptimaOrientation { Minimize = GRB_MINIMIZE, Maximize = GRB_MAXIMIZE };
 
+    enum ConstraintSense { LessEqual = GRB_LESS_EQUAL, GreaterEqual = GRB_GREATER_EQUAL, Equal = GRB_EQUAL };
+
+    // at most one (Sos1) or two adjacent (Sos2) variables in the order of the weights are nonzero.
+    enum SosType { Sos1 = GRB_SOS_TYPE1, Sos2 = GRB_SOS_TYPE2 };
+
     // status for the most recent optimization.
     enum ResultStatus {
         Optimal,         // GRB_OPTIMAL
@@ -111,6 +129,14 @@ public:
         DefaultIisMethod = -1
     };
 
+    enum LpMethod {
+        PrimalSimplex = 0, // prefered when re-solving after adding columns.
+        DualSimplex = 1,   // prefered when re-solving after adding rows or changing bounds.
+        Barrier = 2,
+        ConcurrentLp = 3,
+        DefaultLpMethod = -1
+    };
+
     static constexpr int MaxInt = GRB_MAXINT;
     static constexpr double MaxReal = GRB_INFINITY;
     static constexpr double Infinity = GRB_INFINITY;
@@ -137,6 +163,7 @@ public:
     using Constraint = GRBConstr;
     using LinearExpr = GRBLinExpr;
     using LinearRange = GRBTempConstr;
+    using SpecialOrderedSet = GRBSOS;
 
     using Millisecond = long long;
 
@@ -149,6 +176,8 @@ public:
     using OnMipSln = std::function<void(MpEvent&)>;
     // on visiting an MIP node during optimization.
     using OnMipNode = std::function<void(MpEvent&)>;
+    // on polling the progress of MIP search during optimization.
+    using OnMipProgress = std::function<void(MpEvent&)>;
 
     struct Configuration {
         static constexpr InternalSolver DefaultSolver = InternalSolver::GurobiMip;
@@ -160,15 +189,19 @@ public:
         static constexpr int DefaultObjectiveWeightOffset = -1; // the weight of the objective with the lowest priority is 10^(-1).
 
         static constexpr bool DefaultOutputState = false;
+        static constexpr bool DefaultNameState = true; // keep the names given to addVar() and addConstraint*().
+        static constexpr bool DefaultScalingState = false; // scale the model before the first optimization.
 
         static constexpr bool DefaultMultiObjMode = true; // true for priority, false for weight.
         static constexpr bool EnableCallbackForEachObj = true; // allow preprocess/postprocess for each obj in priority mode.
+        static constexpr bool DefaultAdaptiveTimeBudget = false; // split the total timeout across objectives in priority mode.
 
         static constexpr double Forever = MaxInt;
 
         Configuration(InternalSolver type = DefaultSolver, double timeoutInSec = Forever,
             bool usePriorityMode = Configuration::DefaultMultiObjMode, bool shouldEnableOutput = DefaultOutputState)
-            : internalSolver(type), timeoutInSecond(timeoutInSec), inPriorityMode(usePriorityMode), enableOutput(shouldEnableOutput) {}
+            : internalSolver(type), timeoutInSecond(timeoutInSec), inPriorityMode(usePriorityMode), enableOutput(shouldEnableOutput),
+            adaptiveTimeBudget(DefaultAdaptiveTimeBudget), enableNames(DefaultNameState), enableScaling(DefaultScalingState) {}
 
         friend std::ostream& operator<<(std::ostream &os, const Configuration &cfg) {
             return os << "grb" << "." << (cfg.inPriorityMode ? "P" : "W");
@@ -178,6 +211,9 @@ public:
         double timeoutInSecond; // total timeout.
         bool inPriorityMode; // or in weight mode.
         bool enableOutput;
+        bool adaptiveTimeBudget; // schedule the time of each objective by weights and progress in priority mode.
+        bool enableNames; // or only name the items by the patterns when the names are queried or the model is written.
+        bool enableScaling; // call scale() in optimize() if the model is not scaled yet.
     };
 
     struct SubObjective {
@@ -190,6 +226,144 @@ public:
         double timeoutInSecond; // this will overwrite total timeout if it is greater than 0.
         OnOptimaFound postprocess; // invoked after this sub-objective is solved in priority mode.
         OnSolveBegin preprocess; // invoked before this sub-objective begin solving in priority mode.
+        double budgetWeight; // the share of the total timeout with adaptive time budget in priority mode.
+    };
+
+    // the result of completing a partial initial solution.
+    struct PartialStartReport {
+        bool isCompleted = false; // all variables get their initial values from the completion.
+        int knownVarNum = 0;
+        double repairSeconds = 0; // the time spent on the completion sub-solve.
+    };
+
+    // the block of items added consecutively from the first one, which is named by the pattern on demand.
+    template<typename T>
+    struct NamedBlock {
+        T first;
+        NamePattern pattern;
+        bool isApplied; // the names have been written into the model.
+    };
+
+    // recover the values of the merged columns after presolve, and unscale the values of the scaled columns.
+    struct Postsolve {
+        bool empty() const { return (groups.empty() && colScales.empty()); }
+
+        // the items added after scaling are not scaled.
+        double getColScale(int index) const {
+            return ((index < 0) || (index >= static_cast<int>(colScales.size()))) ? 1 : colScales[index];
+        }
+        double getRowScale(int index) const {
+            return ((index < 0) || (index >= static_cast<int>(rowScales.size()))) ? 1 : rowScales[index];
+        }
+        // the expression on the scaled columns which equals to the given one on the original columns.
+        LinearExpr toScaled(const LinearExpr &expr) const;
+
+        bool isMerged(int index) const {
+            return (index >= 0) && (index < static_cast<int>(groupIndices.size())) && (groupIndices[index] >= 0);
+        }
+        // the expression on the kept columns which equals to the given one on the original columns, where the columns
+        // of a group must have the same coefficient, e.g., in the objectives, since they are identical in the reduced model.
+        // it throws MpException if the expression tells the columns of a group apart.
+        LinearExpr toReduced(const LinearExpr &expr, const char *method) const;
+        // the value of the kept column of the g_th group, where the columns absent in values stay at their anchors.
+        double getMergedSum(int g, const Map<int, double> &values) const;
+
+        // getRawValue(var) returns the value of var in the reduced and scaled model.
+        template<typename GetRawValue>
+        double getValue(const DecisionVar &var, GetRawValue getRawValue) const {
+            auto getUnscaledValue = [&](const DecisionVar &v) { return getRawValue(v) * getColScale(v.index()); };
+            int index = var.index();
+            if ((index < 0) || (index >= static_cast<int>(groupIndices.size())) || (groupIndices[index] < 0)) {
+                return getUnscaledValue(var);
+            }
+            int g = groupIndices[index];
+            List<double> values;
+            Presolver::splitMergedValue(getUnscaledValue(keptVars[g]), groups[g], values);
+            return values[groupPositions[index]];
+        }
+
+        List<Presolver::ColumnGroup> groups;
+        List<DecisionVar> keptVars; // keptVars[g] represents the sum of the g_th group in the reduced model.
+        List<int> groupIndices; // groupIndices[v] is the group which variable v is merged into, or -1.
+        List<int> groupPositions; // groupPositions[v] is the position of variable v in its group.
+
+        // the value of column v in the scaled model is (x[v] / colScales[v]), and row r is multiplied by rowScales[r].
+        // they are empty if the model is not scaled.
+        List<double> colScales;
+        List<double> rowScales;
+    };
+
+    // the progress of an asynchronous optimization shared by the solving thread and its handle.
+    struct AsyncState {
+        AsyncState(const CancellationToken &token) : cancellation(token) {}
+
+        CancellationToken cancellation;
+        std::atomic<int> status = { ResultStatus::Proceeding };
+        std::atomic<double> bestObj = { Undefined };
+        std::atomic<double> bestBound = { Undefined };
+        std::atomic<int> solutionCount = { 0 };
+        std::atomic<bool> isDone = { false };
+    };
+
+    struct AsyncProgress {
+        ResultStatus status;
+        double bestObj;
+        double bestBound;
+        int solutionCount;
+        bool isDone;
+    };
+
+    // the handle of an asynchronous optimization, which cancels and waits for it on destruction.
+    class AsyncHandle {
+    public:
+        AsyncHandle() {}
+        AsyncHandle(const std::shared_ptr<AsyncState> &asyncState, std::future<bool> &&asyncResult)
+            : state(asyncState), result(std::move(asyncResult)) {}
+        AsyncHandle(AsyncHandle &&) = default;
+        // the optimization of this handle is cancelled and waited for as on destruction before taking the other.
+        AsyncHandle& operator=(AsyncHandle &&other) {
+            if (this == &other) { return *this; }
+            stop();
+            state = std::move(other.state);
+            result = std::move(other.result);
+            return *this;
+        }
+        ~AsyncHandle() { stop(); }
+
+        // the incumbent, bound and status so far, which is Ready if the handle refers to no optimization.
+        AsyncProgress poll() const {
+            if (!state) { return { ResultStatus::Ready, Undefined, Undefined, 0, true }; }
+            return { static_cast<ResultStatus>(state->status.load()), state->bestObj.load(),
+                state->bestBound.load(), state->solutionCount.load(), state->isDone.load() };
+        }
+
+        // request the optimization to stop at the next callback, which is thread-safe.
+        void cancel() { if (state) { state->cancellation.cancel(); } }
+
+        // returns true if the optimization ends in the duration or before the deadline, or there is no optimization.
+        bool waitFor(double seconds) const {
+            if (!result.valid()) { return true; }
+            return (result.wait_for(std::chrono::duration<double>(seconds)) == std::future_status::ready);
+        }
+        bool waitUntil(const CancellationToken::TimePoint &deadline) const {
+            if (!result.valid()) { return true; }
+            return (result.wait_until(deadline) == std::future_status::ready);
+        }
+
+        // wait for the end and return the result of optimize(), or rethrow its exception.
+        // returns false if there is no optimization or its result has been taken.
+        bool get() { return result.valid() && result.get(); }
+
+    protected:
+        void stop() {
+            if (!result.valid()) { return; }
+            cancel();
+            result.wait();
+        }
+
+
+        std::shared_ptr<AsyncState> state;
+        std::future<bool> result;
     };
 
     class MpEvent : public GRBCallback {
@@ -197,14 +371,35 @@ public:
         friend MpSolverGurobi;
 
         MpEvent(OnMipSln onMipSolutionFound = OnMipSln(), OnMipNode onMipNodeVisited = OnMipNode())
-            : onMipSln(onMipSolutionFound), onMipNode(onMipNodeVisited) {}
+            : onMipSln(onMipSolutionFound), onMipNode(onMipNodeVisited), postsolve(nullptr) {}
 
     public:
-        using GRBCallback::addCut;
-        using GRBCallback::addLazy;
+        // the callback locations which a handler of setEventHandler() subscribes to.
+        enum Event {
+            MipProgress = (1 << GRB_CB_MIP),
+            MipSolution = (1 << GRB_CB_MIPSOL),
+            MipNode = (1 << GRB_CB_MIPNODE)
+        };
+
+        // the rows are given on the original columns, and they are scaled before added if the columns are scaled.
+        // the terms on the columns merged by presolve are moved onto the kept columns as addConstraint() does.
+        void addCut(const LinearExpr &expr, char sense, double rhs) { GRBCallback::addCut(toReduced(expr, "addCut"), sense, rhs); }
+        void addLazy(const LinearExpr &expr, char sense, double rhs) { GRBCallback::addLazy(toReduced(expr, "addLazy"), sense, rhs); }
+        // the terms of the range are inaccessible, so they throw MpException if the columns are merged or scaled.
+        void addCut(const LinearRange &r) {
+            checkRange("addCut");
+            GRBCallback::addCut(r);
+        }
+        void addLazy(const LinearRange &r) {
+            checkRange("addLazy");
+            GRBCallback::addLazy(r);
+        }
         void stop() { abort(); }
 
-        double getValue(const DecisionVar &var) { return getSolution(var); }
+        double getValue(const DecisionVar &var) {
+            if (!postsolve || postsolve->empty()) { return getSolution(var); }
+            return postsolve->getValue(var, [this](const DecisionVar &v) { return getSolution(v); });
+        }
         double getValue(const LinearExpr &expr) {
             double value = expr.getConstant();
             int itemNum = static_cast<int>(expr.size());
@@ -214,9 +409,23 @@ public:
             return value; // OPTIMIZE[szx][9]: try `return expr.getValue();`?
         }
         bool isTrue(const DecisionVar &var) { return (getValue(var) > 0.5); }
-        double getRelaxedValue(const DecisionVar &var) { return getNodeRel(var); }
+        double getRelaxedValue(const DecisionVar &var) {
+            if (!postsolve || postsolve->empty()) { return getNodeRel(var); }
+            return postsolve->getValue(var, [this](const DecisionVar &v) { return getNodeRel(v); });
+        }
 
-        void setValue(DecisionVar &var, double value) { setSolution(var, value); }
+        // the kept column of a merged group is set to the sum of the values given to its columns in the current callback.
+        void setValue(DecisionVar &var, double value) {
+            int index = var.index();
+            if (!postsolve || !postsolve->isMerged(index)) {
+                setSolution(var, (postsolve ? (value / postsolve->getColScale(index)) : value));
+                return;
+            }
+            mergedValues[index] = value;
+            int g = postsolve->groupIndices[index];
+            DecisionVar kept(postsolve->keptVars[g]);
+            setSolution(kept, postsolve->getMergedSum(g, mergedValues) / postsolve->getColScale(kept.index()));
+        }
         //using GRBCallback::useSolution;
 
         double getObj() { return getDoubleInfo(GRB_CB_MIPSOL_OBJ); }
@@ -248,17 +457,115 @@ public:
             }
             return std::numeric_limits<double>::quiet_NaN();
         }
+        double getGap() { return relativeGap(getBestObj(), getBestBound()); }
 
         void callback() {
+            mergedValues.clear();
+            if (!control()) { return; }
             if (where == GRB_CB_MIPSOL) {
                 if (onMipSln) { onMipSln(*this); }
             } else if (where == GRB_CB_MIPNODE) {
                 if (onMipNode) { onMipNode(*this); }
+            } else if (where == GRB_CB_MIP) {
+                if (onMipProgress) { onMipProgress(*this); }
             }
         }
 
         OnMipSln onMipSln;
         OnMipNode onMipNode;
+        OnMipProgress onMipProgress;
+
+        const Postsolve *postsolve;
+        Map<int, double> mergedValues; // the values given to setValue() on the merged columns in the current callback.
+        std::shared_ptr<AsyncState> async;
+
+        // the token of the caller which stops every optimization of this solver.
+        bool isCancellable = false;
+        CancellationToken cancellation;
+
+    protected:
+        LinearExpr toReduced(const LinearExpr &expr, const char *method) const {
+            return postsolve ? postsolve->toScaled(postsolve->toReduced(expr, method)) : expr;
+        }
+        void checkRange(const char *method) const {
+            if (postsolve && !postsolve->empty()) { throw MpException(String(method) + "() with a range is unavailable on the merged or scaled columns."); }
+        }
+
+        // the cancellation, the asynchronous handle or the time budget requires the callbacks of all locations.
+        bool isControlled() const { return (isCancellable || async || onMipProgress); }
+
+        // stop on cancellation and report the progress to the asynchronous handle.
+        // returns false if the optimization is stopped.
+        bool control() {
+            if (isCancellable && cancellation.isCancelled()) {
+                abort();
+                return false;
+            }
+            return (!async || updateAsync());
+        }
+
+        // take over the handlers and the control state of the replaced event.
+        void inherit(const MpEvent &e) {
+            onMipSln = e.onMipSln;
+            onMipNode = e.onMipNode;
+            onMipProgress = e.onMipProgress;
+            postsolve = e.postsolve;
+            async = e.async;
+            isCancellable = e.isCancellable;
+            cancellation = e.cancellation;
+        }
+
+        // report the progress to the asynchronous handle and stop on cancellation.
+        // returns false if the optimization is stopped.
+        bool updateAsync() {
+            if (where == GRB_CB_MIP) {
+                async->bestObj.store(getDoubleInfo(GRB_CB_MIP_OBJBST));
+                async->bestBound.store(getDoubleInfo(GRB_CB_MIP_OBJBND));
+                async->solutionCount.store(getIntInfo(GRB_CB_MIP_SOLCNT));
+            }
+            if (!async->cancellation.isCancelled()) { return true; }
+            abort();
+            return false;
+        }
+    };
+
+    // the event whose handler is bound at compile time, so that the handler can be inlined into the callback and
+    // the callbacks of the locations not subscribed by Handler::Events return at once.
+    template<typename Handler>
+    class MpEventSink : public MpEvent {
+    public:
+        MpEventSink(Handler &eventHandler) : handler(eventHandler) {}
+
+        void callback() override {
+            mergedValues.clear();
+            bool isSubscribed = (((Handler::Events >> where) & 1) != 0);
+            if (!isSubscribed && !isControlled()) { return; }
+            if (!control()) { return; }
+            if ((where == GRB_CB_MIP) && onMipProgress) { onMipProgress(*this); } // the time budget of the solver.
+            if (!isSubscribed) { return; }
+            if (where == GRB_CB_MIPSOL) {
+                dispatchMipSolution(HasEvent<Event::MipSolution>());
+            } else if (where == GRB_CB_MIPNODE) {
+                dispatchMipNode(HasEvent<Event::MipNode>());
+            } else if (where == GRB_CB_MIP) {
+                dispatchMipProgress(HasEvent<Event::MipProgress>());
+            }
+        }
+
+    protected:
+        template<int E>
+        using HasEvent = std::integral_constant<bool, ((Handler::Events & E) != 0)>;
+
+        // the members of the handler for the locations not subscribed are not required.
+        void dispatchMipSolution(std::true_type) { handler.onMipSolution(*this); }
+        void dispatchMipSolution(std::false_type) {}
+        void dispatchMipNode(std::true_type) { handler.onMipNode(*this); }
+        void dispatchMipNode(std::false_type) {}
+        void dispatchMipProgress(std::true_type) { handler.onMipProgress(*this); }
+        void dispatchMipProgress(std::false_type) {}
+
+
+        Handler &handler;
     };
     #pragma endregion Type
 
@@ -266,10 +573,13 @@ public:
 public:
     MpSolverGurobi();
     MpSolverGurobi(Configuration &config);
+    // the events and the postsolve they refer to are owned by the solver, so it is neither copyable nor movable.
+    MpSolverGurobi(const MpSolverGurobi&) = delete;
+    MpSolverGurobi& operator=(const MpSolverGurobi&) = delete;
 
     void loadModel(const String &inputPath) { model.read(inputPath); }
     void saveModel(const String &outputPath) {
-        updateModel();
+        applyNamePatterns();
         model.write(outputPath);
     }
 
@@ -285,7 +595,38 @@ public:
 
     #pragma region Method
 public:
+    // build the model from the flat layout in bulk, which should be called on an empty model.
+    // throws MpException if the rows are out of order or refer to nonexistent columns.
+    void load(const MpModelView &view);
+    // write the status, objective, bound and variable values into the solution area of the layout,
+    // where the values are the same as getValue() in the original model.
+    // throws MpException if the layout has a different number of variables.
+    void saveSolution(MpModelView &view);
+    // dump the model into the flat layout, which is the reverse of load().
+    // the objective is the one added by addObjective() if there is any, or the objective coefficients of the variables.
+    // throws MpException if there are multiple objectives or the model is not linear.
+    // also throws MpException after presolve() or scale(), since the reduced and scaled model in the backend
+    // does not match the original units of getValue(), setBounds() and the other methods.
+    void save(MpModelData &data);
+    // returns false if there is any SOS, general or quadratic constraint or objective, which the flat layout can not hold.
+    bool isLinear() {
+        updateModel();
+        return (model.get(GRB_IntAttr_NumSOS) == 0) && (model.get(GRB_IntAttr_NumGenConstrs) == 0)
+            && (model.get(GRB_IntAttr_NumQConstrs) == 0) && (model.get(GRB_IntAttr_NumQNZs) == 0);
+    }
+
     bool optimize();
+    // run optimize() on another thread, which can be polled, waited or cancelled through the handle
+    // or the cancellation token. the solver must not be touched until the optimization ends.
+    AsyncHandle optimizeAsync(const CancellationToken &cancellation = CancellationToken());
+
+    // stop the optimizations once the token is cancelled, and never run beyond its deadline.
+    // a child of the token of the caller should be given, so that cancelling it does not stop the caller.
+    void setCancellationToken(const CancellationToken &cancellation) {
+        activeEvent->cancellation = cancellation;
+        activeEvent->isCancellable = true;
+        installCallback(activeEvent);
+    }
 
     void tune(const String &outputPath = DefaultParameterPath) {
         try {
@@ -302,32 +643,150 @@ public:
         try {
             model.set(GRB_IntParam_IISMethod, IisMethod::SmallIis);
             model.computeIIS();
+            applyNamePatterns();
             model.write(outputPath);
         } catch (GRBException&) {
             status = ResultStatus::Error;
         }
     }
 
+    // find an irreducible inconsistent subsystem in memory, and return the indices of its constraints, lower bounds
+    // and upper bounds. the subsystem may not be minimal if it is stopped by the time limit or terminate().
+    // returns false if there is no subsystem found, e.g., the model is feasible.
+    bool computeIIS(IisMethod method, List<int> &constraintIndices, List<int> &lbIndices, List<int> &ubIndices, bool &isMinimal);
+
+    // stop the ongoing optimization or IIS computation, which is the only method that can be called from other threads.
+    void terminate() { model.terminate(); }
+
     // status.
     static bool reportStatus(ResultStatus status);
+    ResultStatus getStatus() const { return status; }
     Millisecond getDuration() const { return static_cast<Millisecond>(timer.elapsedSeconds() * MillisecondsPerSecond); }
 
     // decisions.
     DecisionVar addVar(VariableType type, double lb = 0, double ub = 1, double objCoef = 0, const String &name = "") {
-        return model.addVar(lb, ub, objCoef, static_cast<char>(type), name);
+        return model.addVar(lb, ub, objCoef, static_cast<char>(type), (cfg.enableNames ? name : String()));
+    }
+    // add a variable with its coefficients in the existing constraints.
+    // the objective coefficient is also appended to the objIndex_th objective if there is any.
+    DecisionVar addColumn(VariableType type, double lb, double ub, double objCoef,
+        const List<Constraint> &constraints, const List<double> &coefs, const String &name = "", int objIndex = 0) {
+        GRBColumn column;
+        if (postsolve.rowScales.empty()) {
+            column.addTerms(coefs.data(), constraints.data(), static_cast<int>(constraints.size()));
+        } else { // the new column is not scaled while the rows may be.
+            for (size_t i = 0; i < constraints.size(); ++i) { column.addTerm(coefs[i] * getRowScale(constraints[i]), constraints[i]); }
+        }
+        DecisionVar var = model.addVar(lb, ub, objCoef, static_cast<char>(type), column, (cfg.enableNames ? name : String()));
+        if (objIndex < getObjectiveCount()) { objectives[objIndex].expr += objCoef * var; }
+        return var;
+    }
+
+    // [Tune] name the block of pattern.size() variables or constraints added consecutively from the first one,
+    //        without formatting any name until they are queried by getName() or written by saveModel() or computeIIS().
+    //        with the names disabled in the configuration, the items are named only by the patterns.
+    void setNamePattern(const DecisionVar &first, const NamePattern &pattern) { varNames.push_back({ first, pattern, false }); }
+    void setNamePattern(const Constraint &first, const NamePattern &pattern) { constraintNames.push_back({ first, pattern, false }); }
+    // write the names of all blocks into the model.
+    void applyNamePatterns();
+
+    String getName(const DecisionVar &var) const {
+        String name;
+        return formatName(varNames, var.index(), name) ? name : var.get(GRB_StringAttr_VarName);
+    }
+    String getName(const Constraint &constraint) const {
+        String name;
+        return formatName(constraintNames, constraint.index(), name) ? name : constraint.get(GRB_StringAttr_ConstrName);
+    }
+
+    VariableType getType(const DecisionVar &var) const { return static_cast<VariableType>(var.get(GRB_CharAttr_VType)); }
+    void setType(DecisionVar &var, VariableType type) { var.set(GRB_CharAttr_VType, static_cast<char>(type)); }
+
+    double getLowerBound(const DecisionVar &var) const { return toOriginalValue(var.get(GRB_DoubleAttr_LB), getColScale(var)); }
+    double getUpperBound(const DecisionVar &var) const { return toOriginalValue(var.get(GRB_DoubleAttr_UB), getColScale(var)); }
+    // the coefficient in the objective of the model without any objective added by addObjective(), e.g., the loaded ones.
+    double getObjCoef(const DecisionVar &var) const { return var.get(GRB_DoubleAttr_Obj) / getColScale(var); }
+    void setObjCoef(DecisionVar &var, double coef) { var.set(GRB_DoubleAttr_Obj, coef * getColScale(var)); }
+
+    // [Tune] the batched modifications are set through array attributes and take effect together in the next update
+    //        or optimization, which keeps the basis of the last solve as the warm start of the re-solve.
+    //        they throw MpException if the given lists differ in size.
+    void setBounds(const List<DecisionVar> &vars, const List<double> &lbs, const List<double> &ubs) {
+        checkSize("setBounds", vars.size(), lbs.size());
+        checkSize("setBounds", vars.size(), ubs.size());
+        for (auto v = vars.begin(); v != vars.end(); ++v) { checkUnmerged(*v, "setBounds"); }
+        int varNum = static_cast<int>(vars.size());
+        if (postsolve.colScales.empty()) {
+            model.set(GRB_DoubleAttr_LB, vars.data(), lbs.data(), varNum);
+            model.set(GRB_DoubleAttr_UB, vars.data(), ubs.data(), varNum);
+            return;
+        }
+        List<double> scaledLbs(varNum);
+        List<double> scaledUbs(varNum);
+        for (int i = 0; i < varNum; ++i) {
+            scaledLbs[i] = toScaledValue(lbs[i], getColScale(vars[i]));
+            scaledUbs[i] = toScaledValue(ubs[i], getColScale(vars[i]));
+        }
+        model.set(GRB_DoubleAttr_LB, vars.data(), scaledLbs.data(), varNum);
+        model.set(GRB_DoubleAttr_UB, vars.data(), scaledUbs.data(), varNum);
+    }
+    void setRhs(const List<Constraint> &constraints, const List<double> &rhs) {
+        checkSize("setRhs", constraints.size(), rhs.size());
+        int rowNum = static_cast<int>(constraints.size());
+        if (postsolve.rowScales.empty()) {
+            model.set(GRB_DoubleAttr_RHS, constraints.data(), rhs.data(), rowNum);
+            return;
+        }
+        List<double> scaledRhs(rowNum);
+        for (int i = 0; i < rowNum; ++i) { scaledRhs[i] = rhs[i] * getRowScale(constraints[i]); }
+        model.set(GRB_DoubleAttr_RHS, constraints.data(), scaledRhs.data(), rowNum);
+    }
+    // coefs[i] is the new coefficient of cols[i] in rows[i], where 0 removes the term.
+    void changeCoeffs(const List<Constraint> &rows, const List<DecisionVar> &cols, const List<double> &coefs) {
+        checkSize("changeCoeffs", rows.size(), cols.size());
+        checkSize("changeCoeffs", rows.size(), coefs.size());
+        int entryNum = static_cast<int>(rows.size());
+        for (auto c = cols.begin(); c != cols.end(); ++c) { checkUnmerged(*c, "changeCoeffs"); }
+        if (postsolve.empty()) {
+            model.chgCoeffs(rows.data(), cols.data(), coefs.data(), entryNum);
+            return;
+        }
+        List<double> scaledCoefs(entryNum);
+        for (int i = 0; i < entryNum; ++i) { scaledCoefs[i] = coefs[i] * getRowScale(rows[i]) * getColScale(cols[i]); }
+        model.chgCoeffs(rows.data(), cols.data(), scaledCoefs.data(), entryNum);
+    }
+    // change the coefficients in the objIndex_th objective added by addObjective(),
+    // or the objective coefficients of the variables if there is no such objective.
+    void setObjCoefs(const List<DecisionVar> &vars, const List<double> &coefs, int objIndex = 0);
+    void setBounds(DecisionVar &var, double lb, double ub) {
+        checkUnmerged(var, "setBounds");
+        var.set(GRB_DoubleAttr_LB, toScaledValue(lb, getColScale(var)));
+        var.set(GRB_DoubleAttr_UB, toScaledValue(ub, getColScale(var)));
     }
 
-    double getValue(const LinearExpr &expr) const { return expr.getValue(); }
-    double getValue(const DecisionVar &var) const { return var.get(GRB_DoubleAttr_X); }
+    double getValue(const LinearExpr &expr) const {
+        if (postsolve.empty()) { return expr.getValue(); }
+        double value = expr.getConstant();
+        int itemNum = static_cast<int>(expr.size());
+        for (int i = 0; i < itemNum; ++i) { value += (expr.getCoeff(i) * getValue(expr.getVar(i))); }
+        return value;
+    }
+    double getValue(const DecisionVar &var) const {
+        if (postsolve.empty()) { return var.get(GRB_DoubleAttr_X); }
+        return postsolve.getValue(var, [](const DecisionVar &v) { return v.get(GRB_DoubleAttr_X); });
+    }
     double getAltValue(const DecisionVar &var, int solutionIndex) {
         setAltSolutionIndex(solutionIndex);
-        return var.get(GRB_DoubleAttr_Xn);
+        if (postsolve.empty()) { return var.get(GRB_DoubleAttr_Xn); }
+        return postsolve.getValue(var, [](const DecisionVar &v) { return v.get(GRB_DoubleAttr_Xn); });
     }
 
     using MpSolverBase::isTrue;
     bool isTrue(LinearExpr expr) const { return isTrue(getValue(expr)); }
     bool isTrue(DecisionVar var) const { return isTrue(getValue(var)); }
     int getVariableCount() const { return model.get(GRB_IntAttr_NumVars); }
+    // apply the pending modifications so that the new variables and constraints can be queried.
+    void updateModel() { model.update(); }
 
     Arr<DecisionVar> getAllVars() const {
         return Arr<DecisionVar>(getVariableCount(), model.getVars());
@@ -342,25 +801,171 @@ public:
         for (auto var = vars.begin(); var != vars.end(); ++var, ++val) { setInitValue(*var, *val); }
     }
 
+    // values[i] is the initial value of the i_th variable.
+    // the kept column of a group merged by presolve starts from the sum of the values of its group.
+    void setAllInitValues(const List<double> &values) {
+        Arr<DecisionVar> vars(getAllVars());
+        if (postsolve.empty()) {
+            model.set(GRB_DoubleAttr_Start, vars.begin(), values.data(), vars.size());
+            return;
+        }
+        List<double> reducedValues(values);
+        for (auto g = postsolve.groups.begin(); g != postsolve.groups.end(); ++g) {
+            double sum = 0;
+            bool isDefined = true;
+            for (auto c = g->cols.begin(); c != g->cols.end(); ++c) {
+                if (std::abs(values[*c]) >= Infinity) { isDefined = false; }
+                sum += values[*c];
+                reducedValues[*c] = 0; // the other columns are fixed to 0.
+            }
+            reducedValues[g->cols.front()] = isDefined ? sum : Undefined;
+        }
+        for (int v = 0; v < vars.size(); ++v) { reducedValues[v] = toScaledValue(reducedValues[v], postsolve.getColScale(v)); }
+        model.set(GRB_DoubleAttr_Start, vars.begin(), reducedValues.data(), vars.size());
+    }
+
     int getSolutionCount() const { return model.get(GRB_IntAttr_SolCount); }
 
     double getPoolObjBound() const { return model.get(GRB_DoubleAttr_PoolObjBound); }
 
     // constraints.
-    Constraint addConstraint(const LinearRange &r, const String &name = "") { return model.addConstr(r, name); }
+    // the terms of the range are inaccessible, so the model is updated to review the new row if presolve merged
+    // any columns or the columns are scaled.
+    // the terms on the columns merged by presolve are moved onto the kept columns, and they throw MpException
+    // if the row gives different coefficients to the columns of a group.
+    Constraint addConstraint(const LinearRange &r, const String &name = "") {
+        Constraint constraint = model.addConstr(r, (cfg.enableNames ? name : String()));
+        if (!postsolve.empty()) { reduceNewRow(constraint); }
+        return constraint;
+    }
+    Constraint addConstraint(const LinearExpr &expr, ConstraintSense sense, double rhs, const String &name = "") {
+        LinearExpr reducedExpr(toScaled(postsolve.toReduced(expr, "addConstraint")));
+        return model.addConstr(reducedExpr, static_cast<char>(sense), rhs, (cfg.enableNames ? name : String()));
+    }
+    // add the constraints (exprs[i] senses[i] rhs[i]) in bulk, where names is either empty or of the same size.
+    Arr<Constraint> addConstraints(const List<LinearExpr> &exprs, const List<char> &senses, const List<double> &rhs,
+        const List<String> &names = List<String>()) {
+        int rowNum = static_cast<int>(exprs.size());
+        const String *rowNames = (cfg.enableNames && !names.empty()) ? names.data() : nullptr;
+        if (postsolve.empty()) {
+            return Arr<Constraint>(rowNum, model.addConstrs(exprs.data(), senses.data(), rhs.data(), rowNames, rowNum));
+        }
+        List<LinearExpr> reducedExprs(rowNum);
+        for (int r = 0; r < rowNum; ++r) { reducedExprs[r] = toScaled(postsolve.toReduced(exprs[r], "addConstraints")); }
+        return Arr<Constraint>(rowNum, model.addConstrs(reducedExprs.data(), senses.data(), rhs.data(), rowNames, rowNum));
+    }
     void removeConstraint(Constraint constraint) { model.remove(constraint); }
     int getConstraintCount() const { return model.get(GRB_IntAttr_NumConstrs); }
 
+    Arr<Constraint> getAllConstraints() const {
+        return Arr<Constraint>(getConstraintCount(), model.getConstrs());
+    }
+    // the linear expression on the lhs of the constraint.
+    LinearExpr getRow(const Constraint &constraint) { return model.getRow(constraint); }
+    // the coefficient matrix of all constraints in CSR, where the column j is the j_th variable.
+    SparseMatrix getMatrix();
+    // add the rows of the matrix as the constraints in bulk, where the column j is vars[j].
+    Arr<Constraint> addConstraints(const SparseMatrix &matrix, const List<DecisionVar> &vars, const List<char> &senses,
+        const List<double> &rhs, const List<String> &names = List<String>());
+
+    // general constraints.
+    // [Tune] prefer them to the hand-picked big-M, since the solver branches on them directly or derives the big-M
+    //        from the bounds of the variables, which gives a tighter relaxation.
+    // the variables they refer to are frozen in presolve, which only reduces the linear rows.
+    SpecialOrderedSet addSos(SosType type, const List<DecisionVar> &vars, const List<double> &weights) {
+        frozenVars.insert(frozenVars.end(), vars.begin(), vars.end());
+        return model.addSOS(vars.data(), weights.data(), static_cast<int>(vars.size()), type);
+    }
+    // the constraint (expr sense rhs) holds if (indicator == indicatorValue), where indicator is a binary variable.
+    // without native support, it is reformulated with the big-M tightened to the activity bounds of the expression,
+    // which throws MpException if the expression is unbounded on the side to relax.
+    void addIndicator(const DecisionVar &indicator, bool indicatorValue, const LinearExpr &expr, ConstraintSense sense,
+        double rhs, const String &name = "");
+    // y = f(x) where f is the piecewise linear function through the points (xs[i], ys[i]) with nondecreasing xs.
+    // the first and the last segments are extended beyond the first and the last points as Gurobi does.
+    // without native support, it is reformulated with the SOS2 over the convex combination of the points, where the
+    // end segments are extended to the bounds of x by the time it is added, which throws MpException if x is unbounded
+    // beyond the first or the last point.
+    void addPiecewiseLinear(const DecisionVar &x, const DecisionVar &y, const List<double> &xs, const List<double> &ys,
+        const String &name = "");
+    // add f(x) into the objective of the model without any objective added by addObjective(), where f is the same as above.
+    void setPiecewiseLinearObjective(const DecisionVar &x, const List<double> &xs, const List<double> &ys) {
+        checkUnscaled("setPiecewiseLinearObjective");
+        frozenVars.push_back(x);
+        model.setPWLObj(x, static_cast<int>(xs.size()), xs.data(), ys.data());
+    }
+
+    // the bounds of the expression implied by the bounds of the variables, i.e., the tightest big-M for relaxing
+    // (expr <= rhs) is (getMaxActivity(expr) - rhs). they are infinite if any variable is unbounded on that side.
+    double getMinActivity(const LinearExpr &expr) const { return getActivity(expr, false); }
+    double getMaxActivity(const LinearExpr &expr) const { return getActivity(expr, true); }
+
+    double getRhs(const Constraint &constraint) const { return constraint.get(GRB_DoubleAttr_RHS) / getRowScale(constraint); }
+    void setRhs(Constraint &constraint, double rhs) { constraint.set(GRB_DoubleAttr_RHS, rhs * getRowScale(constraint)); }
+
+    // [Tune] the simplex basis of a solved LP for warm starting a similar LP, in the index order of the variables and
+    //        the constraints. returns false if there is no basis.
+    bool getBasis(List<int> &varBasis, List<int> &constraintBasis);
+    void setBasis(const List<int> &varBasis, const List<int> &constraintBasis);
+
+    // the dual value of the constraint in a solved LP, i.e., the rate of change of the objective on its rhs.
+    double getDual(const Constraint &constraint) const { return constraint.get(GRB_DoubleAttr_Pi) * getRowScale(constraint); }
+    void getAllDuals(const Arr<Constraint> &constraints, Arr<double> &duals) {
+        duals = Arr<double>(constraints.size(), model.get(GRB_DoubleAttr_Pi, constraints.begin(), constraints.size()));
+        if (postsolve.rowScales.empty()) { return; }
+        for (int r = 0; r < constraints.size(); ++r) { duals[r] *= getRowScale(constraints[r]); }
+    }
+    double getReducedCost(const DecisionVar &var) const { return var.get(GRB_DoubleAttr_RC) / getColScale(var); }
+    // get the multipliers y (for all constraints in index order) of an infeasible LP which make (y'Ax <= y'b) hold
+    // for all feasible x while (min{y'Ax : lb <= x <= ub} > y'b). returns false if the certificate is unavailable.
+    // the certificate is only available if it is enabled by setInfeasibilityCertificate() before solving.
+    bool getFarkasCertificate(Arr<double> &multipliers, double &minActivity);
+
+    // presolve.
+    // [Tune] reduce the model skeleton in the wrapper once for the repeated submissions with different fixings.
+    // the variables which will be fixed differently in each submission must be frozen before presolve.
+    // the removed constraints must not be accessed anymore. the values of the variables are always in the original model.
+    // the rows added afterwards are moved onto the kept columns if they give the same coefficient to the columns of
+    // each group, or throw MpException otherwise. the bounds, the coefficients and the initial values of the merged
+    // columns throw MpException, except for setAllInitValues() and the setValue() of the events, which set the kept
+    // column to the sum of its group.
+    const Presolver::Statistics& presolve();
+    void freezeInPresolve(const DecisionVar &var) { frozenVars.push_back(var); }
+    bool isPresolved() const { return presolved; }
+
+    // conditioning.
+    // report the ranges of the coefficients, the rhs, the bounds and the objectives by the families of the names,
+    // where the objectives added by addObjective() and their weighted sum in weight mode are reported separately.
+    // the scaled model is analyzed if it is scaled.
+    void analyzeConditioning(ConditioningAnalyzer::Report &report,
+        const ConditioningAnalyzer::Configuration &config = ConditioningAnalyzer::Configuration());
+    // [Tune] scale the rows and the continuous columns in place by the geometric mean scaling and the equilibration,
+    //        after the model is complete and presolved if presolve() is used. the values, relaxed values, bounds, rhs,
+    //        objective coefficients, duals and reduced costs through the methods of the solver and the events are in
+    //        the original units, and so are the rows and coefficients given to addConstraint(), addConstraints(),
+    //        addColumn(), changeCoeffs() and the addLazy() or addCut() of the events with (expr, sense, rhs).
+    //        the objective value is not affected. however, the rows got from getRow() or getMatrix() are in the
+    //        scaled units, addConstraint() with a range updates the model for each new row, the addLazy() and addCut()
+    //        with a range throw MpException, and so do the native indicator and piecewise linear constraints.
+    //        the columns are not scaled if the model is not linear (see isLinear()).
+    void scale(const ConditioningAnalyzer::Configuration &config = ConditioningAnalyzer::Configuration());
+    bool isScaled() const { return scaled; }
+
     // objectives.
     void addObjective(const LinearExpr &expr, OptimaOrientation orientation, int priority = DefaultObjectivePriority,
         double relTolerance = Configuration::DefaultObjectiveRelativeTolerance, double absTolerance = Configuration::DefaultObjectiveAbsoluteTolerance,
-        double timeoutInSecond = Configuration::Forever, OnOptimaFound postprocess = OnOptimaFound(), OnSolveBegin preprocess = OnSolveBegin()) {
+        double timeoutInSecond = Configuration::Forever, OnOptimaFound postprocess = OnOptimaFound(), OnSolveBegin preprocess = OnSolveBegin(),
+        double budgetWeight = TimeBudgetScheduler::DefaultWeight) {
         int index = getObjectiveCount();
-        objectives.push_back({ expr, orientation, index, priority, relTolerance, absTolerance, timeoutInSecond, postprocess, preprocess });
+        objectives.push_back({ expr, orientation, index, priority, relTolerance, absTolerance, timeoutInSecond, postprocess, preprocess, budgetWeight });
     }
     void clearObjectives() { objectives.clear(); }
 
     double getObjectiveValue() const { return model.get(GRB_DoubleAttr_ObjVal); }
+    // the best proven bound of the objective, which equals to the objective value for LP.
+    // the objective value of an LP is only a bound if it is solved to optimality.
+    double getBestBound() const { return isMip() ? model.get(GRB_DoubleAttr_ObjBound) : getObjectiveValue(); }
+    bool isMip() const { return (model.get(GRB_IntAttr_IsMIP) != 0); }
     double getAltObjectiveValue(int solutionIndex) {
         setAltSolutionIndex(solutionIndex);
         return model.get(GRB_DoubleAttr_PoolObjVal);
@@ -389,26 +994,54 @@ public:
     // only use it in gurobi multi-obj mode.
     void setTimeLimitInSecond(int objIndex, double second) { model.getMultiobjEnv(objIndex).set(GRB_DoubleParam_TimeLimit, (std::max)(second, 0.0)); }
 
+    // [Tune] split the total timeout across objectives by their budget weights and progress in priority mode.
+    void setAdaptiveTimeBudget(bool enable = true, const TimeBudgetScheduler::Configuration &schedulerCfg = TimeBudgetScheduler::Configuration()) {
+        cfg.adaptiveTimeBudget = enable;
+        timeBudget.cfg = schedulerCfg;
+    }
+
     void setBestObjStop(double bestObjStop) { model.set(GRB_DoubleParam_BestObjStop, bestObjStop); }
     void setBestBoundStop(double bestBoundStop) { model.set(GRB_DoubleParam_BestBdStop, bestBoundStop); }
 
     void setOutput(bool enable = Configuration::DefaultOutputState) { model.set(GRB_IntParam_OutputFlag, enable); }
 
     // the methods in MpSolver is invalid within the callback, only use the ones in MpEvent instead.
+    // [Tune] bind the handler at compile time instead of the std::function of setMipSlnEvent() and setMipNodeEvent(),
+    //        which are ignored afterwards. the handler declares the subscribed locations by a static constexpr int
+    //        `Events`, e.g., (MpEvent::MipSolution | MpEvent::MipNode), and provides the corresponding members
+    //        onMipSolution(MpEvent&), onMipNode(MpEvent&) and onMipProgress(MpEvent&). it must outlive the solver.
+    template<typename Handler>
+    void setEventHandler(Handler &handler, bool addLazy = true) {
+        if (addLazy && (Handler::Events & MpEvent::MipSolution)) { model.set(GRB_IntParam_LazyConstraints, 1); }
+        std::unique_ptr<MpEvent> sink(new MpEventSink<Handler>(handler));
+        sink->inherit(*activeEvent);
+        eventSink = std::move(sink);
+        activeEvent = eventSink.get();
+        installCallback(activeEvent);
+    }
     void setMipSlnEvent(OnMipSln onMipSln, bool addLazy = true) {
         if (addLazy) { model.set(GRB_IntParam_LazyConstraints, 1); }
-        mpEvent.onMipSln = onMipSln;
-        model.setCallback(&mpEvent);
+        activeEvent->onMipSln = onMipSln;
+        installCallback(activeEvent);
     }
     void setMipNodeEvent(OnMipSln onMipNode) {
-        mpEvent.onMipSln = onMipNode;
-        model.setCallback(&mpEvent);
+        activeEvent->onMipSln = onMipNode;
+        installCallback(activeEvent);
     }
 
     // [Tune] use the given value as the initial solution in MIP.
-    void setInitValue(DecisionVar &var, double value) { var.set(GRB_DoubleAttr_Start, value); }
+    //        it throws MpException on the columns merged by presolve, whose values are given by setAllInitValues() instead.
+    void setInitValue(DecisionVar &var, double value) {
+        checkUnmerged(var, "setInitValue");
+        var.set(GRB_DoubleAttr_Start, toScaledValue(value, getColScale(var)));
+    }
+    // [Tune] use the partial assignment as the initial solution in MIP after completing it by a sub-solve,
+    //        which fixes the known variables and stops at the first feasible solution or the time limit.
+    //        only the known values are used if no completion is found.
+    //        the status of the last optimization is kept, but its solution is discarded by the sub-solve.
+    PartialStartReport setPartialInitValues(List<DecisionVar> &vars, const List<double> &values, double timeLimitInSecond);
     // [Tune] guide the solver to prefer certain value on certain variable.
-    void setHintValue(DecisionVar &var, double value) { var.set(GRB_DoubleAttr_VarHintVal, value); }
+    void setHintValue(DecisionVar &var, double value) { var.set(GRB_DoubleAttr_VarHintVal, toScaledValue(value, getColScale(var))); }
     void setHintPrioriy(DecisionVar &var, int priority) { var.set(GRB_IntAttr_VarHintPri, priority); }
     // [Tune] guide the solver to prefer certain variable for branching.
     void setBranchPriority(DecisionVar &var, int priority) { var.set(GRB_IntAttr_BranchPriority, priority); }
@@ -419,11 +1052,25 @@ public:
     void setSymmetryDetectionMode(SymmetryDetectionMode mode) { model.set(GRB_IntParam_Symmetry, mode); }
     // [Tune] the effort on presolve.
     void setPresolveLevel(PresolveLevel level) { model.set(GRB_IntParam_Presolve, level); }
+    // [Tune] the algorithm for LP and the root relaxation of MIP.
+    void setLpMethod(LpMethod method) { model.set(GRB_IntParam_Method, method); }
 
     void setPoolingMode(PoolingMode poolingMode) { model.set(GRB_IntParam_PoolSearchMode, poolingMode); }
     void setMaxSolutionPoolSize(int maxSolutionNum) { model.set(GRB_IntParam_PoolSolutions, maxSolutionNum); }
     void setMaxSolutionRelPoolGap(double maxRelPoolGap) { model.set(GRB_DoubleParam_PoolGap, maxRelPoolGap); }
 
+    // the MIP stops as optimal once the relative or the absolute gap is no more than the given ones.
+    void setMipGap(double relGap, double absGap) {
+        model.set(GRB_DoubleParam_MIPGap, relGap);
+        model.set(GRB_DoubleParam_MIPGapAbs, absGap);
+    }
+
+    // [Tune] keep the certificate of infeasibility for LP, which is required by getFarkasCertificate().
+    void setInfeasibilityCertificate(bool enable = true) {
+        model.set(GRB_IntParam_InfUnbdInfo, enable);
+        model.set(GRB_IntParam_DualReductions, !enable); // tell infeasible from unbounded.
+    }
+
     void setMaxThread(int threadNum = AutoThreading) { model.set(GRB_IntParam_Threads, threadNum); }
 
     void setSeed(int seed) { model.set(GRB_IntParam_Seed, (seed & (std::numeric_limits<int>::max)())); }
@@ -440,20 +1087,24 @@ protected:
 
     bool optimizeWithGurobiMultiObjective();
     bool optimizeWithManualMultiObjective();
+    // prepare the weights of the objectives which will be solved in the given order.
+    void resetTimeBudget(const List<int> &objOrders);
     bool optimizeInPriorityMode(bool useGurobiMultiObjectiveMode = !Configuration::EnableCallbackForEachObj);
     bool optimizeInWeightMode(double radix = Configuration::DefaultObjectiveWeightRadix, int offset = Configuration::DefaultObjectiveWeightOffset);
+    // the sum of the objectives weighted by the powers of the radix in the order of priority, which is maximized.
+    LinearExpr getWeightedObjective(double radix = Configuration::DefaultObjectiveWeightRadix, int offset = Configuration::DefaultObjectiveWeightOffset) const;
 
     void setOptimaOrientation(OptimaOrientation optimaOrientation = DefaultObjectiveOptimaOrientation) {
         model.set(GRB_IntAttr_ModelSense, optimaOrientation);
     }
 
     void setObjective(const LinearExpr &expr, OptimaOrientation orientation) {
-        model.setObjective(expr, orientation);
+        model.setObjective(toScaled(expr), orientation);
     }
     void setSubObjective(const SubObjective subObj) {
         LinearExpr expr;
         int priority = MaxObjectivePriority - subObj.priority;
-        if (subObj.optimaOrientation == DefaultObjectiveOptimaOrientation) { expr = subObj.expr; } else { expr = (-subObj.expr); }
+        if (subObj.optimaOrientation == DefaultObjectiveOptimaOrientation) { expr = toScaled(subObj.expr); } else { expr = (-toScaled(subObj.expr)); }
         model.setObjectiveN(expr, subObj.index, priority, 1, subObj.absTolerance, subObj.relTolerance);
     }
     // determines which sub-objective will be retrieved when calling model.get(GRB_DoubleAttr_ObjNVal).
@@ -463,9 +1114,53 @@ protected:
     void setAltSolutionIndex(int solutionIndex) { model.set(GRB_IntParam_SolutionNumber, solutionIndex); }
 
     bool isConstant(const LinearExpr &expr) { return (expr.size() == 0); }
-    void updateModel() { model.update(); }
+
+    double getColScale(const DecisionVar &var) const { return postsolve.getColScale(var.index()); }
+    double getRowScale(const Constraint &constraint) const { return postsolve.getRowScale(constraint.index()); }
+    // the infinite or undefined values are kept as they are.
+    static double toScaledValue(double value, double colScale) { return (std::abs(value) >= Infinity) ? value : (value / colScale); }
+    static double toOriginalValue(double value, double colScale) { return (std::abs(value) >= Infinity) ? value : (value * colScale); }
+    LinearExpr toScaled(const LinearExpr &expr) const { return postsolve.toScaled(expr); }
+    // move the terms of the row added after presolve onto the kept columns, or remove it and throw MpException
+    // if it tells the merged columns apart, then multiply its coefficients by the scales of their columns.
+    void reduceNewRow(const Constraint &constraint);
+    // set the callback of the model and remember it, so that it can be restored after a temporary change.
+    void installCallback(GRBCallback *callback) {
+        model.setCallback(callback);
+        installedCallback = callback;
+    }
+
+    // the dropped columns of a group merged by presolve stay at 0 and the kept column carries their sum,
+    // so they can not be modified one by one.
+    void checkUnmerged(const DecisionVar &var, const char *method) const {
+        if (postsolve.isMerged(var.index())) { throw MpException(String(method) + "() on the columns merged by presolve is unavailable."); }
+    }
+    // the lists given to a batched mutator are of the same size.
+    static void checkSize(const char *method, size_t size, size_t expectedSize) {
+        if (size != expectedSize) { throw MpException(String(method) + "() requires the lists of the same size."); }
+    }
+    // the general constraints on the scaled columns can not be expressed in the original units.
+    void checkUnscaled(const char *method) const {
+        if (!postsolve.colScales.empty()) { throw MpException(String(method) + "() must be called before scale()."); }
+    }
+
+    // the rest time of the timer which is also clamped to the deadline of the token.
+    double getRestSeconds(const Timer &t) const {
+        double restSeconds = t.restSeconds();
+        return activeEvent->isCancellable ? (std::min)(restSeconds, activeEvent->cancellation.restSeconds(restSeconds)) : restSeconds;
+    }
 
     ResultStatus solve() {
+        if (!activeEvent->isCancellable) { return solveInTimeLimit(); }
+        if (activeEvent->cancellation.isCancelled()) { return (status = ResultStatus::ExceedLimit); }
+        // the time limit is clamped to the deadline of the token, so that the solver stops without polling the callback.
+        double timeLimit = model.get(GRB_DoubleParam_TimeLimit);
+        model.set(GRB_DoubleParam_TimeLimit, (std::max)((std::min)(timeLimit, activeEvent->cancellation.restSeconds(timeLimit)), 0.0));
+        solveInTimeLimit();
+        model.set(GRB_DoubleParam_TimeLimit, timeLimit);
+        return status;
+    }
+    ResultStatus solveInTimeLimit() {
         try {
             model.optimize();
             updateStatus();
@@ -480,6 +1175,55 @@ protected:
     }
 
     void updateStatus();
+    void finishAsync(AsyncState &state);
+
+    // dump the model into the flat layout with the first objective added by addObjective() if there is any.
+    void dump(MpModelData &data);
+
+    double getActivity(const LinearExpr &expr, bool isMax) const;
+    // relax (expr <= rhs) into (expr <= rhs + M * (indicator != indicatorValue)) with the tightest M.
+    void addBigM(const DecisionVar &indicator, bool indicatorValue, const LinearExpr &expr, double rhs, const String &name);
+
+    // the later block takes precedence if the blocks overlap. returns false if no block covers the index.
+    template<typename T>
+    static bool formatName(const List<NamedBlock<T>> &blocks, int index, String &name) {
+        for (auto b = blocks.rbegin(); b != blocks.rend(); ++b) {
+            int offset = index - b->first.index();
+            if ((offset < 0) || (offset >= b->pattern.size())) { continue; }
+            b->pattern.format(offset, name);
+            return true;
+        }
+        return false;
+    }
+    // the names of all items, where the ones covered by the blocks are formatted by the patterns.
+    template<typename T>
+    void getNames(const List<NamedBlock<T>> &blocks, const Arr<T> &items, GRB_StringAttr attr, List<String> &names) {
+        Arr<String> modelNames(items.size(), model.get(attr, items.begin(), items.size()));
+        names.assign(modelNames.begin(), modelNames.end());
+        if (blocks.empty()) { return; }
+        String name;
+        for (int i = 0; i < items.size(); ++i) {
+            name.clear();
+            if (formatName(blocks, i, name)) { names[i].swap(name); }
+        }
+    }
+    template<typename T>
+    void applyNamePatterns(List<NamedBlock<T>> &blocks, const Arr<T> &items, GRB_StringAttr attr) {
+        List<String> names;
+        for (auto b = blocks.begin(); b != blocks.end(); ++b) {
+            if (b->isApplied) { continue; }
+            int first = b->first.index();
+            int count = (std::min)(b->pattern.size(), items.size() - first);
+            if ((first < 0) || (count <= 0)) { continue; } // the block has been removed.
+            names.resize(count);
+            for (int i = 0; i < count; ++i) {
+                names[i].clear();
+                b->pattern.format(i, names[i]);
+            }
+            model.set(attr, items.begin() + first, names.data(), count);
+            b->isApplied = true;
+        }
+    }
     #pragma endregion Method
 
     #pragma region Field
@@ -490,6 +1234,9 @@ protected:
     // definition of the problem to solve.
     GRBModel model;
     MpEvent mpEvent;
+    std::unique_ptr<MpEvent> eventSink; // the event of the handler bound by setEventHandler().
+    GRBCallback *installedCallback = nullptr; // the callback of the model, which can not be queried from the backend.
+    MpEvent *activeEvent = &mpEvent; // the event registered to the model.
 
     Configuration cfg;
 
@@ -497,6 +1244,17 @@ protected:
     ResultStatus status;
     List<SubObjective> objectives;
 
+    TimeBudgetScheduler timeBudget;
+
+    bool presolved;
+    Presolver::Statistics presolveStat;
+    List<DecisionVar> frozenVars;
+    bool scaled;
+    Postsolve postsolve;
+
+    List<NamedBlock<DecisionVar>> varNames;
+    List<NamedBlock<Constraint>> constraintNames;
+
 public: // fields that rely on initialized cfg.
     Timer timer;
     Timer subObjTimer;
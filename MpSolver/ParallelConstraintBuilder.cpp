@@ -0,0 +1,58 @@
+#include "ParallelConstraintBuilder.h"
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+Arr<ParallelConstraintBuilder::Constraint> ParallelConstraintBuilder::build(int familyNum, Generator generate, List<int> &familyBegins) {
+    for (auto b = buffers.begin(); b != buffers.end(); ++b) { b->clear(); }
+    pool.parallelFor(0, familyNum, [&](int family, int threadIndex) {
+        RowBuffer &rows(buffers[threadIndex]);
+        int rowBegin = rows.getRowCount();
+        generate(family, rows);
+        rows.segments.push_back({ family, rowBegin, rows.getRowCount() });
+    });
+
+    // place the families in order.
+    List<const RowBuffer*> familyBuffers(familyNum);
+    List<const RowBuffer::Segment*> familySegments(familyNum);
+    familyBegins.assign(familyNum + 1, 0);
+    bool hasName = false;
+    for (auto b = buffers.begin(); b != buffers.end(); ++b) {
+        hasName |= !b->names.empty();
+        for (auto s = b->segments.begin(); s != b->segments.end(); ++s) {
+            familyBuffers[s->family] = &(*b);
+            familySegments[s->family] = &(*s);
+            familyBegins[s->family + 1] = s->rowEnd - s->rowBegin;
+        }
+    }
+    for (int f = 0; f < familyNum; ++f) { familyBegins[f + 1] += familyBegins[f]; }
+
+    // merge the rows into the expressions for the bulk insertion.
+    int rowNum = familyBegins[familyNum];
+    List<LinearExpr> exprs(rowNum);
+    List<char> senses(rowNum);
+    List<double> rhs(rowNum);
+    List<String> names(hasName ? rowNum : 0);
+    pool.parallelFor(0, familyNum, [&](int family, int) {
+        const RowBuffer &rows(*familyBuffers[family]);
+        const RowBuffer::Segment &segment(*familySegments[family]);
+        for (int r = segment.rowBegin, row = familyBegins[family]; r < segment.rowEnd; ++r, ++row) {
+            size_t begin = rows.rowBegins[r];
+            exprs[row].addTerms(rows.coefs.data() + begin, rows.vars.data() + begin, static_cast<int>(rows.rowBegins[r + 1] - begin));
+            senses[row] = rows.senses[r];
+            rhs[row] = rows.rhsList[r];
+            if (r < static_cast<int>(rows.names.size())) { names[row] = rows.names[r]; }
+        }
+    });
+    for (auto b = buffers.begin(); b != buffers.end(); ++b) { *b = RowBuffer(); } // release the memory.
+
+    Log(LogSwitch::Szx::MpSolver) << "build " << rowNum << " rows in " << familyNum << " families." << endl;
+    return model.addConstraints(exprs, senses, rhs, names);
+}
+
+}
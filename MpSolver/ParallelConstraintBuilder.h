@@ -0,0 +1,139 @@
+////////////////////////////////
+/// usage : 1.	generate independent constraint families (e.g., one per gate, flight or time slot) concurrently
+///             and add them into the model in a single bulk insertion.
+///         2.	the generators write rows into the row buffer of their worker thread instead of the model,
+///             which is not thread-safe, and the rows are merged in the order of the families.
+///
+/// note  : 1.	the generators must only read the model, e.g., use the handles of the existing variables.
+///         2.	the result is deterministic regardless of the thread number and the scheduling.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_PARALLEL_CONSTRAINT_BUILDER_H
+#define SMART_SZX_GATE_REASSIGNMENT_PARALLEL_CONSTRAINT_BUILDER_H
+
+
+#include "Config.h"
+
+#include <functional>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+
+
+namespace szx {
+
+/// the rows generated on a single thread in CSR form.
+class RowBuffer {
+public:
+    using DecisionVar = MpSolver::DecisionVar;
+    using LinearExpr = MpSolver::LinearExpr;
+
+    struct Segment {
+        int family;
+        int rowBegin;
+        int rowEnd;
+    };
+
+
+    RowBuffer() { clear(); }
+
+
+    /// add the row (expr sense rhs), where the constant of expr is moved to the rhs.
+    void add(const LinearExpr &expr, MpSolver::ConstraintSense sense, double rhs, const String &name = "") {
+        int itemNum = static_cast<int>(expr.size());
+        for (int i = 0; i < itemNum; ++i) {
+            vars.push_back(expr.getVar(i));
+            coefs.push_back(expr.getCoeff(i));
+        }
+        endRow(sense, rhs - expr.getConstant(), name);
+    }
+    /// add the row (sum(coefs[i] * vars[i]) sense rhs).
+    void add(const DecisionVar *rowVars, const double *rowCoefs, int itemNum, MpSolver::ConstraintSense sense, double rhs, const String &name = "") {
+        vars.insert(vars.end(), rowVars, rowVars + itemNum);
+        coefs.insert(coefs.end(), rowCoefs, rowCoefs + itemNum);
+        endRow(sense, rhs, name);
+    }
+
+    void clear() {
+        vars.clear();
+        coefs.clear();
+        rowBegins.assign(1, 0);
+        senses.clear();
+        rhsList.clear();
+        names.clear();
+        segments.clear();
+    }
+
+    int getRowCount() const { return static_cast<int>(senses.size()); }
+
+
+    // the entries of row r are [rowBegins[r], rowBegins[r + 1]).
+    List<DecisionVar> vars;
+    List<double> coefs;
+    List<size_t> rowBegins;
+    List<char> senses;
+    List<double> rhsList;
+    List<String> names; // only the rows before the last named row have their names.
+    List<Segment> segments; // the rows of each family generated on this thread.
+
+protected:
+    void endRow(MpSolver::ConstraintSense sense, double rhs, const String &name) {
+        rowBegins.push_back(vars.size());
+        senses.push_back(static_cast<char>(sense));
+        rhsList.push_back(rhs);
+        if (name.empty()) { return; }
+        names.resize(senses.size());
+        names.back() = name;
+    }
+};
+
+
+class ParallelConstraintBuilder {
+    #pragma region Type
+public:
+    using Constraint = MpSolver::Constraint;
+    using LinearExpr = MpSolver::LinearExpr;
+
+    struct Configuration {
+        Configuration(int threads = ThreadPool::getHardwareConcurrency()) : threadNum(threads) {}
+
+        int threadNum;
+    };
+
+    /// generate the rows of the given family into the buffer, which is invoked concurrently from different threads.
+    using Generator = std::function<void(int family, RowBuffer &rows)>;
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    ParallelConstraintBuilder(MpSolver &solver, const Configuration &config = Configuration())
+        : cfg(config), model(solver), pool(config.threadNum), buffers(pool.size()) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// generate the families [0, familyNum) and add their rows into the model in the order of the families.
+    /// the constraints of family f are [familyBegins[f], familyBegins[f + 1]) in the returned array.
+    Arr<Constraint> build(int familyNum, Generator generate, List<int> &familyBegins);
+    Arr<Constraint> build(int familyNum, Generator generate) {
+        List<int> familyBegins;
+        return build(familyNum, generate, familyBegins);
+    }
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    MpSolver &model;
+    ThreadPool pool;
+    List<RowBuffer> buffers; // buffers[t] is only written by the worker thread t.
+    #pragma endregion Field
+}; // ParallelConstraintBuilder
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_PARALLEL_CONSTRAINT_BUILDER_H
@@ -0,0 +1,382 @@
+#include "Presolver.h"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <cmath>
+
+
+using namespace std;
+
+
+namespace szx {
+
+const Presolver::Statistics& Presolver::presolve() {
+    int rowNum = model.rowNum();
+    int varNum = model.varNum();
+    int entryNum = static_cast<int>(model.cols.size());
+
+    // build the column view.
+    entryRows.resize(entryNum);
+    colBegin.assign(varNum + 1, 0);
+    for (int r = 0; r < rowNum; ++r) {
+        for (int e = model.rowBegin[r]; e < model.rowBegin[r + 1]; ++e) {
+            entryRows[e] = r;
+            ++colBegin[model.cols[e] + 1];
+        }
+    }
+    for (int c = 0; c < varNum; ++c) { colBegin[c + 1] += colBegin[c]; }
+    entryIndices.resize(entryNum);
+    List<int> colEnd(colBegin.begin(), colBegin.end() - 1);
+    for (int e = 0; e < entryNum; ++e) { entryIndices[colEnd[model.cols[e]]++] = e; }
+
+    isEntryRemoved.assign(entryNum, false);
+    isFixedVarRemoved.assign(varNum, false);
+    activeEntryNum.resize(rowNum);
+    for (int r = 0; r < rowNum; ++r) { activeEntryNum[r] = model.rowBegin[r + 1] - model.rowBegin[r]; }
+    isRowRemoved.assign(rowNum, false);
+    isRowModified.assign(rowNum, false);
+    isBoundModified.assign(varNum, false);
+
+    for (int round = 0; round < MaxRound; ++round) {
+        int reductionNum = stat.fixedVarNum + stat.singletonRowNum + stat.tightenedBoundNum;
+        removeFixedVars();
+        if (stat.isInfeasible) { return stat; }
+        removeSingletonRows();
+        if (stat.isInfeasible) { return stat; }
+        tightenImpliedBounds();
+        if (stat.isInfeasible) { return stat; }
+        if (reductionNum == stat.fixedVarNum + stat.singletonRowNum + stat.tightenedBoundNum) { break; }
+    }
+    removeFixedVars(); // the last round may fix some variables.
+    if (stat.isInfeasible) { return stat; }
+    removeDuplicateRows();
+    if (stat.isInfeasible) { return stat; }
+    mergeDuplicateCols();
+
+    return stat;
+}
+
+void Presolver::splitMergedValue(double sum, const ColumnGroup &group, List<double> &values) {
+    // start from a finite anchor in the bounds of each column, then move the rest to the columns with room.
+    int colNum = static_cast<int>(group.cols.size());
+    values.resize(colNum);
+    double rest = sum;
+    for (int i = 0; i < colNum; ++i) {
+        values[i] = getAnchorValue(group, i);
+        rest -= values[i];
+    }
+    for (int i = 0; (i < colNum) && (rest != 0); ++i) {
+        double room = (rest > 0) ? (group.ubs[i] - values[i]) : (group.lbs[i] - values[i]);
+        double delta = (rest > 0) ? (min)(room, rest) : (max)(room, rest);
+        values[i] += delta;
+        rest -= delta;
+    }
+}
+
+void Presolver::removeFixedVars() {
+    int varNum = model.varNum();
+    for (int c = 0; c < varNum; ++c) {
+        if (isFixedVarRemoved[c] || model.isFrozen[c] || !isFixed(c)) { continue; }
+        double value = model.lb[c];
+        for (int i = colBegin[c]; i < colBegin[c + 1]; ++i) {
+            int e = entryIndices[i];
+            int r = entryRows[e];
+            if (isEntryRemoved[e] || isRowRemoved[r]) { continue; }
+            modifyRow(r, model.senses[r], model.rhs[r] - model.coefs[e] * value);
+            removeEntry(e);
+        }
+        isFixedVarRemoved[c] = true;
+        ++stat.fixedVarNum;
+    }
+}
+
+void Presolver::removeSingletonRows() {
+    int rowNum = model.rowNum();
+    for (int r = 0; r < rowNum; ++r) {
+        if (isRowRemoved[r] || (activeEntryNum[r] > 1)) { continue; }
+        char sense = model.senses[r];
+        double rhs = model.rhs[r];
+        if (activeEntryNum[r] == 0) { // empty row.
+            bool isFeasible = ((sense != GreaterEqual) || (rhs <= FeasibilityTolerance))
+                && ((sense != LessEqual) || (rhs >= -FeasibilityTolerance))
+                && ((sense != Equal) || (abs(rhs) <= FeasibilityTolerance));
+            if (!isFeasible) { stat.isInfeasible = true; return; }
+            removeRow(r);
+            continue;
+        }
+
+        int e = model.rowBegin[r];
+        while (isEntryRemoved[e]) { ++e; }
+        int c = model.cols[e];
+        double coef = model.coefs[e];
+        if (model.isFrozen[c] || (coef == 0)) { continue; }
+        double bound = rhs / coef;
+        bool isUpperBound = ((sense == LessEqual) == (coef > 0));
+        if ((sense == Equal) || isUpperBound) { tightenUb(c, bound, true); }
+        if ((sense == Equal) || !isUpperBound) { tightenLb(c, bound, true); }
+        if (stat.isInfeasible) { return; }
+        removeRow(r);
+        ++stat.singletonRowNum;
+    }
+}
+
+void Presolver::tightenImpliedBounds() {
+    static constexpr double MaxDerivedBound = 1e9; // avoid introducing numerical trouble.
+    double infinity = Infinity;
+
+    int rowNum = model.rowNum();
+    for (int r = 0; r < rowNum; ++r) {
+        if (isRowRemoved[r] || (activeEntryNum[r] < 2)) { continue; }
+        int begin = model.rowBegin[r];
+        int end = model.rowBegin[r + 1];
+
+        double minAct = 0;
+        double maxAct = 0;
+        int minInfNum = 0;
+        int maxInfNum = 0;
+        for (int e = begin; e < end; ++e) {
+            if (isEntryRemoved[e]) { continue; }
+            int c = model.cols[e];
+            double a = model.coefs[e];
+            // the bounds of the frozen columns may be changed after presolve, so nothing is derived from them.
+            double lo = model.isFrozen[c] ? -infinity : ((a > 0) ? model.lb[c] : model.ub[c]);
+            double hi = model.isFrozen[c] ? infinity : ((a > 0) ? model.ub[c] : model.lb[c]);
+            if (isInf(lo)) { ++minInfNum; } else { minAct += a * lo; }
+            if (isInf(hi)) { ++maxInfNum; } else { maxAct += a * hi; }
+        }
+
+        char sense = model.senses[r];
+        double rhs = model.rhs[r];
+        for (int e = begin; e < end; ++e) {
+            if (isEntryRemoved[e]) { continue; }
+            int c = model.cols[e];
+            double a = model.coefs[e];
+            if (model.isFrozen[c] || (a == 0)) { continue; }
+            double lo = (a > 0) ? model.lb[c] : model.ub[c];
+            double hi = (a > 0) ? model.ub[c] : model.lb[c];
+
+            // a * x <= rhs - (the min activity of the others).
+            if ((sense == LessEqual) || (sense == Equal)) {
+                bool isLoInf = isInf(lo);
+                if ((minInfNum == 0) || ((minInfNum == 1) && isLoInf)) {
+                    double bound = (rhs - (isLoInf ? minAct : (minAct - a * lo))) / a;
+                    if (abs(bound) < MaxDerivedBound) {
+                        if (a > 0) { tightenUb(c, bound); } else { tightenLb(c, bound); }
+                    }
+                }
+            }
+            // a * x >= rhs - (the max activity of the others).
+            if ((sense == GreaterEqual) || (sense == Equal)) {
+                bool isHiInf = isInf(hi);
+                if ((maxInfNum == 0) || ((maxInfNum == 1) && isHiInf)) {
+                    double bound = (rhs - (isHiInf ? maxAct : (maxAct - a * hi))) / a;
+                    if (abs(bound) < MaxDerivedBound) {
+                        if (a > 0) { tightenLb(c, bound); } else { tightenUb(c, bound); }
+                    }
+                }
+            }
+            if (stat.isInfeasible) { return; }
+        }
+    }
+}
+
+void Presolver::removeDuplicateRows() {
+    struct RowGroup {
+        List<int> rows;
+        List<double> scales; // multiply row r by scales[i] to get the normalized row.
+        double lo;
+        double hi;
+    };
+
+    int rowNum = model.rowNum();
+    List<List<pair<int, double>>> normalizedRows(rowNum);
+    List<RowGroup> groups;
+    unordered_map<size_t, List<int>> buckets; // hash of normalized row => indices of groups.
+    for (int r = 0; r < rowNum; ++r) {
+        if (isRowRemoved[r] || (activeEntryNum[r] == 0)) { continue; }
+        List<pair<int, double>> &row(normalizedRows[r]);
+        row.reserve(activeEntryNum[r]);
+        for (int e = model.rowBegin[r]; e < model.rowBegin[r + 1]; ++e) {
+            if (!isEntryRemoved[e]) { row.push_back({ model.cols[e], model.coefs[e] }); }
+        }
+        sort(row.begin(), row.end());
+        double scale = 1 / row.front().second;
+        size_t hash = row.size();
+        for (auto i = row.begin(); i != row.end(); ++i) {
+            i->second *= scale;
+            hash = hash * 31 + std::hash<int>()(i->first);
+            hash = hash * 31 + std::hash<float>()(static_cast<float>(i->second));
+        }
+
+        double rhs = model.rhs[r] * scale;
+        char sense = model.senses[r];
+        if (scale < 0) { sense = (sense == LessEqual) ? GreaterEqual : ((sense == GreaterEqual) ? LessEqual : sense); }
+        double lo = (sense == LessEqual) ? -Infinity : rhs;
+        double hi = (sense == GreaterEqual) ? Infinity : rhs;
+
+        List<int> &bucket(buckets[hash]);
+        auto g = find_if(bucket.begin(), bucket.end(), [&](int groupIndex) {
+            const List<pair<int, double>> &rep(normalizedRows[groups[groupIndex].rows.front()]);
+            if (rep.size() != row.size()) { return false; }
+            for (size_t i = 0; i < row.size(); ++i) {
+                if (rep[i].first != row[i].first) { return false; }
+                if (abs(rep[i].second - row[i].second) > FeasibilityTolerance * (max)(1.0, abs(row[i].second))) { return false; }
+            }
+            return true;
+        });
+        if (g == bucket.end()) {
+            bucket.push_back(static_cast<int>(groups.size()));
+            groups.push_back({ { r }, { scale }, lo, hi });
+        } else {
+            RowGroup &group(groups[*g]);
+            group.rows.push_back(r);
+            group.scales.push_back(scale);
+            group.lo = (max)(group.lo, lo);
+            group.hi = (min)(group.hi, hi);
+        }
+    }
+
+    for (auto g = groups.begin(); g != groups.end(); ++g) {
+        if (g->rows.size() < 2) { continue; }
+        if (g->lo > g->hi + FeasibilityTolerance) { stat.isInfeasible = true; return; }
+        int r0 = g->rows[0];
+        double scale0 = g->scales[0];
+        size_t keptRowNum = 1;
+        if (isInf(g->lo) || isInf(g->hi) || (g->hi - g->lo <= FeasibilityTolerance)) {
+            char sense = isInf(g->lo) ? LessEqual : (isInf(g->hi) ? GreaterEqual : Equal);
+            double rhs = isInf(g->lo) ? g->hi : g->lo;
+            if ((scale0 < 0) && (sense != Equal)) { sense = (sense == LessEqual) ? GreaterEqual : LessEqual; }
+            modifyRow(r0, sense, rhs / scale0);
+        } else { // keep one row for each side of the range.
+            int r1 = g->rows[1];
+            double scale1 = g->scales[1];
+            modifyRow(r0, (scale0 > 0) ? GreaterEqual : LessEqual, g->lo / scale0);
+            modifyRow(r1, (scale1 > 0) ? LessEqual : GreaterEqual, g->hi / scale1);
+            keptRowNum = 2;
+        }
+        for (size_t i = keptRowNum; i < g->rows.size(); ++i) {
+            removeRow(g->rows[i]);
+            ++stat.duplicateRowNum;
+        }
+    }
+}
+
+void Presolver::mergeDuplicateCols() {
+    int varNum = model.varNum();
+    int objNum = model.objNum;
+    List<List<pair<int, double>>> cols(varNum);
+    unordered_map<size_t, List<int>> buckets; // hash of column => indices of groups.
+    List<ColumnGroup> groups;
+    for (int c = 0; c < varNum; ++c) {
+        if (model.isFrozen[c] || isFixedVarRemoved[c]) { continue; }
+        List<pair<int, double>> &col(cols[c]);
+        for (int i = colBegin[c]; i < colBegin[c + 1]; ++i) {
+            int e = entryIndices[i];
+            if (!isEntryRemoved[e] && !isRowRemoved[entryRows[e]]) { col.push_back({ entryRows[e], model.coefs[e] }); }
+        }
+        if (col.empty()) { continue; }
+        sort(col.begin(), col.end());
+        size_t hash = col.size() * 2 + (model.isInteger[c] ? 1 : 0);
+        for (int o = 0; o < objNum; ++o) { hash = hash * 31 + std::hash<double>()(model.objCoefs[static_cast<size_t>(c) * objNum + o]); }
+        for (auto i = col.begin(); i != col.end(); ++i) {
+            hash = hash * 31 + std::hash<int>()(i->first);
+            hash = hash * 31 + std::hash<double>()(i->second);
+        }
+
+        List<int> &bucket(buckets[hash]);
+        auto g = find_if(bucket.begin(), bucket.end(), [&](int groupIndex) {
+            int rep = groups[groupIndex].cols.front();
+            if ((model.isInteger[rep] != model.isInteger[c]) || (cols[rep] != col)) { return false; }
+            for (int o = 0; o < objNum; ++o) {
+                if (model.objCoefs[static_cast<size_t>(rep) * objNum + o] != model.objCoefs[static_cast<size_t>(c) * objNum + o]) { return false; }
+            }
+            return true;
+        });
+        if (g == bucket.end()) {
+            bucket.push_back(static_cast<int>(groups.size()));
+            groups.push_back({ { c }, { model.lb[c] }, { model.ub[c] } });
+        } else {
+            ColumnGroup &group(groups[*g]);
+            group.cols.push_back(c);
+            group.lbs.push_back(model.lb[c]);
+            group.ubs.push_back(model.ub[c]);
+        }
+    }
+
+    for (auto g = groups.begin(); g != groups.end(); ++g) {
+        if (g->cols.size() < 2) { continue; }
+        int kept = g->cols.front();
+        double lb = 0;
+        double ub = 0;
+        for (size_t i = 0; i < g->cols.size(); ++i) {
+            lb = (isInf(lb) || isInf(g->lbs[i])) ? -Infinity : (lb + g->lbs[i]);
+            ub = (isInf(ub) || isInf(g->ubs[i])) ? Infinity : (ub + g->ubs[i]);
+        }
+        model.lb[kept] = lb;
+        model.ub[kept] = ub;
+        modifyBound(kept);
+        for (size_t i = 1; i < g->cols.size(); ++i) {
+            int c = g->cols[i];
+            for (int j = colBegin[c]; j < colBegin[c + 1]; ++j) {
+                int e = entryIndices[j];
+                if (!isEntryRemoved[e] && !isRowRemoved[entryRows[e]]) { removeEntry(e); }
+            }
+            model.lb[c] = 0;
+            model.ub[c] = 0;
+            modifyBound(c);
+            ++stat.duplicateColNum;
+        }
+        mergedColumns.push_back(*g);
+    }
+}
+
+void Presolver::removeEntry(int entry) {
+    isEntryRemoved[entry] = true;
+    --activeEntryNum[entryRows[entry]];
+    removedEntries.push_back({ entryRows[entry], model.cols[entry] });
+}
+
+void Presolver::removeRow(int row) {
+    isRowRemoved[row] = true;
+}
+
+void Presolver::modifyRow(int row, char sense, double rhs) {
+    model.senses[row] = sense;
+    model.rhs[row] = rhs;
+    if (!isRowModified[row]) {
+        isRowModified[row] = true;
+        modifiedRows.push_back(row);
+    }
+}
+
+bool Presolver::tightenLb(int col, double lb, bool isExact) {
+    if (model.isInteger[col]) { lb = ceil(lb - FeasibilityTolerance); }
+    double threshold = (isExact || model.isInteger[col]) ? 0 : (BoundImprovementTolerance * (max)(1.0, abs(lb)));
+    if (lb <= model.lb[col] + threshold) { return false; }
+    if (lb > model.ub[col] + FeasibilityTolerance) { stat.isInfeasible = true; return false; }
+    model.lb[col] = (min)(lb, model.ub[col]);
+    modifyBound(col);
+    ++stat.tightenedBoundNum;
+    return true;
+}
+
+bool Presolver::tightenUb(int col, double ub, bool isExact) {
+    if (model.isInteger[col]) { ub = floor(ub + FeasibilityTolerance); }
+    double threshold = (isExact || model.isInteger[col]) ? 0 : (BoundImprovementTolerance * (max)(1.0, abs(ub)));
+    if (ub >= model.ub[col] - threshold) { return false; }
+    if (ub < model.lb[col] - FeasibilityTolerance) { stat.isInfeasible = true; return false; }
+    model.ub[col] = (max)(ub, model.lb[col]);
+    modifyBound(col);
+    ++stat.tightenedBoundNum;
+    return true;
+}
+
+void Presolver::modifyBound(int col) {
+    if (!isBoundModified[col]) {
+        isBoundModified[col] = true;
+        modifiedBounds.push_back(col);
+    }
+}
+
+}
@@ -0,0 +1,158 @@
+////////////////////////////////
+/// usage : 1.	solver independent presolve reductions on a model skeleton which will be submitted repeatedly.
+///         2.	reductions: fixed variable removal, singleton rows, duplicate rows, duplicate columns and implied bounds.
+///
+/// note  : 1.	the presolver never removes a variable, so the decision variable handles of the backend stay valid.
+///             removed coefficients are zeroed, merged columns are fixed to 0 and recovered by the postsolve.
+///         2.	frozen variables (e.g., the ones fixed differently in each submission) are excluded from
+///             any reduction which relies on their bounds staying as they are in the skeleton.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_PRESOLVER_H
+#define SMART_SZX_GATE_REASSIGNMENT_PRESOLVER_H
+
+
+#include "Config.h"
+
+#include <iostream>
+#include <limits>
+
+#include "Common.h"
+
+
+namespace szx {
+
+class Presolver {
+    #pragma region Constant
+public:
+    static constexpr char LessEqual = '<';
+    static constexpr char GreaterEqual = '>';
+    static constexpr char Equal = '=';
+
+    static constexpr double Infinity = 1e100; // any bound whose absolute value is not less than it is infinite.
+    static constexpr double FeasibilityTolerance = 1e-9;
+    static constexpr double BoundImprovementTolerance = 1e-3; // ignore the tiny tightening on continuous variables.
+
+    static constexpr int MaxRound = 8;
+    #pragma endregion Constant
+
+    #pragma region Type
+public:
+    // the skeleton in compressed sparse row format.
+    struct Model {
+        // variables.
+        List<double> lb;
+        List<double> ub;
+        List<char> isInteger;
+        List<char> isFrozen;
+        int objNum = 0;
+        List<double> objCoefs; // objCoefs[var * objNum + obj] is the coefficient of var in the obj_th objective.
+
+        // constraints.
+        List<int> rowBegin; // the entries of row r are in [rowBegin[r], rowBegin[r + 1]).
+        List<int> cols;
+        List<double> coefs;
+        List<char> senses;
+        List<double> rhs;
+
+        int varNum() const { return static_cast<int>(lb.size()); }
+        int rowNum() const { return static_cast<int>(senses.size()); }
+    };
+
+    struct Statistics {
+        friend std::ostream& operator<<(std::ostream &os, const Statistics &s) {
+            return os << "fixed=" << s.fixedVarNum << " singletonRow=" << s.singletonRowNum << " duplicateRow=" << s.duplicateRowNum
+                << " duplicateCol=" << s.duplicateColNum << " tightenedBound=" << s.tightenedBoundNum << (s.isInfeasible ? " infeasible" : "");
+        }
+
+        int fixedVarNum = 0;
+        int singletonRowNum = 0;
+        int duplicateRowNum = 0;
+        int duplicateColNum = 0;
+        int tightenedBoundNum = 0;
+        bool isInfeasible = false;
+    };
+
+    struct Entry {
+        int row;
+        int col;
+    };
+
+    // identical columns which are merged into the first one to represent their sum.
+    struct ColumnGroup {
+        List<int> cols;
+        List<double> lbs; // the bounds of each column before merging.
+        List<double> ubs;
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    Presolver(Model &skeleton) : model(skeleton) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// apply all reductions on the model. the model is left in an undefined state if it is infeasible.
+    const Statistics& presolve();
+
+    /// split the value of the kept column in the reduced model into the values of the merged columns.
+    static void splitMergedValue(double sum, const ColumnGroup &group, List<double> &values);
+    /// the finite value in the bounds of the i_th column of the group where the split starts from.
+    static double getAnchorValue(const ColumnGroup &group, int i) {
+        return !isInf(group.lbs[i]) ? group.lbs[i] : (!isInf(group.ubs[i]) ? group.ubs[i] : 0);
+    }
+
+    const List<char>& getRemovedRows() const { return isRowRemoved; }
+    const List<int>& getModifiedRows() const { return modifiedRows; }
+    const List<Entry>& getRemovedEntries() const { return removedEntries; }
+    const List<int>& getModifiedBounds() const { return modifiedBounds; }
+    const List<ColumnGroup>& getMergedColumns() const { return mergedColumns; }
+
+protected:
+    static bool isInf(double value) { return ((value >= Infinity) || (value <= -Infinity)); }
+    bool isFixed(int col) const { return (model.ub[col] - model.lb[col] <= FeasibilityTolerance); }
+
+    void removeFixedVars();
+    void removeSingletonRows();
+    void tightenImpliedBounds();
+    void removeDuplicateRows();
+    void mergeDuplicateCols();
+
+    void removeEntry(int entry);
+    void removeRow(int row);
+    void modifyRow(int row, char sense, double rhs);
+    // returns true if the bound is tightened. the tiny improvement is ignored unless isExact is set.
+    bool tightenLb(int col, double lb, bool isExact = false);
+    bool tightenUb(int col, double ub, bool isExact = false);
+    void modifyBound(int col);
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+protected:
+    Model &model;
+    Statistics stat;
+
+    // the column view of the entries.
+    List<int> colBegin; // the entries of column c are entryIndices[colBegin[c], colBegin[c + 1]).
+    List<int> entryIndices;
+    List<int> entryRows;
+
+    List<char> isEntryRemoved;
+    List<char> isFixedVarRemoved;
+    List<int> activeEntryNum; // activeEntryNum[r] is the number of coefficients of row r which are not removed.
+    List<char> isRowRemoved;
+    List<char> isRowModified;
+    List<int> modifiedRows; // whose sense or rhs are modified.
+    List<Entry> removedEntries;
+    List<char> isBoundModified;
+    List<int> modifiedBounds;
+    List<ColumnGroup> mergedColumns;
+    #pragma endregion Field
+}; // Presolver
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_PRESOLVER_H
@@ -0,0 +1,166 @@
+#include "RelaxAndFix.h"
+
+#include <algorithm>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+bool RelaxAndFix::optimize(const CancellationToken &cancellation) {
+    CancellationToken token(cancellation.createChild());
+    token.setDeadlineInSecond(cfg.timeoutInSecond);
+    int partNum = getPartitionCount();
+
+    types.resize(partNum);
+    lbs.resize(partNum);
+    ubs.resize(partNum);
+    states.assign(partNum, PartitionState::Original);
+    for (int p = 0; p < partNum; ++p) {
+        types[p].clear();
+        lbs[p].clear();
+        ubs[p].clear();
+        for (auto v = parts[p].begin(); v != parts[p].end(); ++v) {
+            types[p].push_back(model.getType(*v));
+            lbs[p].push_back(model.getLowerBound(*v));
+            ubs[p].push_back(model.getUpperBound(*v));
+        }
+    }
+    incumbent.clear();
+
+    CancellationToken relaxAndFixToken(token.createChild());
+    relaxAndFixToken.setDeadlineInSecond(cfg.timeoutInSecond * cfg.relaxAndFixTimeRatio);
+    if (relaxAndFix(relaxAndFixToken)) {
+        stat.relaxAndFixObj = incumbentObj;
+        Log(LogSwitch::Szx::MpSolver) << "rnf: relax-and-fix obj=" << incumbentObj << endl;
+        fixAndOptimize(token);
+    }
+
+    // leave the model as it was with the incumbent as the MIP start.
+    for (int p = 0; p < partNum; ++p) {
+        restore(p);
+        if (!hasSolution()) { continue; }
+        for (size_t i = 0; i < parts[p].size(); ++i) { model.setInitValue(parts[p][i], incumbent[p][i]); }
+    }
+    return hasSolution();
+}
+
+bool RelaxAndFix::relaxAndFix(const CancellationToken &token) {
+    int partNum = getPartitionCount();
+    int size = (max)(cfg.windowSize, 1);
+    int step = (min)((max)(cfg.windowStep, 1), size);
+    for (int p = 0; p < partNum; ++p) { relax(p); }
+
+    List<double> values;
+    for (int begin = 0; begin < partNum; begin += step) {
+        int end = (min)(begin + size, partNum);
+        for (int p = begin; p < end; ++p) { restore(p); }
+
+        if (token.isCancelled()) { return false; }
+        int restWindowNum = (partNum - begin + step - 1) / step;
+        if (!solve(token, restWindowNum)) { return false; }
+        if (end == partNum) { break; }
+
+        for (int p = begin; p < (min)(begin + step, end); ++p) {
+            getValues(p, values);
+            fix(p, values);
+        }
+    }
+    // the last window leaves no integer variable relaxed.
+    record();
+    return true;
+}
+
+bool RelaxAndFix::fixAndOptimize(const CancellationToken &token) {
+    int partNum = getPartitionCount();
+    int size = (max)(cfg.optimizeWindowSize, 1);
+    int step = (max)(cfg.optimizeWindowStep, 1);
+    int windowNum = ((max)(partNum - size, 0) + step - 1) / step + 1;
+    for (stat.passNum = 0; stat.passNum < cfg.maxPassNum; ++stat.passNum) {
+        bool isImproved = false;
+        for (int w = 0; w < windowNum; ++w) {
+            if (token.isCancelled()) { return isImproved; }
+            int begin = w * step;
+            int end = (min)(begin + size, partNum);
+            // only the partitions whose state changes are touched, and the fixed values stay valid since
+            // an improvement only changes the partitions in the window.
+            for (int p = 0; p < partNum; ++p) {
+                if ((begin <= p) && (p < end)) {
+                    restore(p);
+                } else if (states[p] != PartitionState::Fixed) {
+                    fix(p, incumbent[p]);
+                }
+            }
+            for (int p = begin; p < end; ++p) {
+                for (size_t i = 0; i < parts[p].size(); ++i) { model.setInitValue(parts[p][i], incumbent[p][i]); }
+            }
+
+            int restWindowNum = windowNum - w;
+            if (!solve(token, restWindowNum)) { continue; }
+            if (!isBetter(model.getObjectiveValue(), incumbentObj)) { continue; }
+            record();
+            isImproved = true;
+            ++stat.improvementNum;
+            Log(LogSwitch::Szx::MpSolver) << "rnf[" << stat.passNum << "]: window=" << begin << " obj=" << incumbentObj << endl;
+        }
+        if (!isImproved) { break; }
+    }
+    return true;
+}
+
+void RelaxAndFix::relax(int p) {
+    if (states[p] == PartitionState::Relaxed) { return; }
+    restore(p);
+    for (size_t i = 0; i < parts[p].size(); ++i) {
+        if (types[p][i] == MpSolver::VariableType::Real) { continue; }
+        model.setType(parts[p][i], MpSolver::VariableType::Real);
+    }
+    states[p] = PartitionState::Relaxed;
+}
+
+void RelaxAndFix::restore(int p) {
+    if (states[p] == PartitionState::Original) { return; }
+    for (size_t i = 0; i < parts[p].size(); ++i) {
+        if (types[p][i] == MpSolver::VariableType::Real) { continue; }
+        if (states[p] == PartitionState::Relaxed) {
+            model.setType(parts[p][i], types[p][i]);
+        } else {
+            model.setBounds(parts[p][i], lbs[p][i], ubs[p][i]);
+        }
+    }
+    states[p] = PartitionState::Original;
+}
+
+void RelaxAndFix::fix(int p, const List<double> &values) {
+    restore(p);
+    for (size_t i = 0; i < parts[p].size(); ++i) {
+        if (types[p][i] == MpSolver::VariableType::Real) { continue; }
+        double value = round(values[i]);
+        model.setBounds(parts[p][i], value, value);
+    }
+    states[p] = PartitionState::Fixed;
+}
+
+bool RelaxAndFix::solve(const CancellationToken &token, int restWindowNum) {
+    ++stat.windowNum;
+    // the rest time is shared by the rest windows.
+    model.setTimeLimitInSecond(token.restSeconds(MpSolver::Configuration::Forever) / restWindowNum);
+    model.optimize();
+    return (model.getSolutionCount() > 0);
+}
+
+void RelaxAndFix::record() {
+    incumbent.resize(parts.size());
+    for (int p = 0; p < getPartitionCount(); ++p) { getValues(p, incumbent[p]); }
+    incumbentObj = model.getObjectiveValue();
+}
+
+void RelaxAndFix::getValues(int p, List<double> &values) const {
+    values.resize(parts[p].size());
+    for (size_t i = 0; i < parts[p].size(); ++i) { values[i] = model.getValue(parts[p][i]); }
+}
+
+}
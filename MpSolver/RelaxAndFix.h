@@ -0,0 +1,140 @@
+////////////////////////////////
+/// usage : 1.	construct a solution of a time-indexed MIP by relax-and-fix, i.e., solve rolling windows of the
+///             variable partitions with the integer variables in the future partitions relaxed, then fix the
+///             integer variables in the decided partitions.
+///         2.	improve the solution by fix-and-optimize, i.e., re-optimize windows of the partitions with the
+///             integer variables in the other partitions fixed to the incumbent.
+///
+/// note  : 1.	all the steps work on the same model by changing the bounds and types of the variables,
+///             which are restored after optimize() with the incumbent set as the MIP start.
+///         2.	the variables not in any partition are never relaxed or fixed.
+///         3.	only the integer variables in the partitions are fixed, the real variables are always free.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_RELAX_AND_FIX_H
+#define SMART_SZX_GATE_REASSIGNMENT_RELAX_AND_FIX_H
+
+
+#include "Config.h"
+
+#include <cmath>
+#include <limits>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+
+
+namespace szx {
+
+class RelaxAndFix {
+    #pragma region Type
+public:
+    enum PartitionState { Original, Relaxed, Fixed };
+
+    using DecisionVar = MpSolver::DecisionVar;
+
+    struct Configuration {
+        static constexpr int DefaultWindowSize = 2;
+        static constexpr int DefaultWindowStep = 1;
+        static constexpr double DefaultRelaxAndFixTimeRatio = 0.5;
+        static constexpr int DefaultMaxPassNum = (std::numeric_limits<int>::max)();
+        static constexpr double DefaultImprovementTolerance = 1e-6;
+
+        Configuration(double timeoutInSec = MpSolver::Configuration::Forever,
+            MpSolver::OptimaOrientation modelOrientation = MpSolver::OptimaOrientation::Minimize)
+            : timeoutInSecond(timeoutInSec), orientation(modelOrientation), windowSize(DefaultWindowSize), windowStep(DefaultWindowStep),
+            relaxAndFixTimeRatio(DefaultRelaxAndFixTimeRatio), optimizeWindowSize(DefaultWindowSize), optimizeWindowStep(DefaultWindowStep),
+            maxPassNum(DefaultMaxPassNum), improvementTolerance(DefaultImprovementTolerance) {}
+
+        double timeoutInSecond;
+        MpSolver::OptimaOrientation orientation; // the optima orientation of the model.
+
+        // relax-and-fix solves partitions [i, i + windowSize) and fixes [i, i + windowStep).
+        // the step is clamped to the size so that no partition is left relaxed.
+        int windowSize;
+        int windowStep;
+        double relaxAndFixTimeRatio; // the ratio of the timeout reserved for relax-and-fix.
+
+        // fix-and-optimize re-optimizes partitions [i, i + optimizeWindowSize) with i increased by optimizeWindowStep.
+        int optimizeWindowSize;
+        int optimizeWindowStep;
+        int maxPassNum; // 0 for skipping fix-and-optimize.
+
+        double improvementTolerance; // relative.
+    };
+
+    struct Statistics {
+        int windowNum = 0;
+        int passNum = 0;
+        int improvementNum = 0;
+        double relaxAndFixObj = 0;
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    /// partitions[p] are the variables decided in period p, e.g., the variables in the p_th time window.
+    RelaxAndFix(MpSolver &mpModel, const List<List<DecisionVar>> &partitions, const Configuration &config = Configuration())
+        : cfg(config), model(mpModel), parts(partitions) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// returns true if a feasible solution is found.
+    /// the token is checked between the windows, each of which is clamped to its deadline.
+    bool optimize(const CancellationToken &cancellation = CancellationToken());
+
+    bool hasSolution() const { return !incumbent.empty(); }
+    /// values[p][i] is the value of parts[p][i] in the best solution.
+    const List<List<double>>& getIncumbent() const { return incumbent; }
+    double getObjectiveValue() const { return incumbentObj; }
+    const Statistics& getStatistics() const { return stat; }
+
+protected:
+    bool relaxAndFix(const CancellationToken &token);
+    bool fixAndOptimize(const CancellationToken &token);
+
+    // change the state of the integer variables in partition p.
+    void relax(int p);
+    void restore(int p);
+    void fix(int p, const List<double> &values);
+
+    // returns true if a solution is found in the time limit.
+    bool solve(const CancellationToken &token, int restWindowNum);
+    // take the current solution as the incumbent.
+    void record();
+    void getValues(int p, List<double> &values) const;
+    bool isBetter(double obj, double reference) const {
+        double tolerance = cfg.improvementTolerance * (std::max)(1.0, std::abs(reference));
+        return (cfg.orientation == MpSolver::OptimaOrientation::Minimize) ? (obj < reference - tolerance) : (obj > reference + tolerance);
+    }
+
+    int getPartitionCount() const { return static_cast<int>(parts.size()); }
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    MpSolver &model;
+    List<List<DecisionVar>> parts;
+
+    // the original state of the variables in the partitions.
+    List<List<MpSolver::VariableType>> types;
+    List<List<double>> lbs;
+    List<List<double>> ubs;
+    List<PartitionState> states;
+
+    List<List<double>> incumbent;
+    double incumbentObj = 0;
+
+    Statistics stat;
+    #pragma endregion Field
+}; // RelaxAndFix
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_RELAX_AND_FIX_H
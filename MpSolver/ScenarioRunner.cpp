@@ -0,0 +1,118 @@
+#include "ScenarioRunner.h"
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+double ScenarioRunner::Scenario::getLowerBound(int var) const {
+    auto b = bounds.find(var);
+    return (b != bounds.end()) ? b->second.lb : base->model.getView().lb[var];
+}
+
+double ScenarioRunner::Scenario::getUpperBound(int var) const {
+    auto b = bounds.find(var);
+    return (b != bounds.end()) ? b->second.ub : base->model.getView().ub[var];
+}
+
+double ScenarioRunner::Scenario::getRhs(int constraint) const {
+    auto r = rhsList.find(constraint);
+    return (r != rhsList.end()) ? r->second : base->model.getView().rhs[constraint];
+}
+
+double ScenarioRunner::Scenario::getObjCoef(int var) const {
+    auto c = objCoefs.find(var);
+    return (c != objCoefs.end()) ? c->second : base->model.getView().obj[var];
+}
+
+void ScenarioRunner::Scenario::materialize(MpSolver &solver, bool warmStart) const {
+    solver.load(base->model.getView());
+
+    Arr<MpSolver::DecisionVar> vars(solver.getAllVars());
+    Arr<MpSolver::Constraint> constraints(solver.getAllConstraints());
+
+    List<MpSolver::DecisionVar> changedVars;
+    List<double> lbs;
+    List<double> ubs;
+    for (auto b = bounds.begin(); b != bounds.end(); ++b) {
+        changedVars.push_back(vars[b->first]);
+        lbs.push_back(b->second.lb);
+        ubs.push_back(b->second.ub);
+    }
+    solver.setBounds(changedVars, lbs, ubs);
+
+    List<MpSolver::Constraint> changedConstraints;
+    List<double> rhs;
+    for (auto r = rhsList.begin(); r != rhsList.end(); ++r) {
+        changedConstraints.push_back(constraints[r->first]);
+        rhs.push_back(r->second);
+    }
+    solver.setRhs(changedConstraints, rhs);
+
+    changedVars.clear();
+    List<double> coefs;
+    for (auto c = objCoefs.begin(); c != objCoefs.end(); ++c) {
+        changedVars.push_back(vars[c->first]);
+        coefs.push_back(c->second);
+    }
+    solver.setObjCoefs(changedVars, coefs);
+
+    if (!warmStart) { return; }
+    if (!base->values.empty()) { solver.setAllInitValues(base->values); }
+    if (!base->varBasis.empty()) { solver.setBasis(base->varBasis, base->constraintBasis); }
+}
+
+ScenarioRunner::BasePtr ScenarioRunner::makeBase(MpSolver &solver) {
+    shared_ptr<Base> base(make_shared<Base>());
+    solver.save(base->model);
+    if (solver.getSolutionCount() > 0) {
+        Arr<MpSolver::DecisionVar> vars(solver.getAllVars());
+        Arr<double> values;
+        solver.getAllValues(vars, values);
+        base->values.assign(values.begin(), values.end());
+        if (!solver.getBasis(base->varBasis, base->constraintBasis)) {
+            base->varBasis.clear();
+            base->constraintBasis.clear();
+        }
+    }
+    return base;
+}
+
+ScenarioRunner::BasePtr ScenarioRunner::makeBase(MpModelData &&model, const List<double> &values) {
+    shared_ptr<Base> base(make_shared<Base>());
+    base->model = move(model);
+    base->values = values;
+    return base;
+}
+
+List<ScenarioRunner::Result> ScenarioRunner::run(const List<Scenario> &scenarios, OnSolved onSolved) {
+    List<Result> results(scenarios.size());
+    pool.parallelFor(0, static_cast<int>(scenarios.size()), [&](int s, int threadIndex) {
+        Timer timer(Timer::toMillisecond(cfg.timeoutInSecond));
+        Result &result(results[s]);
+
+        // the solver lives only during the solve, so the memory of the idle scenarios stays in their changes.
+        MpSolver solver;
+        solver.setMaxThread(cfg.solverThreadNum);
+        solver.setTimeLimitInSecond(cfg.timeoutInSecond);
+        scenarios[s].materialize(solver, cfg.warmStart);
+        solver.optimize();
+
+        result.status = solver.getStatus();
+        result.solutionCount = solver.getSolutionCount();
+        if (result.solutionCount > 0) {
+            result.obj = solver.getObjectiveValue();
+            result.bound = solver.getBestBound();
+        }
+        if (onSolved) { onSolved(s, solver); }
+        result.elapsedSeconds = timer.elapsedSeconds();
+        Log(LogSwitch::Szx::MpSolver) << "scenario[" << s << "]: thread=" << threadIndex
+            << " changes=" << scenarios[s].getChangeCount() << " obj=" << result.obj << endl;
+    });
+    return results;
+}
+
+}
@@ -0,0 +1,136 @@
+////////////////////////////////
+/// usage : 1.	solve many what-if variants of one model in parallel, each of which differs from the base model
+///             only in a few variable bounds, constraint rhs and objective coefficients.
+///         2.	the base model is flattened once and shared read-only by all scenarios, and each scenario only
+///             records its changes against the base, so that a scenario costs memory in the size of its changes.
+///         3.	a scenario is materialized into a solver on a worker thread only when it is solved, and the solver
+///             is released right after the result and the requested data are collected.
+///         4.	the scenarios are warm started by the solution (and the simplex basis for LP) of the base model.
+///
+/// note  : 1.	the variables and constraints are identified by their indices in the base model.
+///         2.	the base model can only have a single objective and linear constraints, and must be neither presolved nor
+///             scaled, since it is flattened by MpSolver::save(), which throws MpException on the others instead of
+///             mixing the reduced model with the values and the bounds in the original units.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_SCENARIO_RUNNER_H
+#define SMART_SZX_GATE_REASSIGNMENT_SCENARIO_RUNNER_H
+
+
+#include "Config.h"
+
+#include <functional>
+#include <memory>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+#include "MpModelData.h"
+
+
+namespace szx {
+
+class ScenarioRunner {
+    #pragma region Type
+public:
+    struct Configuration {
+        static constexpr int DefaultSolverThreadNum = 1;
+
+        Configuration(int threads = ThreadPool::getHardwareConcurrency(), double timeoutInSec = MpSolver::Configuration::Forever)
+            : threadNum(threads), timeoutInSecond(timeoutInSec), solverThreadNum(DefaultSolverThreadNum), warmStart(true) {}
+
+        int threadNum; // the number of scenarios solved concurrently.
+        double timeoutInSecond; // the time limit for each scenario.
+        int solverThreadNum; // the threads used by each solve.
+        bool warmStart;
+    };
+
+    /// the immutable model shared by all scenarios.
+    struct Base {
+        MpModelData model;
+        List<double> values; // the solution of the base model, or empty if it is unsolved.
+        List<int> varBasis; // the simplex basis of the base model, or empty if it is a MIP.
+        List<int> constraintBasis;
+    };
+    using BasePtr = std::shared_ptr<const Base>;
+
+    /// the changes of a scenario against the base model.
+    /// copying a scenario only copies its changes, which makes it cheap to derive scenarios from each other.
+    class Scenario {
+    public:
+        struct Bound {
+            double lb;
+            double ub;
+        };
+
+
+        Scenario(BasePtr baseModel) : base(baseModel) {}
+
+
+        // the later changes on the same variable or constraint overwrite the earlier ones.
+        void setBounds(int var, double lb, double ub) { bounds[var] = { lb, ub }; }
+        void setRhs(int constraint, double rhs) { rhsList[constraint] = rhs; }
+        void setObjCoef(int var, double coef) { objCoefs[var] = coef; }
+
+        // read through the changes to the base model.
+        double getLowerBound(int var) const;
+        double getUpperBound(int var) const;
+        double getRhs(int constraint) const;
+        double getObjCoef(int var) const;
+
+        int getChangeCount() const { return static_cast<int>(bounds.size() + rhsList.size() + objCoefs.size()); }
+        const BasePtr& getBase() const { return base; }
+
+        /// build the base model with the changes in an empty solver.
+        void materialize(MpSolver &solver, bool warmStart = true) const;
+
+    protected:
+        BasePtr base;
+        Map<int, Bound> bounds;
+        Map<int, double> rhsList;
+        Map<int, double> objCoefs;
+    };
+
+    struct Result {
+        MpSolver::ResultStatus status = MpSolver::ResultStatus::Error;
+        int solutionCount = 0;
+        double obj = 0;
+        double bound = 0;
+        double elapsedSeconds = 0;
+    };
+
+    /// collect the data other than the result, e.g., the values of the interested variables, from the solved scenario
+    /// before the solver is released. it is invoked concurrently from different threads.
+    using OnSolved = std::function<void(int scenarioIndex, MpSolver &solver)>;
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    ScenarioRunner(const Configuration &config = Configuration()) : cfg(config), pool(config.threadNum) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// flatten the model as the base, together with its solution and basis if it is solved.
+    /// throws MpException if the model can not be flattened.
+    static BasePtr makeBase(MpSolver &solver);
+    /// values[i] is the value of the i_th variable in the base solution, which can be empty.
+    static BasePtr makeBase(MpModelData &&model, const List<double> &values = List<double>());
+
+    /// solve the scenarios and return their results in the same order.
+    List<Result> run(const List<Scenario> &scenarios, OnSolved onSolved = OnSolved());
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    ThreadPool pool;
+    #pragma endregion Field
+}; // ScenarioRunner
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_SCENARIO_RUNNER_H
@@ -0,0 +1,405 @@
+#include "SolveServer.h"
+
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+
+#if SOLVE_SERVER_POSIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif // SOLVE_SERVER_POSIX
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+#if SOLVE_SERVER_POSIX
+#ifdef MSG_NOSIGNAL
+static constexpr int SendFlags = MSG_NOSIGNAL; // a disconnected client should not kill the server by SIGPIPE.
+#else
+static constexpr int SendFlags = 0;
+#endif // MSG_NOSIGNAL
+
+static ostream& fullPrecision(ostream &os) {
+    os.precision(numeric_limits<double>::max_digits10);
+    return os;
+}
+
+static bool waitReadable(int fd, int timeoutInMillisecond) {
+    pollfd p = { fd, POLLIN, 0 };
+    return (poll(&p, 1, timeoutInMillisecond) > 0);
+}
+
+
+bool SharedMemory::create(const String &name, uint64_t size) {
+    close();
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) { return false; }
+    void *p = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        p = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+    segmentName = name;
+    addr = p;
+    len = size;
+    isOwner = true;
+    return true;
+}
+
+bool SharedMemory::open(const String &name) {
+    close();
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) { return false; }
+    struct stat info;
+    void *p = MAP_FAILED;
+    if ((fstat(fd, &info) == 0) && (info.st_size > 0)) {
+        p = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) { return false; }
+    segmentName = name;
+    addr = p;
+    len = static_cast<uint64_t>(info.st_size);
+    isOwner = false;
+    return true;
+}
+
+void SharedMemory::close() {
+    if (addr) { munmap(addr, static_cast<size_t>(len)); }
+    if (isOwner) { shm_unlink(segmentName.c_str()); }
+    addr = nullptr;
+    len = 0;
+    isOwner = false;
+}
+
+
+bool SolveServer::start() {
+    if (isRunning) { return true; }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (cfg.socketPath.size() >= sizeof(addr.sun_path)) { return false; }
+    strncpy(addr.sun_path, cfg.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) { return false; }
+    unlink(cfg.socketPath.c_str()); // remove the socket file left by a previous server.
+    // only the owner can connect, and no one can connect before listen() so there is no window before chmod().
+    if ((::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+        || (chmod(cfg.socketPath.c_str(), S_IRUSR | S_IWUSR) != 0) || (listen(listener, SOMAXCONN) != 0)) {
+        ::close(listener);
+        listener = -1;
+        return false;
+    }
+
+    jobCancellation = CancellationToken();
+    isRunning = true;
+    for (int w = 0; w < (max)(cfg.workerNum, 1); ++w) { workers.emplace_back([this, w]() { work(w); }); }
+    acceptor = thread([this]() { acceptConnections(); });
+    Log(LogSwitch::Szx::MpSolver) << "solve server: listening on " << cfg.socketPath << endl;
+    return true;
+}
+
+void SolveServer::stop() {
+    if (!isRunning.exchange(false)) { return; }
+
+    acceptor.join();
+    ::close(listener);
+    listener = -1;
+    unlink(cfg.socketPath.c_str());
+
+    jobCancellation.cancel();
+    queueCond.notify_all();
+    for (auto w = workers.begin(); w != workers.end(); ++w) { w->join(); }
+    workers.clear();
+    {
+        lock_guard<mutex> l(queueMutex);
+        for (; !jobQueue.empty(); jobQueue.pop()) {
+            ostringstream oss;
+            oss << "DONE " << jobQueue.top()->id << " " << MpSolver::ResultStatus::ExceedLimit << " 0 0 0";
+            finishJob(*jobQueue.top(), oss.str());
+        }
+    }
+
+    unique_lock<mutex> l(connectionMutex);
+    for (auto c = connections.begin(); c != connections.end(); ++c) { shutdown(*c, SHUT_RDWR); }
+    connectionCond.wait(l, [this]() { return (activeConnectionNum == 0); });
+    Log(LogSwitch::Szx::MpSolver) << "solve server: stopped with " << stat.solvedJobNum << " jobs solved" << endl;
+}
+
+void SolveServer::acceptConnections() {
+    while (isRunning) {
+        if (!waitReadable(listener, PollIntervalInMillisecond)) { continue; }
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) { continue; }
+
+        lock_guard<mutex> l(connectionMutex);
+        connections.push_back(connection);
+        ++activeConnectionNum;
+        thread([this, connection]() { serveConnection(connection); }).detach();
+    }
+}
+
+void SolveServer::serveConnection(int connection) {
+    String line;
+    String pending;
+    JobPtr job;
+    if (receiveLine(connection, line, pending)) {
+        istringstream iss(line);
+        String command;
+        double deadlineInSecond;
+        job = make_shared<Job>();
+        if ((iss >> command) && (command == "SOLVE")
+            && (iss >> job->shmName >> job->priority >> job->timeLimitInSecond >> deadlineInSecond)
+            && (job->timeLimitInSecond >= 0) && (deadlineInSecond >= 0)) { // NaN fails the comparisons.
+            job->connection = connection;
+            job->deadline = CancellationToken::Clock::now() + chrono::duration_cast<CancellationToken::Clock::duration>(
+                chrono::duration<double>((min)(deadlineInSecond, MpSolver::Configuration::Forever)));
+            job->cancellation = jobCancellation.createChild();
+            job->cancellation.setDeadline(job->deadline);
+            {
+                lock_guard<mutex> l(queueMutex);
+                if (isRunning && (static_cast<int>(jobQueue.size()) < cfg.maxQueueSize)) {
+                    job->id = jobCount++;
+                    job->seq = job->id;
+                } else {
+                    job.reset();
+                }
+            }
+        } else {
+            job.reset();
+        }
+    }
+
+    if (job) {
+        future<void> finished(job->finished.get_future());
+        sendLine(connection, "ACCEPTED " + to_string(job->id));
+        ++stat.acceptedJobNum;
+        bool isQueued = false;
+        {
+            lock_guard<mutex> l(queueMutex);
+            if (isRunning) { // otherwise the queue may have been drained by stop().
+                jobQueue.push(job);
+                isQueued = true;
+            }
+        }
+        if (isQueued) {
+            queueCond.notify_one();
+        } else {
+            finishJob(*job, "DONE " + to_string(job->id) + " " + to_string(MpSolver::ResultStatus::ExceedLimit) + " 0 0 0");
+        }
+
+        // watch the cancellation from the client until the job ends.
+        while (finished.wait_for(chrono::seconds(0)) != future_status::ready) {
+            if (!waitReadable(connection, PollIntervalInMillisecond)) { continue; }
+            if (!receiveLine(connection, line, pending)) { // the client is gone.
+                job->cancellation.cancel();
+                break;
+            }
+            if (line == "CANCEL") { job->cancellation.cancel(); }
+        }
+        finished.wait();
+    } else {
+        sendLine(connection, "REJECTED invalid request or full queue");
+        ++stat.rejectedJobNum;
+    }
+
+    lock_guard<mutex> l(connectionMutex);
+    connections.erase(find(connections.begin(), connections.end(), connection));
+    ::close(connection); // close it after leaving the list so that a reused descriptor will not be shut down by stop().
+    --activeConnectionNum;
+    connectionCond.notify_all();
+}
+
+void SolveServer::work(int worker) {
+    { MpSolver warmUp; } // start the environment of this worker before any job arrives.
+
+    for (;;) {
+        JobPtr job;
+        {
+            unique_lock<mutex> l(queueMutex);
+            queueCond.wait(l, [this]() { return (!isRunning || !jobQueue.empty()); });
+            if (!isRunning) { return; }
+            job = jobQueue.top();
+            jobQueue.pop();
+        }
+        Log(LogSwitch::Szx::MpSolver) << "solve server[" << worker << "]: job " << job->id << " starts" << endl;
+        runJob(*job);
+    }
+}
+
+void SolveServer::runJob(Job &job) {
+    ostringstream done;
+    done << fullPrecision << "DONE " << job.id << " ";
+    if (job.cancellation.isCancelled()) { // expired in the queue.
+        ++stat.expiredJobNum;
+        done << MpSolver::ResultStatus::ExceedLimit << " 0 0 0";
+        finishJob(job, done.str());
+        return;
+    }
+
+    SharedMemory shm;
+    MpModelView view;
+    if (!shm.open(job.shmName) || !view.attach(shm.data(), shm.size())) {
+        done << MpSolver::ResultStatus::Error << " 0 0 0";
+        finishJob(job, done.str());
+        return;
+    }
+
+    try {
+        MpSolver solver;
+        solver.load(view);
+        solver.setMaxThread(cfg.solverThreadNum);
+        solver.setTimeLimitInSecond(job.timeLimitInSecond);
+        solver.setCancellationToken(job.cancellation); // clamp the time limit to the deadline.
+
+        Timer timer(Timer::toMillisecond(job.timeLimitInSecond));
+        MpSolver::AsyncHandle handle(solver.optimizeAsync(job.cancellation));
+        while (!handle.waitFor(cfg.progressIntervalInSecond)) {
+            MpSolver::AsyncProgress progress(handle.poll());
+            ostringstream oss;
+            oss << fullPrecision << "PROGRESS " << job.id << " " << progress.bestObj << " " << progress.bestBound
+                << " " << progress.solutionCount << " " << timer.elapsedSeconds();
+            sendLine(job.connection, oss.str());
+        }
+        handle.get();
+
+        solver.saveSolution(view);
+        ++stat.solvedJobNum;
+        const MpModelLayout &result(*view.header);
+        done << result.status << " " << result.solutionCount << " " << result.obj << " " << result.bound;
+    } catch (GRBException &e) {
+        Log(LogSwitch::Szx::MpSolver) << "solve server: job " << job.id << " fails with " << e.getMessage() << endl;
+        done << MpSolver::ResultStatus::Error << " 0 0 0";
+    } catch (exception &e) { // e.g., a malformed model or out of memory, which must not kill the worker.
+        Log(LogSwitch::Szx::MpSolver) << "solve server: job " << job.id << " fails with " << e.what() << endl;
+        done << MpSolver::ResultStatus::Error << " 0 0 0";
+    }
+    finishJob(job, done.str());
+}
+
+void SolveServer::finishJob(Job &job, const String &line) {
+    sendLine(job.connection, line);
+    job.finished.set_value();
+}
+
+bool SolveServer::sendLine(int connection, const String &line) {
+    String message(line + '\n');
+    for (size_t sent = 0; sent < message.size();) {
+        ssize_t n = send(connection, message.data() + sent, message.size() - sent, SendFlags);
+        if (n <= 0) { return false; }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool SolveServer::receiveLine(int connection, String &line, String &pending) {
+    char buffer[4096];
+    for (;;) {
+        size_t end = pending.find('\n');
+        if (end != String::npos) {
+            line.assign(pending, 0, end);
+            pending.erase(0, end + 1);
+            return true;
+        }
+        if (pending.size() > MaxLineLength) { return false; } // a client can not exhaust the memory without a newline.
+        ssize_t n = recv(connection, buffer, sizeof(buffer), 0);
+        if (n <= 0) { return false; }
+        pending.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+
+bool SolveClient::solve(const String &shmName, Result &result, int priority, double timeLimitInSecond,
+    double deadlineInSecond, OnProgress onProgress, const CancellationToken &cancellation) {
+    result = Result();
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) { return false; }
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0) { return false; }
+    if (connect(connection, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(connection);
+        return false;
+    }
+
+    ostringstream request;
+    request << fullPrecision << "SOLVE " << shmName << " " << priority << " " << timeLimitInSecond << " " << deadlineInSecond;
+    String line;
+    String pending;
+    String reply;
+    bool isDone = false;
+    if (SolveServer::sendLine(connection, request.str()) && SolveServer::receiveLine(connection, line, pending)) {
+        istringstream iss(line);
+        result.isAccepted = ((iss >> reply) && (reply == "ACCEPTED") && (iss >> result.jobId));
+    }
+
+    bool isCancelSent = false;
+    while (result.isAccepted && !isDone) {
+        if (!isCancelSent && cancellation.isCancelled()) {
+            isCancelSent = SolveServer::sendLine(connection, "CANCEL");
+        }
+        if ((pending.find('\n') == String::npos) && !waitReadable(connection, SolveServer::PollIntervalInMillisecond)) { continue; }
+        if (!SolveServer::receiveLine(connection, line, pending)) { break; }
+
+        istringstream iss(line);
+        int jobId;
+        iss >> reply >> jobId;
+        if (reply == "PROGRESS") {
+            Progress progress;
+            iss >> progress.bestObj >> progress.bestBound >> progress.solutionCount >> progress.elapsedSeconds;
+            if (onProgress) { onProgress(progress); }
+        } else if (reply == "DONE") {
+            int status;
+            iss >> status >> result.solutionCount >> result.obj >> result.bound;
+            result.status = static_cast<MpSolver::ResultStatus>(status);
+            isDone = true;
+        }
+    }
+    ::close(connection);
+    return isDone;
+}
+#else
+bool SharedMemory::create(const String &name, uint64_t size) { return false; }
+bool SharedMemory::open(const String &name) { return false; }
+void SharedMemory::close() {}
+
+bool SolveServer::start() {
+    Log(LogSwitch::Szx::MpSolver) << "solve server: unsupported platform." << endl;
+    return false;
+}
+void SolveServer::stop() {}
+void SolveServer::acceptConnections() {}
+void SolveServer::serveConnection(int connection) {}
+void SolveServer::work(int worker) {}
+void SolveServer::runJob(Job &job) {}
+void SolveServer::finishJob(Job &job, const String &line) {}
+bool SolveServer::sendLine(int connection, const String &line) { return false; }
+bool SolveServer::receiveLine(int connection, String &line, String &pending) { return false; }
+
+bool SolveClient::solve(const String &shmName, Result &result, int priority, double timeLimitInSecond,
+    double deadlineInSecond, OnProgress onProgress, const CancellationToken &cancellation) {
+    result = Result();
+    return false;
+}
+#endif // SOLVE_SERVER_POSIX
+
+}
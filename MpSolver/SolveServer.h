@@ -0,0 +1,228 @@
+////////////////////////////////
+/// usage : 1.	a long-lived local solve server which accepts jobs over a Unix domain socket, so that the clients
+///             share the warm solver environments instead of paying the startup on every request.
+///         2.	the model of a job is passed in a shared memory segment in the layout of MpModelData.h,
+///             and the solution is written back into the same segment, so that nothing is copied.
+///         3.	the jobs are queued by priority then deadline, and each worker thread keeps its environment.
+///         4.	the progress of the running jobs is streamed back to the clients periodically.
+///
+/// note  : 1.	the protocol is line based:
+///             client: "SOLVE <shmName> <priority> <timeLimitInSecond> <deadlineInSecond>", "CANCEL".
+///             server: "ACCEPTED <jobId>", "REJECTED <reason>",
+///                     "PROGRESS <jobId> <bestObj> <bestBound> <solutionCount> <elapsedSeconds>",
+///                     "DONE <jobId> <status> <solutionCount> <obj> <bound>".
+///         2.	the deadline is relative to the submission, and the job is stopped with its best solution at
+///             the deadline, or dropped if it is still queued then.
+///         3.	only POSIX systems are supported, start() fails on other platforms.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_SOLVE_SERVER_H
+#define SMART_SZX_GATE_REASSIGNMENT_SOLVE_SERVER_H
+
+
+#include "Config.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <queue>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+#include "MpModelData.h"
+
+
+#define SOLVE_SERVER_POSIX  (_OS_UNIX || _OS_APPLE_MAC)
+
+
+namespace szx {
+
+/// a named shared memory segment mapped into the address space of the process.
+class SharedMemory {
+public:
+    SharedMemory() {}
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+    ~SharedMemory() { close(); }
+
+
+    /// create a new segment which is removed when the creator closes it.
+    bool create(const String &name, std::uint64_t size);
+    /// map an existing segment.
+    bool open(const String &name);
+    void close();
+
+    void* data() { return addr; }
+    std::uint64_t size() const { return len; }
+
+protected:
+    String segmentName;
+    void *addr = nullptr;
+    std::uint64_t len = 0;
+    bool isOwner = false;
+};
+
+
+class SolveServer {
+    #pragma region Constant
+public:
+    static constexpr auto DefaultSocketPath = "/tmp/szx.mpsolver.sock";
+
+    static constexpr int PollIntervalInMillisecond = 200; // the interval to check the stop and cancellation requests.
+    static constexpr std::size_t MaxLineLength = 4096; // the longer lines are treated as a broken connection.
+    #pragma endregion Constant
+
+    #pragma region Type
+public:
+    struct Configuration {
+        static constexpr int DefaultWorkerNum = 1;
+        static constexpr double DefaultProgressIntervalInSecond = 1;
+        static constexpr int DefaultMaxQueueSize = 1024;
+
+        Configuration(const String &path = DefaultSocketPath, int workers = DefaultWorkerNum)
+            : socketPath(path), workerNum(workers), solverThreadNum(MpSolver::AutoThreading),
+            progressIntervalInSecond(DefaultProgressIntervalInSecond), maxQueueSize(DefaultMaxQueueSize) {}
+
+        String socketPath;
+        int workerNum; // the number of concurrent solves, each of which owns a warm environment.
+        int solverThreadNum; // the threads used by each solve.
+        double progressIntervalInSecond;
+        int maxQueueSize;
+    };
+
+    struct Job {
+        int id;
+        long long seq; // break ties by the submission order.
+        int connection;
+        String shmName;
+        int priority; // the larger the earlier.
+        double timeLimitInSecond;
+        CancellationToken::TimePoint deadline;
+        CancellationToken cancellation;
+        std::promise<void> finished;
+    };
+    using JobPtr = std::shared_ptr<Job>;
+
+    struct JobOrder {
+        bool operator()(const JobPtr &l, const JobPtr &r) const { // true if l is served after r.
+            if (l->priority != r->priority) { return (l->priority < r->priority); }
+            if (l->deadline != r->deadline) { return (l->deadline > r->deadline); }
+            return (l->seq > r->seq);
+        }
+    };
+
+    struct Statistics {
+        std::atomic<int> acceptedJobNum = { 0 };
+        std::atomic<int> rejectedJobNum = { 0 };
+        std::atomic<int> expiredJobNum = { 0 };
+        std::atomic<int> solvedJobNum = { 0 };
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    SolveServer(const Configuration &config = Configuration()) : cfg(config) {}
+    ~SolveServer() { stop(); }
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// listen on the socket and start the workers. returns false if the socket is unavailable.
+    bool start();
+    /// cancel all jobs and wait for the threads to end.
+    void stop();
+
+    const Statistics& getStatistics() const { return stat; }
+
+    static bool sendLine(int connection, const String &line);
+    // pending keeps the received bytes after the line. returns false if the line is longer than MaxLineLength.
+    static bool receiveLine(int connection, String &line, String &pending);
+
+protected:
+    void acceptConnections();
+    void serveConnection(int connection);
+    void work(int worker);
+    void runJob(Job &job);
+    void finishJob(Job &job, const String &line);
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    int listener = -1;
+    std::atomic<bool> isRunning = { false };
+    std::thread acceptor;
+    List<std::thread> workers;
+
+    // the connections are served by detached threads, which are waited through the counter on stop.
+    std::mutex connectionMutex;
+    std::condition_variable connectionCond;
+    List<int> connections;
+    int activeConnectionNum = 0;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCond;
+    std::priority_queue<JobPtr, List<JobPtr>, JobOrder> jobQueue;
+    int jobCount = 0;
+    CancellationToken jobCancellation; // the parent of the tokens of all jobs, which stops them on stop().
+
+    Statistics stat;
+    #pragma endregion Field
+}; // SolveServer
+
+
+class SolveClient {
+    #pragma region Type
+public:
+    struct Progress {
+        double bestObj = 0;
+        double bestBound = 0;
+        int solutionCount = 0;
+        double elapsedSeconds = 0;
+    };
+
+    struct Result {
+        bool isAccepted = false;
+        int jobId = -1;
+        MpSolver::ResultStatus status = MpSolver::ResultStatus::Error;
+        int solutionCount = 0;
+        double obj = 0;
+        double bound = 0;
+    };
+
+    using OnProgress = std::function<void(const Progress&)>;
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    SolveClient(const String &path = SolveServer::DefaultSocketPath) : socketPath(path) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// submit the model in the shared memory segment and block until the job ends.
+    /// the values of the solution are written into the segment by the server.
+    /// returns false if the server is unreachable or the job is rejected.
+    bool solve(const String &shmName, Result &result, int priority = 0,
+        double timeLimitInSecond = MpSolver::Configuration::Forever, double deadlineInSecond = MpSolver::Configuration::Forever,
+        OnProgress onProgress = OnProgress(), const CancellationToken &cancellation = CancellationToken());
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    String socketPath;
+    #pragma endregion Field
+}; // SolveClient
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_SOLVE_SERVER_H
@@ -0,0 +1,467 @@
+#include "SymmetryDetector.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <set>
+#include <tuple>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+bool SymmetryDetector::detect(MpSolver &solver, Report &report, const CancellationToken &cancellation) {
+    // the permutations found on the linear rows may not preserve the other constraints.
+    if (!solver.isLinear() || solver.isPresolved() || solver.isScaled()) {
+        report = Report();
+        Log(LogSwitch::Szx::MpSolver) << "symmetry: skipped since the model is not linear or is reduced." << endl;
+        return false;
+    }
+    MpModelData data;
+    solver.save(data);
+    analyze(data.getView(), report, cancellation);
+    if (cfg.reportOnly || (report.getRowCount() <= 0)) { return (report.generatorNum > 0); }
+
+    Arr<MpSolver::DecisionVar> vars(solver.getAllVars());
+    List<MpSolver::DecisionVar> columns(vars.begin(), vars.end());
+    SparseMatrix rows(SparseMatrix::fromTriplets(report.getRowCount(), vars.size(), report.rows, report.cols, report.coefs));
+    solver.addConstraints(rows, columns, report.senses, report.rhs);
+    return true;
+}
+
+void SymmetryDetector::analyze(const MpModelView &view, Report &report, const CancellationToken &cancellation) {
+    CancellationToken token(cancellation.createChild());
+    token.setDeadlineInSecond(cfg.timeoutInSecond);
+    Timer timer(0ms); // only for the elapsed time.
+    report = Report();
+    buildGraph(view);
+    generators.clear();
+    orbitParents.resize(varNum);
+    iota(orbitParents.begin(), orbitParents.end(), 0);
+    breakingNonzeroNum = 0;
+
+    List<int> baseColors;
+    int baseColorNum = refine(baseColors, initColors(view, baseColors));
+
+    // try to map the first variable of each cell to the others which are not in its orbit yet.
+    List<int> cellOrder(varNum);
+    iota(cellOrder.begin(), cellOrder.end(), 0);
+    sort(cellOrder.begin(), cellOrder.end(), [&](int l, int r) {
+        return (baseColors[l] != baseColors[r]) ? (baseColors[l] < baseColors[r]) : (l < r);
+    });
+    List<int> perm;
+    bool isStopped = false;
+    for (int begin = 0, end = 0; !isStopped && (begin < varNum); begin = end) {
+        for (end = begin + 1; (end < varNum) && (baseColors[cellOrder[end]] == baseColors[cellOrder[begin]]); ++end) {}
+        int u = cellOrder[begin];
+        for (int i = begin + 1; i < end; ++i) {
+            int v = cellOrder[i];
+            if (findOrbit(v) == findOrbit(u)) { continue; }
+            isStopped = (static_cast<int>(generators.size()) >= cfg.maxGeneratorNum) || token.isCancelled();
+            if (isStopped) { break; }
+            if (!findAutomorphism(baseColors, baseColorNum, u, v, perm, token)) { continue; }
+
+            generators.emplace_back();
+            Generator &g(generators.back());
+            for (int x = 0; x < varNum; ++x) {
+                if (perm[x] == x) { continue; }
+                g.vars.push_back(x);
+                g.images.push_back(perm[x]);
+                orbitParents[findOrbit(x)] = findOrbit(perm[x]);
+            }
+        }
+    }
+    report.generatorNum = static_cast<int>(generators.size());
+
+    map<int, int> orbitIndices;
+    for (int x = 0; x < varNum; ++x) {
+        int root = findOrbit(x);
+        if (root == x) {
+            bool isTrivial = true;
+            for (auto g = generators.begin(); isTrivial && (g != generators.end()); ++g) {
+                isTrivial = (find(g->vars.begin(), g->vars.end(), x) == g->vars.end());
+            }
+            if (isTrivial) { continue; }
+        }
+        auto o = orbitIndices.find(root);
+        if (o == orbitIndices.end()) {
+            o = orbitIndices.emplace(root, static_cast<int>(report.orbits.size())).first;
+            report.orbits.emplace_back();
+        }
+        report.orbits[o->second].push_back(x);
+    }
+
+    List<char> isInOrbitope(varNum, false);
+    if (cfg.method == Method::Orbitopal) { addOrbitopalRows(report, isInOrbitope); }
+    for (auto g = generators.begin(); g != generators.end(); ++g) {
+        bool isOrbitopal = false;
+        for (auto x = g->vars.begin(); !isOrbitopal && (x != g->vars.end()); ++x) { isOrbitopal = isInOrbitope[*x]; }
+        if (!isOrbitopal) { addLexicographicRow(*g, report); }
+    }
+
+    report.elapsedSeconds = timer.elapsedSeconds();
+    Log(LogSwitch::Szx::MpSolver) << "symmetry: generators=" << report.generatorNum << " orbits=" << report.orbits.size()
+        << " orbitopes=" << report.orbitopeNum << " rows=" << report.getRowCount() << " time=" << report.elapsedSeconds << endl;
+}
+
+void SymmetryDetector::buildGraph(const MpModelView &view) {
+    model = &view;
+    varNum = view.getVariableCount();
+    rowNum = view.getConstraintCount();
+    vertexNum = varNum + rowNum;
+    int64_t nnz = view.getNonzeroCount();
+
+    // the coefficients with the same value share the same edge color.
+    List<double> coefValues(view.coefs, view.coefs + nnz);
+    sort(coefValues.begin(), coefValues.end());
+    coefValues.erase(unique(coefValues.begin(), coefValues.end()), coefValues.end());
+
+    adjBegin.assign(vertexNum + 1, 0);
+    for (int r = 0; r < rowNum; ++r) {
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) { ++adjBegin[view.cols[i] + 1]; }
+        adjBegin[varNum + r + 1] = view.rowBegin[r + 1] - view.rowBegin[r];
+    }
+    for (int x = 0; x < vertexNum; ++x) { adjBegin[x + 1] += adjBegin[x]; }
+    adjVertices.resize(static_cast<size_t>(2 * nnz));
+    adjColors.resize(static_cast<size_t>(2 * nnz));
+    List<int64_t> next(adjBegin.begin(), adjBegin.end() - 1);
+    for (int r = 0; r < rowNum; ++r) {
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) {
+            int col = view.cols[i];
+            int color = static_cast<int>(lower_bound(coefValues.begin(), coefValues.end(), view.coefs[i]) - coefValues.begin());
+            int64_t colPos = next[col]++;
+            adjVertices[colPos] = varNum + r;
+            adjColors[colPos] = color;
+            int64_t rowPos = next[varNum + r]++;
+            adjVertices[rowPos] = col;
+            adjColors[rowPos] = color;
+        }
+    }
+
+    stamps.assign(varNum, 0);
+    stampCoefs.assign(varNum, 0);
+    stampId = 0;
+}
+
+int SymmetryDetector::initColors(const MpModelView &view, List<int> &colors) {
+    auto less = [&](int l, int r) {
+        bool isLeftRow = (l >= varNum);
+        bool isRightRow = (r >= varNum);
+        if (isLeftRow != isRightRow) { return isRightRow; } // the variables go first.
+        if (isLeftRow) {
+            l -= varNum;
+            r -= varNum;
+            return make_tuple(view.senses[l], view.rhs[l]) < make_tuple(view.senses[r], view.rhs[r]);
+        }
+        return make_tuple(view.type[l], view.lb[l], view.ub[l], view.obj[l]) < make_tuple(view.type[r], view.lb[r], view.ub[r], view.obj[r]);
+    };
+
+    vertexOrder.resize(vertexNum);
+    iota(vertexOrder.begin(), vertexOrder.end(), 0);
+    sort(vertexOrder.begin(), vertexOrder.end(), less);
+    colors.resize(vertexNum);
+    int colorNum = 0;
+    for (int i = 0; i < vertexNum; ++i) {
+        if ((i > 0) && less(vertexOrder[i - 1], vertexOrder[i])) { ++colorNum; }
+        colors[vertexOrder[i]] = colorNum;
+    }
+    return (vertexNum > 0) ? (colorNum + 1) : 0;
+}
+
+int SymmetryDetector::refine(List<int> &colors, int colorNum) {
+    signatures.resize(adjVertices.size());
+    for (;;) {
+        // the signature of a vertex is the sorted colors of its edges and neighbors.
+        for (int x = 0; x < vertexNum; ++x) {
+            for (int64_t i = adjBegin[x]; i < adjBegin[x + 1]; ++i) {
+                signatures[i] = (static_cast<int64_t>(adjColors[i]) << 32) | colors[adjVertices[i]];
+            }
+            sort(signatures.begin() + adjBegin[x], signatures.begin() + adjBegin[x + 1]);
+        }
+        auto less = [&](int l, int r) {
+            if (colors[l] != colors[r]) { return (colors[l] < colors[r]); }
+            return lexicographical_compare(signatures.begin() + adjBegin[l], signatures.begin() + adjBegin[l + 1],
+                signatures.begin() + adjBegin[r], signatures.begin() + adjBegin[r + 1]);
+        };
+
+        vertexOrder.resize(vertexNum);
+        iota(vertexOrder.begin(), vertexOrder.end(), 0);
+        sort(vertexOrder.begin(), vertexOrder.end(), less);
+        newColors.resize(vertexNum);
+        int newColorNum = 0;
+        for (int i = 0; i < vertexNum; ++i) {
+            if ((i > 0) && less(vertexOrder[i - 1], vertexOrder[i])) { ++newColorNum; }
+            newColors[vertexOrder[i]] = newColorNum;
+        }
+        if (vertexNum > 0) { ++newColorNum; }
+        colors.swap(newColors);
+        if (newColorNum == colorNum) { return colorNum; } // the classes only split, so no split means stable.
+        colorNum = newColorNum;
+    }
+}
+
+void SymmetryDetector::individualize(List<int> &colors, int &colorNum, int vertex) {
+    // the vertex keeps its color and the rest of its class moves to the next one, which preserves the order of classes.
+    int color = colors[vertex];
+    for (int x = 0; x < static_cast<int>(colors.size()); ++x) {
+        if ((colors[x] > color) || ((colors[x] == color) && (x != vertex))) { ++colors[x]; }
+    }
+    ++colorNum;
+}
+
+bool SymmetryDetector::findAutomorphism(const List<int> &baseColors, int baseColorNum, int u, int v, List<int> &perm, const CancellationToken &token) {
+    List<int> colorsU(baseColors);
+    List<int> colorsV(baseColors);
+    int colorNumU = baseColorNum;
+    int colorNumV = baseColorNum;
+    individualize(colorsU, colorNumU, u);
+    individualize(colorsV, colorNumV, v);
+
+    List<int> cellSizesU;
+    List<int> cellSizesV;
+    for (;;) {
+        colorNumU = refine(colorsU, colorNumU);
+        colorNumV = refine(colorsV, colorNumV);
+        if (colorNumU != colorNumV) { return false; }
+        cellSizesU.assign(colorNumU, 0);
+        cellSizesV.assign(colorNumV, 0);
+        for (int x = 0; x < vertexNum; ++x) {
+            ++cellSizesU[colorsU[x]];
+            ++cellSizesV[colorsV[x]];
+        }
+        if (cellSizesU != cellSizesV) { return false; }
+        if (colorNumU == vertexNum) { break; }
+        if (token.isCancelled()) { return false; }
+
+        // individualize the first vertex of the first non-singleton class on both sides,
+        // where fixing the same vertex is preferred to get a permutation with a small support.
+        int color = static_cast<int>(find_if(cellSizesU.begin(), cellSizesU.end(), [](int size) { return (size > 1); }) - cellSizesU.begin());
+        int x = static_cast<int>(find(colorsU.begin(), colorsU.end(), color) - colorsU.begin());
+        int y = (colorsV[x] == color) ? x : static_cast<int>(find(colorsV.begin(), colorsV.end(), color) - colorsV.begin());
+        individualize(colorsU, colorNumU, x);
+        individualize(colorsV, colorNumV, y);
+    }
+
+    // map the vertex of each color on one side to the vertex of the same color on the other side.
+    List<int> &vertexOfColor(newColors);
+    vertexOfColor.resize(vertexNum);
+    for (int y = 0; y < vertexNum; ++y) { vertexOfColor[colorsV[y]] = y; }
+    perm.resize(vertexNum);
+    for (int x = 0; x < vertexNum; ++x) { perm[x] = vertexOfColor[colorsU[x]]; }
+    return isAutomorphism(perm);
+}
+
+bool SymmetryDetector::isAutomorphism(const List<int> &perm) {
+    const MpModelView &view(*model);
+    for (int x = 0; x < varNum; ++x) {
+        int y = perm[x];
+        if ((view.type[x] != view.type[y]) || (view.lb[x] != view.lb[y]) || (view.ub[x] != view.ub[y]) || (view.obj[x] != view.obj[y])) { return false; }
+    }
+    for (int r = 0; r < rowNum; ++r) {
+        int q = perm[varNum + r] - varNum;
+        if ((view.senses[r] != view.senses[q]) || (view.rhs[r] != view.rhs[q])) { return false; }
+        if ((view.rowBegin[r + 1] - view.rowBegin[r]) != (view.rowBegin[q + 1] - view.rowBegin[q])) { return false; }
+        ++stampId;
+        for (int64_t i = view.rowBegin[q]; i < view.rowBegin[q + 1]; ++i) {
+            stamps[view.cols[i]] = stampId;
+            stampCoefs[view.cols[i]] = view.coefs[i];
+        }
+        for (int64_t i = view.rowBegin[r]; i < view.rowBegin[r + 1]; ++i) {
+            int y = perm[view.cols[i]];
+            if ((stamps[y] != stampId) || (stampCoefs[y] != view.coefs[i])) { return false; }
+        }
+    }
+    return true;
+}
+
+void SymmetryDetector::addLexicographicRow(const Generator &generator, Report &report) {
+    // (x >= g(x)) in lexicographic order starts with (x[i] >= x[j]) where i is the first moved one and (g(j) == i).
+    int first = static_cast<int>(min_element(generator.vars.begin(), generator.vars.end()) - generator.vars.begin());
+    int i = generator.vars[first];
+    int j = generator.vars[find(generator.images.begin(), generator.images.end(), i) - generator.images.begin()];
+    addRow({ i, j }, { 1, -1 }, MpSolver::ConstraintSense::GreaterEqual, 0, report);
+}
+
+void SymmetryDetector::addOrbitopalRows(Report &report, List<char> &isInOrbitope) {
+    // the involutions which exchange two blocks of variables, i.e., swap two columns of a potential orbitope.
+    struct Swap {
+        int generator;
+        int blocks[2];
+    };
+    map<List<int>, int> blockIndices;
+    List<List<int>> blocks;
+    List<int> varBlocks(varNum, -1);
+    List<char> isBlockValid; // no variable is in multiple blocks.
+    List<Swap> swaps;
+    List<int> imageOf(varNum, -1);
+    for (int g = 0; g < static_cast<int>(generators.size()); ++g) {
+        const Generator &generator(generators[g]);
+        int supportSize = static_cast<int>(generator.vars.size());
+        for (int k = 0; k < supportSize; ++k) { imageOf[generator.vars[k]] = generator.images[k]; }
+        bool isInvolution = true;
+        List<int> sides[2];
+        for (int k = 0; k < supportSize; ++k) {
+            int x = generator.vars[k];
+            int y = generator.images[k];
+            isInvolution &= (imageOf[y] == x);
+            if (x < y) {
+                sides[0].push_back(x);
+                sides[1].push_back(y);
+            }
+        }
+        for (int k = 0; k < supportSize; ++k) { imageOf[generator.vars[k]] = -1; }
+        if (!isInvolution) { continue; }
+
+        Swap swap = { g, { -1, -1 } };
+        for (int s = 0; s < 2; ++s) {
+            sort(sides[s].begin(), sides[s].end());
+            auto b = blockIndices.emplace(sides[s], static_cast<int>(blocks.size()));
+            swap.blocks[s] = b.first->second;
+            if (!b.second) { continue; }
+            blocks.push_back(sides[s]);
+            isBlockValid.push_back(true);
+            for (auto x = sides[s].begin(); x != sides[s].end(); ++x) {
+                if (varBlocks[*x] >= 0) {
+                    isBlockValid[varBlocks[*x]] = false;
+                    isBlockValid.back() = false;
+                }
+                varBlocks[*x] = swap.blocks[s];
+            }
+        }
+        swaps.push_back(swap);
+    }
+
+    // the blocks connected by the swaps form the columns of an orbitope, whose rows are matched through the swaps.
+    int blockNum = static_cast<int>(blocks.size());
+    List<List<int>> blockSwaps(blockNum);
+    for (int s = 0; s < static_cast<int>(swaps.size()); ++s) {
+        if (!isBlockValid[swaps[s].blocks[0]] || !isBlockValid[swaps[s].blocks[1]]) { continue; }
+        blockSwaps[swaps[s].blocks[0]].push_back(s);
+        blockSwaps[swaps[s].blocks[1]].push_back(s);
+    }
+    List<char> isVisited(blockNum, false);
+    List<int> rowOf(varNum, -1);
+    for (int root = 0; root < blockNum; ++root) {
+        if (isVisited[root] || blockSwaps[root].empty()) { continue; }
+        List<int> columns(1, root);
+        isVisited[root] = true;
+        for (int r = 0; r < static_cast<int>(blocks[root].size()); ++r) { rowOf[blocks[root][r]] = r; }
+        bool isConsistent = true;
+        for (size_t head = 0; head < columns.size(); ++head) {
+            int block = columns[head];
+            for (auto s = blockSwaps[block].begin(); s != blockSwaps[block].end(); ++s) {
+                const Generator &generator(generators[swaps[*s].generator]);
+                for (size_t k = 0; k < generator.vars.size(); ++k) {
+                    int x = generator.vars[k];
+                    int y = generator.images[k];
+                    if (varBlocks[x] != block) { continue; }
+                    if (rowOf[y] < 0) { rowOf[y] = rowOf[x]; }
+                    isConsistent &= (rowOf[y] == rowOf[x]);
+                }
+                int other = swaps[*s].blocks[(swaps[*s].blocks[0] == block) ? 1 : 0];
+                if (isVisited[other]) { continue; }
+                isVisited[other] = true;
+                columns.push_back(other);
+            }
+        }
+
+        // matrix[r][k] is the variable in row r and column k, where the columns are ordered by their first variables.
+        sort(columns.begin(), columns.end(), [&](int l, int r) { return (blocks[l].front() < blocks[r].front()); });
+        int colNum = static_cast<int>(columns.size());
+        int matrixRowNum = static_cast<int>(blocks[root].size());
+        List<List<int>> matrix(matrixRowNum, List<int>(colNum));
+        for (int k = 0; k < colNum; ++k) {
+            for (auto x = blocks[columns[k]].begin(); x != blocks[columns[k]].end(); ++x) { matrix[rowOf[*x]][k] = *x; }
+        }
+        for (int k = 0; k < colNum; ++k) {
+            for (auto x = blocks[columns[k]].begin(); x != blocks[columns[k]].end(); ++x) { rowOf[*x] = -1; }
+        }
+        if (!isConsistent || !isPacking(matrix)) { continue; }
+
+        ++report.orbitopeNum;
+        for (int r = 0; r < matrixRowNum; ++r) {
+            for (int k = 0; k < colNum; ++k) { isInOrbitope[matrix[r][k]] = true; }
+        }
+        // the columns in lexicographically decreasing order have increasing rows of their first nonzeros,
+        // so column k starts no earlier than row k and after the first nonzero of column k - 1.
+        for (int k = 1; k < colNum; ++k) {
+            for (int r = 0; (r < k) && (r < matrixRowNum); ++r) {
+                addRow({ matrix[r][k] }, { 1 }, MpSolver::ConstraintSense::LessEqual, 0, report);
+            }
+        }
+        List<int> vars;
+        List<double> coefs;
+        for (int k = 1; k < colNum; ++k) {
+            for (int r = k; r < matrixRowNum; ++r) {
+                vars.assign(1, matrix[r][k]);
+                coefs.assign(1, 1);
+                for (int prev = k - 1; prev < r; ++prev) {
+                    vars.push_back(matrix[prev][k - 1]);
+                    coefs.push_back(-1);
+                }
+                if (!addRow(vars, coefs, MpSolver::ConstraintSense::LessEqual, 0, report)) { break; }
+            }
+        }
+    }
+}
+
+bool SymmetryDetector::isPacking(const List<List<int>> &matrix) {
+    // each row of the orbitope is covered by a row (sum(a[i] * x[i]) <= b) with (b <= 1), binary x and nonnegative
+    // terms, where the coefficients of the orbitope variables are at least 1.
+    static constexpr double Tolerance = 1e-9;
+    const MpModelView &view(*model);
+    for (auto row = matrix.begin(); row != matrix.end(); ++row) {
+        ++stampId;
+        for (auto x = row->begin(); x != row->end(); ++x) {
+            bool isBinary = (view.type[*x] != MpSolver::VariableType::Real) && (view.lb[*x] >= 0) && (view.ub[*x] <= 1);
+            if (!isBinary) { return false; }
+            stamps[*x] = stampId;
+        }
+        bool isCovered = false;
+        int first = row->front();
+        for (int64_t e = adjBegin[first]; !isCovered && (e < adjBegin[first + 1]); ++e) {
+            int r = adjVertices[e] - varNum;
+            if ((view.senses[r] == MpSolver::ConstraintSense::GreaterEqual) || (view.rhs[r] > 1 + Tolerance)) { continue; }
+            int coveredNum = 0;
+            bool isNonnegative = true;
+            for (int64_t i = view.rowBegin[r]; isNonnegative && (i < view.rowBegin[r + 1]); ++i) {
+                int col = view.cols[i];
+                isNonnegative = (view.coefs[i] >= 0) && (view.lb[col] >= 0);
+                if (stamps[col] != stampId) { continue; }
+                isNonnegative &= (view.coefs[i] >= 1 - Tolerance);
+                ++coveredNum;
+            }
+            isCovered = isNonnegative && (coveredNum == static_cast<int>(row->size()));
+        }
+        if (!isCovered) { return false; }
+    }
+    return true;
+}
+
+bool SymmetryDetector::addRow(const List<int> &vars, const List<double> &coefs, char sense, double rhs, Report &report) {
+    if (breakingNonzeroNum + static_cast<int64_t>(vars.size()) > cfg.maxBreakingNonzeroNum) { return false; }
+    breakingNonzeroNum += vars.size();
+    int row = report.getRowCount();
+    for (size_t i = 0; i < vars.size(); ++i) {
+        report.rows.push_back(row);
+        report.cols.push_back(vars[i]);
+        report.coefs.push_back(coefs[i]);
+    }
+    report.senses.push_back(sense);
+    report.rhs.push_back(rhs);
+    return true;
+}
+
+int SymmetryDetector::findOrbit(int var) {
+    while (orbitParents[var] != var) {
+        orbitParents[var] = orbitParents[orbitParents[var]];
+        var = orbitParents[var];
+    }
+    return var;
+}
+
+}
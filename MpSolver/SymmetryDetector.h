@@ -0,0 +1,150 @@
+////////////////////////////////
+/// usage : 1.	find the orbits of the interchangeable variables (e.g., identical gates or crews) from the structure
+///             of the model, and break the symmetry by constraints so that the B&B does not explore equivalent subtrees.
+///         2.	the automorphisms are searched on the graph of the variables and the rows whose edges are colored by
+///             the coefficients, by color refinement and individualization.
+///         3.	the lexicographic method adds (x[i] >= x[j]) for each automorphism, where i is the first variable it
+///             moves and j is mapped to i. the orbitopal method recognizes the blocks of variables swapped as columns
+///             (e.g., the assignment variables of the identical gates) with at most one nonzero in each row, and orders
+///             the columns by fixing and column inequalities, while the rest falls back to the lexicographic method.
+///
+/// note  : 1.	the automorphisms preserve the bounds, the types, the objective and the constraints, so the breaking
+///             constraints keep at least one optimal solution.
+///         2.	the search is greedy and may miss some automorphisms, which only weakens the breaking.
+///         3.	the constraints are only reported but not added in the report only mode.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_SYMMETRY_DETECTOR_H
+#define SMART_SZX_GATE_REASSIGNMENT_SYMMETRY_DETECTOR_H
+
+
+#include "Config.h"
+
+#include <cstdint>
+
+#include "Common.h"
+#include "Utility.h"
+#include "MpSolver.h"
+#include "MpModelData.h"
+
+
+namespace szx {
+
+class SymmetryDetector {
+    #pragma region Type
+public:
+    enum Method {
+        Lexicographic,
+        Orbitopal
+    };
+
+    struct Configuration {
+        static constexpr double DefaultTimeoutInSecond = 10;
+        static constexpr int DefaultMaxGeneratorNum = 1000;
+        static constexpr std::int64_t DefaultMaxBreakingNonzeroNum = 1000000;
+
+        Configuration(Method breakingMethod = Method::Orbitopal, double timeoutInSec = DefaultTimeoutInSecond)
+            : method(breakingMethod), reportOnly(false), timeoutInSecond(timeoutInSec),
+            maxGeneratorNum(DefaultMaxGeneratorNum), maxBreakingNonzeroNum(DefaultMaxBreakingNonzeroNum) {}
+
+        Method method;
+        bool reportOnly; // do not add the breaking constraints into the model.
+        double timeoutInSecond;
+        int maxGeneratorNum;
+        std::int64_t maxBreakingNonzeroNum; // the breaking constraints beyond it are skipped.
+    };
+
+    struct Report {
+        int generatorNum = 0;
+        int orbitopeNum = 0;
+        List<List<int>> orbits; // the indices of the variables in each orbit with at least two variables.
+        double elapsedSeconds = 0;
+
+        // the breaking constraints, where the i_th entry is (rows[i], cols[i], coefs[i]) and cols are variable indices.
+        List<int> rows;
+        List<int> cols;
+        List<double> coefs;
+        List<char> senses;
+        List<double> rhs;
+
+        int getRowCount() const { return static_cast<int>(senses.size()); }
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    SymmetryDetector(const Configuration &config = Configuration()) : cfg(config) {}
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// analyze the model and add the breaking constraints unless it is in the report only mode.
+    /// returns true if any symmetry is found. the report is empty if the model is not linear (see MpSolver::isLinear()),
+    /// or it has been presolved or scaled.
+    bool detect(MpSolver &model, Report &report, const CancellationToken &cancellation = CancellationToken());
+    /// analyze the flat model without changing it.
+    /// the search of the generators stops once the token is cancelled, and the found ones are kept.
+    void analyze(const MpModelView &view, Report &report, const CancellationToken &cancellation = CancellationToken());
+
+protected:
+    // a permutation of the variables in the sparse form, which maps vars[i] to images[i].
+    struct Generator {
+        List<int> vars;
+        List<int> images;
+    };
+
+    void buildGraph(const MpModelView &view);
+    // the canonical colors of the vertices by the attributes of the variables and the rows.
+    int initColors(const MpModelView &view, List<int> &colors);
+    // split the color classes until each vertex in a class has the same colored neighborhood.
+    // the new colors only depend on the structure, so that the same refinement on isomorphic graphs matches.
+    int refine(List<int> &colors, int colorNum);
+    // give the vertex a unique color.
+    static void individualize(List<int> &colors, int &colorNum, int vertex);
+    // find an automorphism mapping the variable u to v by individualizing the matched vertices until all colors are unique.
+    bool findAutomorphism(const List<int> &baseColors, int baseColorNum, int u, int v, List<int> &perm, const CancellationToken &token);
+    bool isAutomorphism(const List<int> &perm);
+
+    void addLexicographicRow(const Generator &generator, Report &report);
+    // recognize the packing orbitopes from the block swaps, and mark their variables.
+    void addOrbitopalRows(Report &report, List<char> &isInOrbitope);
+    bool isPacking(const List<List<int>> &matrix);
+    // returns false if the nonzero budget is exceeded.
+    bool addRow(const List<int> &vars, const List<double> &coefs, char sense, double rhs, Report &report);
+
+    int findOrbit(int var);
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    const MpModelView *model = nullptr;
+    int varNum = 0;
+    int rowNum = 0;
+    int vertexNum = 0; // the variables are [0, varNum) and the rows are [varNum, vertexNum).
+
+    // the adjacency of vertex x is [adjBegin[x], adjBegin[x + 1]), with the colors of the coefficients.
+    List<std::int64_t> adjBegin;
+    List<int> adjVertices;
+    List<int> adjColors;
+
+    List<Generator> generators;
+    List<int> orbitParents;
+    std::int64_t breakingNonzeroNum = 0;
+
+    // the buffers reused by refine() and isAutomorphism().
+    List<std::int64_t> signatures;
+    List<int> vertexOrder;
+    List<int> newColors;
+    List<int> stamps;
+    List<double> stampCoefs;
+    int stampId = 0;
+    #pragma endregion Field
+}; // SymmetryDetector
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_SYMMETRY_DETECTOR_H
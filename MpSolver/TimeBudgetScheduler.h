@@ -0,0 +1,161 @@
+////////////////////////////////
+/// usage : 1.	split the global time budget across the priority levels of a multi-objective optimization.
+///
+/// note  : 1.	each level is allocated from the rest of the budget instead of the total budget,
+///             so the time left over by a level which finishes early flows forward to the rest levels.
+///         2.	a level is stopped before its allocation runs out if its gap stalls,
+///             or allowed to borrow time from the rest levels if its gap is still closing fast.
+////////////////////////////////
+
+#ifndef SMART_SZX_GATE_REASSIGNMENT_TIME_BUDGET_SCHEDULER_H
+#define SMART_SZX_GATE_REASSIGNMENT_TIME_BUDGET_SCHEDULER_H
+
+
+#include "Config.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include "Common.h"
+
+
+namespace szx {
+
+class TimeBudgetScheduler {
+    #pragma region Constant
+public:
+    static constexpr double DefaultWeight = 1;
+    static constexpr double Infinity = std::numeric_limits<double>::infinity();
+    #pragma endregion Constant
+
+    #pragma region Type
+public:
+    struct Configuration {
+        static constexpr double DefaultStallRatio = 0.25;
+        static constexpr double DefaultMinStallSeconds = 1;
+        static constexpr double DefaultMinGapImprovement = 1e-4;
+        static constexpr double DefaultExtensionRatio = 0.5;
+        static constexpr double DefaultReserveRatio = 0.5;
+
+        Configuration(double stallTimeRatio = DefaultStallRatio, double minStallSec = DefaultMinStallSeconds,
+            double minGapImprove = DefaultMinGapImprovement, double extendRatio = DefaultExtensionRatio, double reserve = DefaultReserveRatio)
+            : stallRatio(stallTimeRatio), minStallSeconds(minStallSec), minGapImprovement(minGapImprove),
+            extensionRatio(extendRatio), reserveRatio(reserve) {}
+
+        double stallRatio; // a level stalls if its gap does not improve in (stallRatio * allocated seconds).
+        double minStallSeconds; // a level never stalls in less than minStallSeconds.
+        double minGapImprovement; // the improvement on relative gap smaller than it is not regarded as progress.
+        double extensionRatio; // a promising level may run over its allocation by at most (extensionRatio * allocated seconds).
+        double reserveRatio; // the rest levels keep at least (reserveRatio * their fair share) when lending time.
+    };
+
+    struct Allocation {
+        double softSeconds; // the fair share of the level.
+        double hardSeconds; // the time limit of the level including the extension.
+    };
+    #pragma endregion Type
+
+    #pragma region Constructor
+public:
+    TimeBudgetScheduler(const Configuration &config = Configuration()) : cfg(config) {}
+
+    /// start a new schedule over the levels which will be solved in order.
+    void reset(const List<double> &levelWeights) {
+        weights.clear();
+        weights.reserve(levelWeights.size());
+        for (auto w = levelWeights.begin(); w != levelWeights.end(); ++w) { weights.push_back((std::max)(*w, 0.0)); }
+        level = -1;
+    }
+    #pragma endregion Constructor
+
+    #pragma region Method
+public:
+    /// split the total budget by weights without observing any progress.
+    double getStaticShare(double totalSeconds, int levelIndex) const {
+        double weightSum = 0;
+        for (auto w = weights.begin(); w != weights.end(); ++w) { weightSum += *w; }
+        if (weightSum <= 0) { return totalSeconds / weights.size(); }
+        return totalSeconds * weights[levelIndex] / weightSum;
+    }
+
+    /// allocate time for the next level from the rest of the global budget.
+    /// levelCapInSecond limits the allocation of this level if it is greater than 0.
+    const Allocation& beginLevel(double restSeconds, double levelCapInSecond = 0) {
+        ++level;
+        restSeconds = (std::max)(restSeconds, 0.0);
+
+        double restWeight = 0;
+        for (auto w = weights.begin() + level; w != weights.end(); ++w) { restWeight += *w; }
+        int restLevelNum = static_cast<int>(weights.size()) - level;
+
+        double share = restSeconds;
+        if (restLevelNum > 1) {
+            share = (restWeight > 0) ? (restSeconds * weights[level] / restWeight) : (restSeconds / restLevelNum);
+        }
+        double lendable = (1 - cfg.reserveRatio) * (restSeconds - share);
+        double extension = (std::min)(cfg.extensionRatio * share, lendable);
+
+        allocation.softSeconds = share;
+        allocation.hardSeconds = share + extension;
+        if (levelCapInSecond > 0) {
+            allocation.softSeconds = (std::min)(allocation.softSeconds, levelCapInSecond);
+            allocation.hardSeconds = (std::min)(allocation.hardSeconds, levelCapInSecond);
+        }
+
+        stallSeconds = (std::max)(cfg.stallRatio * allocation.softSeconds, cfg.minStallSeconds);
+        firstGap = Infinity;
+        bestGap = Infinity;
+        firstGapTime = 0;
+        lastImproveTime = 0;
+        return allocation;
+    }
+
+    /// returns true if the current level should stop at elapsedSeconds since it began with the given relative gap.
+    bool shouldStop(double elapsedSeconds, double gap) {
+        if (gap < bestGap - cfg.minGapImprovement) {
+            if (std::isinf(bestGap)) {
+                firstGap = gap;
+                firstGapTime = elapsedSeconds;
+            }
+            bestGap = gap;
+            lastImproveTime = elapsedSeconds;
+        }
+        if (std::isinf(bestGap)) { return false; } // keep searching until there is an incumbent.
+        if ((elapsedSeconds - lastImproveTime) > stallSeconds) { return true; }
+        if (elapsedSeconds < allocation.softSeconds) { return false; }
+
+        // run over the fair share only if the gap is projected to be closed within the extension.
+        double closingTime = lastImproveTime - firstGapTime;
+        if (closingTime <= 0) { return true; }
+        double closingRate = (firstGap - bestGap) / closingTime;
+        if (closingRate <= 0) { return true; }
+        return ((elapsedSeconds + bestGap / closingRate) > allocation.hardSeconds);
+    }
+
+    int getLevel() const { return level; }
+    int getLevelCount() const { return static_cast<int>(weights.size()); }
+    const Allocation& getAllocation() const { return allocation; }
+    #pragma endregion Method
+
+    #pragma region Field
+public:
+    Configuration cfg;
+
+protected:
+    List<double> weights;
+    int level = -1;
+
+    Allocation allocation = { 0, 0 };
+    double stallSeconds = 0;
+    double firstGap = Infinity;
+    double bestGap = Infinity;
+    double firstGapTime = 0;
+    double lastImproveTime = 0;
+    #pragma endregion Field
+}; // TimeBudgetScheduler
+
+}
+
+
+#endif // SMART_SZX_GATE_REASSIGNMENT_TIME_BUDGET_SCHEDULER_H
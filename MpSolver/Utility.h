@@ -11,16 +11,40 @@
 #include <algorithm>
 #include <chrono>
 #include <initializer_list>
+#include <limits>
 #include <vector>
 #include <random>
+#include <unordered_set>
 #include <functional>
-
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <streambuf>
+#include <new>
+#include <type_traits>
+
+#include <cstdint>
 #include <cstring>
+#include <cstdlib>
 #include <ctime>
 #include <cmath>
 
 #include "Config.h"
 
+#if _OS_MS_WINDOWS
+#include <malloc.h>
+#endif // _OS_MS_WINDOWS
+#if _OS_GNU_LINUX
+#include <sys/mman.h>
+#endif // _OS_GNU_LINUX
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif // __AVX2__
+
 
 #define UTILITY_NOT_IMPLEMENTED  throw "Not implemented yet!";
 
@@ -44,7 +68,243 @@ namespace szx {
 #define RESOLVED_CONCAT3(a, b, c, d)  VERBATIM_CONCAT3(a, b, c, d)
 
 
-template<typename T, typename IndexType = int>
+/// the alignment of a cache line, which also suits the SIMD registers up to 512 bits.
+static constexpr size_t CacheLineSize = 64;
+static constexpr size_t HugePageSize = (1 << 21);
+
+/// allocate raw memory aligned to a power of 2, which must be freed by alignedFree().
+inline void* alignedMalloc(size_t size, size_t alignment = CacheLineSize) {
+    if (size == 0) { size = alignment; }
+    #if _OS_MS_WINDOWS
+    void *p = _aligned_malloc(size, alignment);
+    #else
+    void *p = nullptr;
+    if (posix_memalign(&p, (std::max)(alignment, sizeof(void*)), size) != 0) { p = nullptr; }
+    #endif // _OS_MS_WINDOWS
+    if (p == nullptr) { throw std::bad_alloc(); }
+    return p;
+}
+inline void alignedFree(void *p) {
+    #if _OS_MS_WINDOWS
+    _aligned_free(p);
+    #else
+    free(p);
+    #endif // _OS_MS_WINDOWS
+}
+
+/// construct and destroy the items in raw memory, which are skipped for the trivial types,
+/// i.e., the items of the trivial types are left uninitialized.
+template<typename T>
+struct ItemLifetime {
+    static void construct(T *items, size_t n) { construct(items, n, std::is_trivially_default_constructible<T>()); }
+    static void destroy(T *items, size_t n) { destroy(items, n, std::is_trivially_destructible<T>()); }
+
+protected:
+    static void construct(T*, size_t, std::true_type) {}
+    static void construct(T *items, size_t n, std::false_type) {
+        size_t i = 0;
+        try {
+            for (; i < n; ++i) { new (items + i) T(); }
+        } catch (...) {
+            destroy(items, i);
+            throw;
+        }
+    }
+    static void destroy(T*, size_t, std::true_type) {}
+    static void destroy(T *items, size_t n, std::false_type) { for (size_t i = 0; i < n; ++i) { items[i].~T(); } }
+};
+
+/// the default allocator of Arr, which is compatible with the arrays from new[], e.g., the ones returned by Gurobi.
+template<typename T>
+struct NewArrayAllocator {
+    T* allocate(size_t n) { return new T[n]; }
+    void deallocate(T *p, size_t) { delete[] p; }
+};
+
+/// aligned and uninitialized (for trivial types) allocation.
+template<typename T, size_t Alignment = CacheLineSize>
+struct AlignedAllocator {
+    T* allocate(size_t n) {
+        T *p = static_cast<T*>(alignedMalloc(sizeof(T) * n, (std::max)(Alignment, alignof(T))));
+        try {
+            ItemLifetime<T>::construct(p, n);
+        } catch (...) {
+            alignedFree(p);
+            throw;
+        }
+        return p;
+    }
+    void deallocate(T *p, size_t n) {
+        if (p == nullptr) { return; }
+        ItemLifetime<T>::destroy(p, n);
+        alignedFree(p);
+    }
+};
+
+/// the large arrays are aligned to the huge pages and advised to be backed by them where it is supported.
+template<typename T>
+struct HugePageAllocator {
+    T* allocate(size_t n) {
+        size_t size = sizeof(T) * n;
+        if (size < HugePageSize) { return AlignedAllocator<T>().allocate(n); }
+        size = (size + HugePageSize - 1) / HugePageSize * HugePageSize;
+        T *p = static_cast<T*>(alignedMalloc(size, HugePageSize));
+        #if _OS_GNU_LINUX
+        madvise(p, size, MADV_HUGEPAGE); // it is only a hint, so the failure is ignored.
+        #endif // _OS_GNU_LINUX
+        try {
+            ItemLifetime<T>::construct(p, n);
+        } catch (...) {
+            alignedFree(p);
+            throw;
+        }
+        return p;
+    }
+    void deallocate(T *p, size_t n) { AlignedAllocator<T>().deallocate(p, n); }
+};
+
+/// a monotonic buffer which hands out memory by bumping a pointer and frees everything at once.
+/// it is not thread-safe, so use one arena per thread.
+class MemoryArena {
+public:
+    static constexpr size_t DefaultBlockSize = (1 << 20);
+
+
+    MemoryArena(size_t defaultBlockSize = DefaultBlockSize) : blockSize(defaultBlockSize), cur(nullptr), rest(0) {}
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+    ~MemoryArena() { release(); }
+
+
+    void* allocate(size_t size, size_t alignment = CacheLineSize) {
+        size_t padding = (alignment - reinterpret_cast<size_t>(cur) % alignment) % alignment;
+        if (padding + size > rest) {
+            size_t newBlockSize = (std::max)(blockSize, size + alignment);
+            cur = static_cast<char*>(alignedMalloc(newBlockSize, CacheLineSize));
+            blocks.push_back(cur);
+            rest = newBlockSize;
+            padding = (alignment - reinterpret_cast<size_t>(cur) % alignment) % alignment;
+        }
+        void *p = cur + padding;
+        cur += (padding + size);
+        rest -= (padding + size);
+        return p;
+    }
+
+    /// free all memory handed out, which must not be used anymore.
+    void release() {
+        for (auto b = blocks.begin(); b != blocks.end(); ++b) { alignedFree(*b); }
+        blocks.clear();
+        cur = nullptr;
+        rest = 0;
+    }
+
+protected:
+    size_t blockSize;
+    std::vector<void*> blocks;
+    char *cur;
+    size_t rest;
+};
+
+/// the memory is reclaimed when the arena is released instead of the array.
+template<typename T, size_t Alignment = CacheLineSize>
+struct ArenaAllocator {
+    ArenaAllocator(MemoryArena *memoryArena = nullptr) : arena(memoryArena) {}
+
+    T* allocate(size_t n) {
+        T *p = static_cast<T*>(arena->allocate(sizeof(T) * n, (std::max)(Alignment, alignof(T))));
+        ItemLifetime<T>::construct(p, n);
+        return p;
+    }
+    void deallocate(T *p, size_t n) { if (p != nullptr) { ItemLifetime<T>::destroy(p, n); } }
+
+    MemoryArena *arena;
+};
+
+/// recycle the freed blocks by their sizes in powers of 2 to avoid the allocation churn of repeated rebuilds.
+/// it is thread-safe.
+class MemoryPool {
+public:
+    static constexpr int MinSizeClass = 6; // CacheLineSize.
+    static constexpr int MaxSizeClass = 30; // the larger ones are not pooled.
+
+
+    MemoryPool() : freeBlocks(MaxSizeClass + 1) {}
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+    ~MemoryPool() { release(); }
+
+
+    void* allocate(size_t size) {
+        int sizeClass = getSizeClass(size);
+        if (sizeClass > MaxSizeClass) { return alignedMalloc(size, CacheLineSize); }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            std::vector<void*> &blocks(freeBlocks[sizeClass]);
+            if (!blocks.empty()) {
+                void *p = blocks.back();
+                blocks.pop_back();
+                return p;
+            }
+        }
+        return alignedMalloc(static_cast<size_t>(1) << sizeClass, CacheLineSize);
+    }
+    void deallocate(void *p, size_t size) {
+        if (p == nullptr) { return; }
+        int sizeClass = getSizeClass(size);
+        if (sizeClass > MaxSizeClass) { return alignedFree(p); }
+        std::lock_guard<std::mutex> lock(mtx);
+        freeBlocks[sizeClass].push_back(p);
+    }
+
+    /// free the pooled blocks, while the ones in use are not affected.
+    void release() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto c = freeBlocks.begin(); c != freeBlocks.end(); ++c) {
+            for (auto b = c->begin(); b != c->end(); ++b) { alignedFree(*b); }
+            c->clear();
+        }
+    }
+
+protected:
+    static int getSizeClass(size_t size) {
+        int sizeClass = MinSizeClass;
+        while ((sizeClass <= MaxSizeClass) && ((static_cast<size_t>(1) << sizeClass) < size)) { ++sizeClass; }
+        return sizeClass;
+    }
+
+    std::mutex mtx;
+    std::vector<std::vector<void*>> freeBlocks;
+};
+
+template<typename T>
+struct PoolAllocator {
+    PoolAllocator(MemoryPool *memoryPool = nullptr) : pool(memoryPool) {}
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= CacheLineSize, "the pooled blocks are only aligned to the cache line.");
+        T *p = static_cast<T*>(pool->allocate(sizeof(T) * n));
+        try {
+            ItemLifetime<T>::construct(p, n);
+        } catch (...) {
+            pool->deallocate(p, sizeof(T) * n);
+            throw;
+        }
+        return p;
+    }
+    void deallocate(T *p, size_t n) {
+        if (p == nullptr) { return; }
+        ItemLifetime<T>::destroy(p, n);
+        pool->deallocate(p, sizeof(T) * n);
+    }
+
+    MemoryPool *pool;
+};
+
+
+/// use size_t as the IndexType for the arrays with more than 2^31 items.
+/// the arrays adopted by Arr(length, data) must be allocated by the same kind of allocator.
+template<typename T, typename IndexType = int, typename Allocator = NewArrayAllocator<T>>
 class Arr {
 public:
     /// it is always valid before copy assignment due to no reallocation.
@@ -53,20 +313,20 @@ public:
 
     enum ResetOption { AllBits0 = 0, AllBits1 = -1 };
 
-    explicit Arr() : arr(nullptr), len(0) {}
-    explicit Arr(IndexType length) { allocate(length); }
-    explicit Arr(IndexType length, T *data) : arr(data), len(length) {}
-    explicit Arr(IndexType length, const T &defaultValue) : Arr(length) {
+    explicit Arr(const Allocator &allocator = Allocator()) : arr(nullptr), len(0), alloc(allocator) {}
+    explicit Arr(IndexType length, const Allocator &allocator = Allocator()) : alloc(allocator) { allocate(length); }
+    explicit Arr(IndexType length, T *data, const Allocator &allocator = Allocator()) : arr(data), len(length), alloc(allocator) {}
+    explicit Arr(IndexType length, const T &defaultValue, const Allocator &allocator = Allocator()) : Arr(length, allocator) {
         std::fill(arr, arr + length, defaultValue);
     }
     explicit Arr(std::initializer_list<T> l) : Arr(static_cast<IndexType>(l.size())) {
         std::copy(l.begin(), l.end(), arr);
     }
 
-    Arr(const Arr &a) : Arr(a.len) {
+    Arr(const Arr &a) : Arr(a.len, a.alloc) {
         if (this != &a) { copyData(a.arr); }
     }
-    Arr(Arr &&a) : Arr(a.len, a.arr) { a.arr = nullptr; }
+    Arr(Arr &&a) : Arr(a.len, a.arr, a.alloc) { a.arr = nullptr; }
 
     Arr& operator=(const Arr &a) {
         if (this != &a) {
@@ -80,9 +340,10 @@ public:
     }
     Arr& operator=(Arr &&a) {
         if (this != &a) {
-            delete[] arr;
+            clear();
             arr = a.arr;
             len = a.len;
+            alloc = a.alloc;
             a.arr = nullptr;
         }
         return *this;
@@ -101,12 +362,12 @@ public:
 
     /// remove all items.
     void clear() {
-        delete[] arr;
+        alloc.deallocate(arr, static_cast<size_t>(len));
         arr = nullptr;
     }
 
     /// set all data to val. any value other than 0 or -1 is undefined behavior.
-    void reset(ResetOption val = ResetOption::AllBits0) { memset(arr, val, sizeof(T) * len); }
+    void reset(ResetOption val = ResetOption::AllBits0) { memset(arr, val, sizeof(T) * static_cast<size_t>(len)); }
 
     T& operator[](IndexType i) { return arr[i]; }
     const T& operator[](IndexType i) const { return arr[i]; }
@@ -129,23 +390,24 @@ public:
 protected:
     /// must not be called except init.
     void allocate(IndexType length) {
-        // TODO[szx][2]: length > (1 << 32)?
-        arr = new T[static_cast<size_t>(length)];
+        arr = alloc.allocate(static_cast<size_t>(length));
         len = length;
     }
 
-    void copyData(T *data) {
+    void copyData(const T *data) { copyData(data, std::is_trivially_copyable<T>()); }
+    void copyData(const T *data, std::true_type) {
         // TODO[szx][1]: what if data is shorter than arr?
-        // OPTIMIZE[szx][8]: use memcpy() if all callers are POD type.
-        std::copy(data, data + len, arr);
+        if (len > 0) { memcpy(arr, data, sizeof(T) * static_cast<size_t>(len)); }
     }
+    void copyData(const T *data, std::false_type) { std::copy(data, data + len, arr); }
 
 
     T *arr;
     IndexType len;
+    Allocator alloc;
 };
 
-template<typename T, typename IndexType = int>
+template<typename T, typename IndexType = int, typename Allocator = NewArrayAllocator<T>>
 class Arr2D {
 public:
     /// it is always valid before copy assignment due to no reallocation.
@@ -154,18 +416,19 @@ public:
 
     enum ResetOption { AllBits0 = 0, AllBits1 = -1 };
 
-    explicit Arr2D() : arr(nullptr), len1(0), len2(0), len(0) {}
-    explicit Arr2D(IndexType length1, IndexType length2) { allocate(length1, length2); }
-    explicit Arr2D(IndexType length1, IndexType length2, T *data)
-        : arr(data), len1(length1), len2(length2), len(length1 * length2) {}
-    explicit Arr2D(IndexType length1, IndexType length2, const T &defaultValue) : Arr2D(length1, length2) {
+    explicit Arr2D(const Allocator &allocator = Allocator()) : arr(nullptr), len1(0), len2(0), len(0), alloc(allocator) {}
+    explicit Arr2D(IndexType length1, IndexType length2, const Allocator &allocator = Allocator()) : alloc(allocator) { allocate(length1, length2); }
+    explicit Arr2D(IndexType length1, IndexType length2, T *data, const Allocator &allocator = Allocator())
+        : arr(data), len1(length1), len2(length2), len(length1 * length2), alloc(allocator) {}
+    explicit Arr2D(IndexType length1, IndexType length2, const T &defaultValue, const Allocator &allocator = Allocator())
+        : Arr2D(length1, length2, allocator) {
         std::fill(arr, arr + len, defaultValue);
     }
 
-    Arr2D(const Arr2D &a) : Arr2D(a.len1, a.len2) {
+    Arr2D(const Arr2D &a) : Arr2D(a.len1, a.len2, a.alloc) {
         if (this != &a) { copyData(a.arr); }
     }
-    Arr2D(Arr2D &&a) : Arr2D(a.len1, a.len2, a.arr) { a.arr = nullptr; }
+    Arr2D(Arr2D &&a) : Arr2D(a.len1, a.len2, a.arr, a.alloc) { a.arr = nullptr; }
 
     Arr2D& operator=(const Arr2D &a) {
         if (this != &a) {
@@ -182,11 +445,12 @@ public:
     }
     Arr2D& operator=(Arr2D &&a) {
         if (this != &a) {
-            delete[] arr;
+            clear();
             arr = a.arr;
             len1 = a.len1;
             len2 = a.len2;
             len = a.len;
+            alloc = a.alloc;
             a.arr = nullptr;
         }
         return *this;
@@ -205,12 +469,12 @@ public:
 
     /// remove all items.
     void clear() {
-        delete[] arr;
+        alloc.deallocate(arr, static_cast<size_t>(len));
         arr = nullptr;
     }
 
     /// set all data to val. any value other than 0 or -1 is undefined behavior.
-    void reset(ResetOption val = ResetOption::AllBits0) { memset(arr, val, sizeof(T) * len); }
+    void reset(ResetOption val = ResetOption::AllBits0) { memset(arr, val, sizeof(T) * static_cast<size_t>(len)); }
 
     IndexType getFlatIndex(IndexType i1, IndexType i2) const { return (i1 * len2 + i2); }
 
@@ -252,53 +516,189 @@ protected:
         len1 = length1;
         len2 = length2;
         len = length1 * length2;
-        arr = new T[static_cast<size_t>(len)];
+        arr = alloc.allocate(static_cast<size_t>(len));
     }
 
-    void copyData(T *data) {
+    void copyData(const T *data) { copyData(data, std::is_trivially_copyable<T>()); }
+    void copyData(const T *data, std::true_type) {
         // TODO[szx][1]: what if data is shorter than arr?
-        // OPTIMIZE[szx][8]: use memcpy() if all callers are POD type.
-        std::copy(data, data + len, arr);
+        if (len > 0) { memcpy(arr, data, sizeof(T) * static_cast<size_t>(len)); }
     }
+    void copyData(const T *data, std::false_type) { std::copy(data, data + len, arr); }
 
 
     T *arr;
     IndexType len1;
     IndexType len2;
     IndexType len;
+    Allocator alloc;
+};
+
+
+/// xoshiro256** by Blackman and Vigna, which keeps 32 bytes of state and is much faster than std::mt19937.
+/// jump() advances the state by 2^128 steps, so the streams jumped different times from one seed never overlap.
+class Xoshiro256 {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return (std::numeric_limits<result_type>::max)(); }
+
+
+    explicit Xoshiro256(std::uint64_t seed = 0) { this->seed(seed); }
+
+
+    /// expand the seed by splitmix64, which never yields the all-zero state.
+    void seed(std::uint64_t seed) {
+        for (int i = 0; i < 4; ++i) {
+            std::uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            s[i] = z ^ (z >> 31);
+        }
+    }
+
+    result_type operator()() {
+        std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    void discard(unsigned long long n) { for (; n > 0; --n) { (*this)(); } }
+
+    /// advance 2^128 steps.
+    void jump() {
+        static constexpr std::uint64_t Polynomial[] = { 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull };
+        jump(Polynomial);
+    }
+    /// advance 2^192 steps, e.g., to separate the streams of different machines.
+    void longJump() {
+        static constexpr std::uint64_t Polynomial[] = { 0x76E15D3EFEFDCBBFull, 0xC5004E441C522FB3ull, 0x77710069854EE241ull, 0x39109BB02ACBE635ull };
+        jump(Polynomial);
+    }
+
+protected:
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    void jump(const std::uint64_t *polynomial) {
+        std::uint64_t t[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < 4; ++i) {
+            for (int b = 0; b < 64; ++b) {
+                if (polynomial[i] & (static_cast<std::uint64_t>(1) << b)) {
+                    for (int j = 0; j < 4; ++j) { t[j] ^= s[j]; }
+                }
+                (*this)();
+            }
+        }
+        std::copy(t, t + 4, s);
+    }
+
+
+    std::uint64_t s[4];
 };
 
 
 class Random {
 public:
-    using Generator = std::mt19937;
+    using Generator = Xoshiro256;
 
     
-    Random(int seed) : rgen(seed) {}
+    Random(int seed) : rgen(static_cast<std::uint64_t>(seed)) {}
+    /// the streamIndex_th independent stream from the seed, e.g., for the parallel workers of a reproducible run.
+    Random(int seed, int streamIndex) : rgen(static_cast<std::uint64_t>(seed)) {
+        for (int i = 0; i < streamIndex; ++i) { rgen.jump(); }
+    }
     Random() : rgen(generateSeed()) {}
 
 
     static int generateSeed() {
-        return static_cast<int>(std::time(nullptr) + std::clock());
+        return static_cast<int>(std::random_device()() ^ static_cast<unsigned>(std::time(nullptr) + std::clock()));
     }
 
     Generator::result_type operator()() { return rgen(); }
 
     // pick with probability of (numerator / denominator).
     bool isPicked(unsigned numerator, unsigned denominator) {
-        return ((rgen() % denominator) < numerator);
+        return (bounded(denominator) < numerator);
     }
 
     // pick from [min, max).
     int pick(int min, int max) {
-        return ((rgen() % (max - min)) + min);
+        return static_cast<int>(bounded(static_cast<std::uint32_t>(max - min))) + min;
     }
     // pick from [0, max).
     int pick(int max) {
-        return (rgen() % max);
+        return static_cast<int>(bounded(static_cast<std::uint32_t>(max)));
+    }
+
+    // uniform real number in [0, 1) with 53 random bits.
+    double uniform() {
+        return (rgen() >> 11) * (1.0 / (static_cast<std::uint64_t>(1) << 53));
+    }
+    // uniform real number in [min, max).
+    double uniform(double min, double max) {
+        return min + (max - min) * uniform();
+    }
+
+    // fill the array with the integers in [min, max).
+    template<typename IndexType, typename Allocator>
+    void fill(Arr<int, IndexType, Allocator> &arr, int min, int max) {
+        for (auto i = arr.begin(); i != arr.end(); ++i) { *i = pick(min, max); }
+    }
+    // fill the array with the real numbers in [min, max).
+    template<typename IndexType, typename Allocator>
+    void fill(Arr<double, IndexType, Allocator> &arr, double min, double max) {
+        for (auto i = arr.begin(); i != arr.end(); ++i) { *i = uniform(min, max); }
+    }
+
+    // Fisher-Yates shuffle.
+    template<typename RandomIterator>
+    void shuffle(RandomIterator first, RandomIterator last) {
+        int n = static_cast<int>(last - first);
+        for (int i = n - 1; i > 0; --i) { std::swap(first[i], first[pick(i + 1)]); }
+    }
+
+    // pick k distinct numbers from [0, n) in random order.
+    void sample(int n, int k, std::vector<int> &picked) {
+        picked.clear();
+        if (k * 4 > n) { // partial Fisher-Yates shuffle for the dense samples.
+            std::vector<int> items(n);
+            for (int i = 0; i < n; ++i) { items[i] = i; }
+            for (int i = 0; i < k; ++i) { std::swap(items[i], items[pick(i, n)]); }
+            picked.assign(items.begin(), items.begin() + k);
+            return;
+        }
+        std::unordered_set<int> isPicked; // Floyd's algorithm for the sparse samples.
+        for (int i = n - k; i < n; ++i) {
+            int item = pick(i + 1);
+            if (!isPicked.insert(item).second) { item = i; isPicked.insert(item); }
+            picked.push_back(item);
+        }
+        shuffle(picked.begin(), picked.end()); // the order of Floyd's algorithm is biased.
     }
 
 protected:
+    // Lemire's nearly divisionless method, which has no modulo bias.
+    std::uint32_t bounded(std::uint32_t range) {
+        std::uint64_t m = (rgen() >> 32) * range;
+        std::uint32_t low = static_cast<std::uint32_t>(m);
+        if (low < range) {
+            std::uint32_t threshold = (0u - range) % range;
+            while (low < threshold) {
+                m = (rgen() >> 32) * range;
+                low = static_cast<std::uint32_t>(m);
+            }
+        }
+        return static_cast<std::uint32_t>(m >> 32);
+    }
+
+
     Generator rgen;
 };
 
@@ -321,6 +721,11 @@ public:
     static constexpr double MillisecondsPerSecond = 1000;
     static constexpr double ClocksPerSecond = CLOCKS_PER_SEC;
     static constexpr int ClocksPerMillisecond = static_cast<int>(ClocksPerSecond / MillisecondsPerSecond);
+    #if UTILITY_TIMER_CPP_STYLE
+    static constexpr double MaxMillisecond = 1e12; // about 30 years, far from the overflow of the nanosecond clocks.
+    #else
+    static constexpr double MaxMillisecond = (std::numeric_limits<int>::max)() / 4 / ClocksPerMillisecond;
+    #endif // UTILITY_TIMER_CPP_STYLE
 
 
     #if UTILITY_TIMER_CPP_STYLE
@@ -347,11 +752,14 @@ public:
         #endif // UTILITY_TIMER_CPP_STYLE
     }
 
+    // the duration is clamped so that the end time never overflows, e.g., for the timeout `Forever`.
     static Millisecond toMillisecond(double second) {
+        double maxMillisecond = MaxMillisecond;
+        double millisecond = (std::min)(second * MillisecondsPerSecond, maxMillisecond);
         #if UTILITY_TIMER_CPP_STYLE
-        return Millisecond(static_cast<int>(second * MillisecondsPerSecond));
+        return Millisecond(static_cast<Millisecond::rep>(millisecond));
         #else
-        return static_cast<Millisecond>(second * MillisecondsPerSecond);
+        return static_cast<Millisecond>(millisecond);
         #endif // UTILITY_TIMER_CPP_STYLE
     }
 
@@ -394,7 +802,735 @@ protected:
     TimePoint endTime;
 };
 
+
+/// a steady clock which is read from a cached tick, so that it is cheap enough to be checked in the hot loops.
+/// the tick is refreshed by a background thread which only runs while any subscription is alive,
+/// and it falls back to the steady clock otherwise.
+class CoarseClock {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    static constexpr int ResolutionInMillisecond = 1;
+
+
+    /// keep the ticker running during its lifetime.
+    class Subscription {
+    public:
+        Subscription() { instance().subscribe(); }
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+        ~Subscription() { instance().unsubscribe(); }
+    };
+
+
+    static TimePoint now() {
+        CoarseClock &clock(instance());
+        if (clock.subscriberNum.load(std::memory_order_relaxed) <= 0) { return Clock::now(); }
+        return TimePoint(Clock::duration(clock.tick.load(std::memory_order_relaxed)));
+    }
+
+protected:
+    CoarseClock() : tick(Clock::now().time_since_epoch().count()), subscriberNum(0), isStopped(true) {}
+    ~CoarseClock() { stop(); }
+
+    static CoarseClock& instance() {
+        static CoarseClock clock;
+        return clock;
+    }
+
+    void subscribe() {
+        std::lock_guard<std::mutex> l(mtx);
+        if (subscriberNum.load(std::memory_order_relaxed) <= 0) {
+            tick.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            isStopped = false;
+            int interval = ResolutionInMillisecond;
+            ticker = std::thread([this, interval]() {
+                while (!isStopped.load(std::memory_order_relaxed)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+                    tick.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                }
+            });
+        }
+        subscriberNum.fetch_add(1, std::memory_order_relaxed);
+    }
+    void unsubscribe() {
+        std::lock_guard<std::mutex> l(mtx);
+        if (subscriberNum.fetch_sub(1, std::memory_order_relaxed) == 1) { stop(); }
+    }
+    void stop() {
+        isStopped = true;
+        if (ticker.joinable()) { ticker.join(); }
+    }
+
+
+    std::atomic<Clock::rep> tick;
+    std::atomic<int> subscriberNum;
+    std::atomic<bool> isStopped;
+    std::mutex mtx;
+    std::thread ticker;
+};
+
+
+/// a cancellation flag shared by all copies of the token, which is also raised once the deadline is reached.
+/// it can be cancelled and checked on any thread.
+/// the children created by createChild() are cancelled with their parent and never outlive its deadline,
+/// so that a driver can stop all nested or concurrent solves by its own token.
+class CancellationToken {
+public:
+    using Clock = CoarseClock::Clock;
+    using TimePoint = Clock::time_point;
+
+
+    CancellationToken() : state(std::make_shared<State>()) {}
+
+
+    /// a token which is cancelled by its own or any ancestor.
+    CancellationToken createChild() const {
+        CancellationToken child;
+        child.state->parent = state;
+        return child;
+    }
+
+    void cancel() { state->isCancelled.store(true, std::memory_order_relaxed); }
+
+    /// the coarse clock keeps ticking while any token with a deadline is alive.
+    void setDeadline(const TimePoint &deadline) {
+        if (!state->isClockSubscribed.exchange(true)) { state->clockSubscription.reset(new CoarseClock::Subscription()); }
+        state->deadline.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+    /// there will be no deadline if it is too far away, e.g., for the timeout `Forever`.
+    void setDeadlineInSecond(double seconds) {
+        if (seconds >= MaxDeadlineInSecond) {
+            state->deadline.store(NoDeadline, std::memory_order_relaxed);
+            return;
+        }
+        setDeadline(Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds)));
+    }
+
+    /// it is checked against the coarse clock, so it costs a few atomic loads per ancestor.
+    bool isCancelled() const {
+        Clock::rep now = NoDeadline; // the clock is only read if there is any deadline.
+        for (const State *s = state.get(); s; s = s->parent.get()) {
+            if (s->isCancelled.load(std::memory_order_relaxed)) { return true; }
+            Clock::rep deadline = s->deadline.load(std::memory_order_relaxed);
+            if (deadline == NoDeadline) { continue; }
+            if (now == NoDeadline) { now = CoarseClock::now().time_since_epoch().count(); }
+            if (now >= deadline) { return true; }
+        }
+        return false;
+    }
+
+    /// the earliest deadline of itself and the ancestors.
+    TimePoint getDeadline() const {
+        Clock::rep deadline = NoDeadline;
+        for (const State *s = state.get(); s; s = s->parent.get()) {
+            deadline = (std::min)(deadline, s->deadline.load(std::memory_order_relaxed));
+        }
+        return TimePoint(Clock::duration(deadline));
+    }
+    bool hasDeadline() const { return (getDeadline().time_since_epoch().count() != NoDeadline); }
+    /// the rest time to the deadline, or the given default if there is no deadline.
+    double restSeconds(double defaultSeconds = (std::numeric_limits<double>::max)()) const {
+        if (!hasDeadline()) { return defaultSeconds; }
+        return std::chrono::duration<double>(getDeadline() - Clock::now()).count();
+    }
+
+protected:
+    static constexpr Clock::rep NoDeadline = (std::numeric_limits<Clock::rep>::max)();
+    static constexpr double MaxDeadlineInSecond = 1e9; // about 30 years.
+
+    struct State {
+        std::atomic<bool> isCancelled = { false };
+        std::atomic<Clock::rep> deadline = { NoDeadline };
+        std::shared_ptr<const State> parent;
+        std::atomic<bool> isClockSubscribed = { false };
+        std::unique_ptr<CoarseClock::Subscription> clockSubscription;
+    };
+
+    std::shared_ptr<State> state;
+};
+
+
+/// fixed worker threads which run the same job on every thread in a batch.
+/// the thread_local resources (e.g., solver environments) of each worker are reused across batches.
+class ThreadPool {
+public:
+    /// task(threadIndex) is invoked in the worker thread with the given index.
+    using Task = std::function<void(int)>;
+    /// task(itemIndex, threadIndex).
+    using ItemTask = std::function<void(int, int)>;
+
+
+    static int getHardwareConcurrency() { return (std::max)(static_cast<int>(std::thread::hardware_concurrency()), 1); }
+
+
+    ThreadPool(int threadNum = getHardwareConcurrency()) {
+        threadNum = (std::max)(threadNum, 1);
+        workers.reserve(threadNum);
+        for (int t = 0; t < threadNum; ++t) { workers.emplace_back([this, t]() { work(t); }); }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            isStopped = true;
+        }
+        jobReady.notify_all();
+        for (auto w = workers.begin(); w != workers.end(); ++w) { w->join(); }
+    }
+
+    /// run task on every worker once and wait for all of them. the first exception is rethrown.
+    void broadcast(const Task &task) {
+        std::unique_lock<std::mutex> lock(mtx);
+        job = &task;
+        error = nullptr;
+        pendingNum = size();
+        ++generation;
+        jobReady.notify_all();
+        jobDone.wait(lock, [this]() { return (pendingNum == 0); });
+        job = nullptr;
+        if (error) { std::rethrow_exception(error); }
+    }
+
+    /// run task on each item in [begin, end) with dynamic load balancing and wait for all of them.
+    void parallelFor(int begin, int end, const ItemTask &task) {
+        std::atomic<int> next(begin);
+        broadcast([&](int threadIndex) {
+            for (int i = next++; i < end; i = next++) { task(i, threadIndex); }
+        });
+    }
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+protected:
+    void work(int threadIndex) {
+        long long handledGeneration = 0;
+        for (;;) {
+            const Task *task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                jobReady.wait(lock, [&]() { return (isStopped || (generation != handledGeneration)); });
+                if (isStopped) { return; }
+                handledGeneration = generation;
+                task = job;
+            }
+            try {
+                (*task)(threadIndex);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!error) { error = std::current_exception(); }
+            }
+            std::lock_guard<std::mutex> lock(mtx);
+            if (--pendingNum == 0) { jobDone.notify_all(); }
+        }
+    }
+
+
+    std::vector<std::thread> workers;
+
+    std::mutex mtx;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    const Task *job = nullptr;
+    long long generation = 0;
+    int pendingNum = 0;
+    bool isStopped = false;
+    std::exception_ptr error;
+};
+
+
+/// a sparse matrix in CSR (row major) or CSC (column major) form.
+/// the entries of the major line i are [begins[i], begins[i + 1]) with the minor indices in ascending order.
+class SparseMatrix {
+public:
+    enum Layout { RowMajor, ColumnMajor };
+
+    /// a sparse vector which refers to a line of the matrix.
+    struct Line {
+        double dot(const double *dense) const { return SparseMatrix::dot(indices, values, len, dense); }
+
+        const std::int32_t *indices;
+        const double *values;
+        std::int64_t len;
+    };
+
+
+    SparseMatrix(Layout storageLayout = Layout::RowMajor, int rowNum = 0, int colNum = 0)
+        : layout(storageLayout), rowCount(rowNum), colCount(colNum) {
+        begins.assign(getMajorCount() + 1, 0);
+    }
+
+
+    /// build the matrix from the entries (rows[i], cols[i], vals[i]), where the duplicated entries are summed up.
+    /// the entries are bucketed by the major index and each line is sorted concurrently if the pool is given.
+    static SparseMatrix fromTriplets(int rowNum, int colNum, const std::vector<int> &rows, const std::vector<int> &cols,
+        const std::vector<double> &vals, Layout storageLayout = Layout::RowMajor, ThreadPool *pool = nullptr) {
+        SparseMatrix m(storageLayout, rowNum, colNum);
+        const std::vector<int> &majors((storageLayout == Layout::RowMajor) ? rows : cols);
+        const std::vector<int> &minors((storageLayout == Layout::RowMajor) ? cols : rows);
+        int majorNum = m.getMajorCount();
+        std::int64_t nnz = static_cast<std::int64_t>(vals.size());
+
+        for (std::int64_t i = 0; i < nnz; ++i) { ++m.begins[majors[i] + 1]; }
+        for (int i = 0; i < majorNum; ++i) { m.begins[i + 1] += m.begins[i]; }
+        std::vector<std::int64_t> next(m.begins.begin(), m.begins.end() - 1);
+        m.indices.resize(static_cast<size_t>(nnz));
+        m.values.resize(static_cast<size_t>(nnz));
+        for (std::int64_t i = 0; i < nnz; ++i) {
+            std::int64_t pos = next[majors[i]]++;
+            m.indices[pos] = minors[i];
+            m.values[pos] = vals[i];
+        }
+
+        // sort each line and merge the duplicates in place, then squeeze out the gaps.
+        std::vector<std::int64_t> lens(majorNum);
+        auto sortLines = [&](int begin, int end) {
+            std::vector<std::pair<std::int32_t, double>> line;
+            for (int i = begin; i < end; ++i) {
+                std::int64_t lineBegin = m.begins[i];
+                std::int64_t lineEnd = m.begins[i + 1];
+                line.clear();
+                for (std::int64_t k = lineBegin; k < lineEnd; ++k) { line.emplace_back(m.indices[k], m.values[k]); }
+                std::sort(line.begin(), line.end(), [](const std::pair<std::int32_t, double> &l, const std::pair<std::int32_t, double> &r) {
+                    return (l.first < r.first);
+                });
+                std::int64_t len = 0;
+                for (auto e = line.begin(); e != line.end(); ++e) {
+                    if ((len > 0) && (m.indices[lineBegin + len - 1] == e->first)) {
+                        m.values[lineBegin + len - 1] += e->second;
+                    } else {
+                        m.indices[lineBegin + len] = e->first;
+                        m.values[lineBegin + len] = e->second;
+                        ++len;
+                    }
+                }
+                lens[i] = len;
+            }
+        };
+        forEachChunk(majorNum, pool, sortLines);
+
+        std::int64_t len = 0;
+        for (int i = 0; i < majorNum; ++i) {
+            std::int64_t lineBegin = m.begins[i];
+            if (lineBegin != len) {
+                std::copy(m.indices.begin() + lineBegin, m.indices.begin() + lineBegin + lens[i], m.indices.begin() + len);
+                std::copy(m.values.begin() + lineBegin, m.values.begin() + lineBegin + lens[i], m.values.begin() + len);
+            }
+            m.begins[i] = len;
+            len += lens[i];
+        }
+        m.begins[majorNum] = len;
+        m.indices.resize(static_cast<size_t>(len));
+        m.values.resize(static_cast<size_t>(len));
+        return m;
+    }
+
+    Layout getLayout() const { return layout; }
+    int getRowCount() const { return rowCount; }
+    int getColumnCount() const { return colCount; }
+    int getMajorCount() const { return (layout == Layout::RowMajor) ? rowCount : colCount; }
+    int getMinorCount() const { return (layout == Layout::RowMajor) ? colCount : rowCount; }
+    std::int64_t getNonzeroCount() const { return static_cast<std::int64_t>(values.size()); }
+
+    /// the row in CSR or the column in CSC.
+    Line getLine(int major) const {
+        std::int64_t begin = begins[major];
+        return { indices.data() + begin, values.data() + begin, begins[major + 1] - begin };
+    }
+
+    /// the transpose, which copies the arrays as they are and reads them in the other layout.
+    SparseMatrix transpose() const {
+        SparseMatrix m(*this);
+        m.layout = (layout == Layout::RowMajor) ? Layout::ColumnMajor : Layout::RowMajor;
+        std::swap(m.rowCount, m.colCount);
+        return m;
+    }
+
+    /// the same matrix in the given layout, which is converted by counting sort if the layout differs.
+    SparseMatrix toLayout(Layout storageLayout) const {
+        if (storageLayout == layout) { return *this; }
+        SparseMatrix m(storageLayout, rowCount, colCount);
+        int minorNum = getMinorCount();
+        std::int64_t nnz = getNonzeroCount();
+        for (std::int64_t k = 0; k < nnz; ++k) { ++m.begins[indices[k] + 1]; }
+        for (int i = 0; i < minorNum; ++i) { m.begins[i + 1] += m.begins[i]; }
+        std::vector<std::int64_t> next(m.begins.begin(), m.begins.end() - 1);
+        m.indices.resize(static_cast<size_t>(nnz));
+        m.values.resize(static_cast<size_t>(nnz));
+        for (int i = 0; i < getMajorCount(); ++i) { // the new minor indices are ascending since i is.
+            for (std::int64_t k = begins[i]; k < begins[i + 1]; ++k) {
+                std::int64_t pos = next[indices[k]]++;
+                m.indices[pos] = i;
+                m.values[pos] = values[k];
+            }
+        }
+        return m;
+    }
+
+    /// the major lines [begin, end), i.e., the rows in CSR or the columns in CSC.
+    SparseMatrix sliceMajor(int begin, int end) const {
+        SparseMatrix m(layout);
+        ((layout == Layout::RowMajor) ? m.rowCount : m.colCount) = end - begin;
+        ((layout == Layout::RowMajor) ? m.colCount : m.rowCount) = getMinorCount();
+        m.begins.assign(begins.begin() + begin, begins.begin() + end + 1);
+        for (auto b = m.begins.begin(); b != m.begins.end(); ++b) { *b -= begins[begin]; }
+        m.indices.assign(indices.begin() + begins[begin], indices.begin() + begins[end]);
+        m.values.assign(values.begin() + begins[begin], values.begin() + begins[end]);
+        return m;
+    }
+    /// the minor lines [begin, end), i.e., the columns in CSR or the rows in CSC.
+    SparseMatrix sliceMinor(int begin, int end) const {
+        SparseMatrix m(layout);
+        ((layout == Layout::RowMajor) ? m.rowCount : m.colCount) = getMajorCount();
+        ((layout == Layout::RowMajor) ? m.colCount : m.rowCount) = end - begin;
+        m.begins.assign(getMajorCount() + 1, 0);
+        for (int i = 0; i < getMajorCount(); ++i) {
+            // the minor indices are sorted, so the entries in range are consecutive.
+            auto first = std::lower_bound(indices.begin() + begins[i], indices.begin() + begins[i + 1], begin);
+            auto last = std::lower_bound(first, indices.begin() + begins[i + 1], end);
+            for (auto k = first; k != last; ++k) {
+                m.indices.push_back(*k - begin);
+                m.values.push_back(values[k - indices.begin()]);
+            }
+            m.begins[i + 1] = m.getNonzeroCount();
+        }
+        return m;
+    }
+
+    /// y = A * x, where the rows are computed concurrently in CSR if the pool is given.
+    void multiply(const double *x, double *y, ThreadPool *pool = nullptr) const {
+        if (layout == Layout::RowMajor) { return multiplyLines(x, y, pool); }
+        scatterLines(x, y);
+    }
+    /// y = A' * x, where the columns are computed concurrently in CSC if the pool is given.
+    void multiplyTransposed(const double *x, double *y, ThreadPool *pool = nullptr) const {
+        if (layout == Layout::ColumnMajor) { return multiplyLines(x, y, pool); }
+        scatterLines(x, y);
+    }
+
+    /// sum(values[i] * dense[indices[i]]).
+    static double dot(const std::int32_t *indices, const double *values, std::int64_t len, const double *dense) {
+        std::int64_t i = 0;
+        double sum = 0;
+        #if defined(__AVX2__)
+        __m256d acc = _mm256_setzero_pd();
+        for (; i + 4 <= len; i += 4) {
+            __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(values + i), _mm256_i32gather_pd(dense, idx, sizeof(double))));
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, acc);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        #else
+        // independent accumulators break the dependency chain of the additions.
+        double acc[4] = { 0, 0, 0, 0 };
+        for (; i + 4 <= len; i += 4) {
+            acc[0] += values[i] * dense[indices[i]];
+            acc[1] += values[i + 1] * dense[indices[i + 1]];
+            acc[2] += values[i + 2] * dense[indices[i + 2]];
+            acc[3] += values[i + 3] * dense[indices[i + 3]];
+        }
+        sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+        #endif // __AVX2__
+        for (; i < len; ++i) { sum += values[i] * dense[indices[i]]; }
+        return sum;
+    }
+
+
+    std::vector<std::int64_t> begins;
+    std::vector<std::int32_t> indices;
+    std::vector<double> values;
+
+protected:
+    static constexpr int ChunkSize = 256; // the lines handled by a task.
+
+    static void forEachChunk(int lineNum, ThreadPool *pool, const std::function<void(int, int)> &handle) {
+        if (!pool || (lineNum <= ChunkSize)) { return handle(0, lineNum); }
+        int chunkNum = (lineNum + ChunkSize - 1) / ChunkSize;
+        pool->parallelFor(0, chunkNum, [&](int chunk, int) {
+            handle(chunk * ChunkSize, (std::min)(chunk * ChunkSize + ChunkSize, lineNum));
+        });
+    }
+
+    void multiplyLines(const double *x, double *y, ThreadPool *pool) const {
+        forEachChunk(getMajorCount(), pool, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) { y[i] = getLine(i).dot(x); }
+        });
+    }
+    void scatterLines(const double *x, double *y) const {
+        std::fill(y, y + getMinorCount(), 0.0);
+        for (int i = 0; i < getMajorCount(); ++i) {
+            if (x[i] == 0) { continue; }
+            for (std::int64_t k = begins[i]; k < begins[i + 1]; ++k) { y[indices[k]] += values[k] * x[i]; }
+        }
+    }
+
+
+    Layout layout;
+    int rowCount;
+    int colCount;
+};
+
+
+/// an asynchronous logger whose records are formatted into a ring buffer of the calling thread,
+/// and written into the sink by a background thread, so that logging never locks or flushes on the hot path.
+/// `Log(LogSwitch::Szx::MpSolver) << "obj=" << obj << std::endl;` produces no code if the level is Off or
+/// more verbose than SZX_LOG_LEVEL, and the operands are not evaluated either.
+class Log {
+public:
+    using Manipulator = std::ostream& (*)(std::ostream&);
+
+    enum Level {
+        Off, // never compiled.
+        On, // the essential records.
+        Info,
+        Debug
+    };
+
+    static constexpr int MaxLevel = SZX_LOG_LEVEL;
+    static constexpr int RecordCapacity = 1024; // the records in the buffer of each thread, the rest are dropped.
+    static constexpr int TextCapacity = 232; // the longer text is truncated.
+    static constexpr int FlushIntervalInMillisecond = 10;
+
+    struct Record {
+        CoarseClock::TimePoint time;
+        int level;
+        int thread; // the threads are numbered in the order of their first records.
+        const char *file;
+        int line;
+        int length;
+        char text[TextCapacity]; // null-terminated without the trailing line breaks.
+    };
+
+    /// sink(record) is invoked on the background thread in the order of the records of each thread.
+    /// the sink may log and flush, where its own records are written in the next round, but must not replace the sink.
+    using Sink = std::function<void(const Record&)>;
+
+
+    static constexpr bool isEnabled(int level) { return (level != Level::Off) && (level <= MaxLevel); }
+
+    /// write "seconds level [thread] file:line text" lines into the stream, which is std::clog by default.
+    static void setOutput(std::ostream &os) { Hub::instance().setSink(Sink(), &os); }
+    static void setSink(Sink sink) { Hub::instance().setSink(sink, nullptr); }
+    /// block until all records committed before the call are written.
+    static void flush() { Hub::instance().drain(); }
+    /// the records dropped since the buffer of the thread is full.
+    static long long getDroppedCount() { return Hub::instance().droppedCount.load(); }
+
+protected:
+    struct Channel {
+        Channel(int threadIndex) : thread(threadIndex) {}
+
+        int thread;
+        std::atomic<std::uint64_t> head = { 0 }; // the next record to write, which is advanced by the owner.
+        std::atomic<std::uint64_t> tail = { 0 }; // the next record to read, which is advanced by the hub.
+        std::atomic<bool> isClosed = { false }; // the owner thread has exited.
+        Record records[RecordCapacity];
+    };
+
+    // the channels of all threads and the background thread which drains them.
+    class Hub {
+    public:
+        static Hub& instance() {
+            static Hub hub;
+            return hub;
+        }
+
+        std::shared_ptr<Channel> open() {
+            std::lock_guard<std::mutex> l(channelMutex);
+            channels.push_back(std::make_shared<Channel>(channelCount++));
+            return channels.back();
+        }
+
+        void setSink(Sink s, std::ostream *os) {
+            std::lock_guard<std::mutex> l(drainMutex);
+            sink = s;
+            output = os;
+        }
+
+        void drain() {
+            // the records of a sink which logs or flushes stay in the channel of this thread until the next round.
+            bool &isDraining(isDrainingThread());
+            if (isDraining) { return; }
+            std::lock_guard<std::mutex> l(drainMutex);
+            isDraining = true;
+            struct DrainGuard {
+                ~DrainGuard() { flag = false; }
+                bool &flag;
+            } guard{ isDraining };
+
+            // the channels are opened without waiting for the sink, e.g., by the first record of the sink.
+            std::vector<std::shared_ptr<Channel>> openChannels;
+            {
+                std::lock_guard<std::mutex> cl(channelMutex);
+                openChannels = channels;
+            }
+            bool isWritten = false;
+            bool hasClosed = false;
+            for (auto c = openChannels.begin(); c != openChannels.end(); ++c) {
+                Channel &channel(**c);
+                hasClosed |= channel.isClosed.load(std::memory_order_acquire); // the last records are drained before removal.
+                std::uint64_t head = channel.head.load(std::memory_order_acquire);
+                for (std::uint64_t t = channel.tail.load(std::memory_order_relaxed); t < head; ++t, isWritten = true) {
+                    write(channel.records[t % RecordCapacity]);
+                }
+                channel.tail.store(head, std::memory_order_release);
+            }
+            if (hasClosed) {
+                std::lock_guard<std::mutex> cl(channelMutex);
+                channels.erase(std::remove_if(channels.begin(), channels.end(), [](const std::shared_ptr<Channel> &c) {
+                    return c->isClosed.load(std::memory_order_acquire)
+                        && (c->tail.load(std::memory_order_relaxed) == c->head.load(std::memory_order_acquire));
+                }), channels.end());
+            }
+            if (isWritten && output) { output->flush(); }
+        }
+
+
+        std::atomic<long long> droppedCount = { 0 };
+
+    protected:
+        Hub() : startTime(CoarseClock::now()), output(&std::clog) { // the clock is started first so that it outlives the hub.
+            int interval = FlushIntervalInMillisecond;
+            flusher = std::thread([this, interval]() {
+                std::unique_lock<std::mutex> l(stopMutex);
+                while (!stopCond.wait_for(l, std::chrono::milliseconds(interval), [this]() { return isStopped; })) { drain(); }
+            });
+        }
+        ~Hub() {
+            {
+                std::lock_guard<std::mutex> l(stopMutex);
+                isStopped = true;
+            }
+            stopCond.notify_all();
+            flusher.join();
+            drain();
+        }
+
+        static bool& isDrainingThread() {
+            thread_local bool isDraining = false;
+            return isDraining;
+        }
+
+        void write(const Record &record) {
+            if (sink) { sink(record); return; }
+            if (!output) { return; }
+            static const char *levelNames[] = { "off", "on", "info", "debug" };
+            const char *file = record.file;
+            for (const char *c = record.file; *c; ++c) {
+                if ((*c == '/') || (*c == '\\')) { file = c + 1; }
+            }
+            *output << std::chrono::duration<double>(record.time - startTime).count() << " " << levelNames[record.level]
+                << " [" << record.thread << "] " << file << ":" << record.line << " ";
+            output->write(record.text, record.length);
+            output->put('\n');
+        }
+
+
+        CoarseClock::TimePoint startTime;
+
+        std::mutex drainMutex; // serializes the drains and the sink.
+        std::mutex channelMutex;
+        std::vector<std::shared_ptr<Channel>> channels;
+        int channelCount = 0;
+        Sink sink;
+        std::ostream *output;
+
+        std::mutex stopMutex;
+        std::condition_variable stopCond;
+        bool isStopped = false;
+        std::thread flusher;
+    };
+
+    // the text of the record being written, which is formatted in place without allocation.
+    class TextBuffer : public std::streambuf {
+    public:
+        void reset(char *begin, char *end) { setp(begin, end); }
+        int length() const { return static_cast<int>(pptr() - pbase()); }
+
+    protected:
+        int sync() override { return 0; } // std::endl does not flush anything.
+    };
+
+    struct ThreadState {
+        ThreadState() : os(&buffer) {}
+        ~ThreadState() {
+            if (channel) { channel->isClosed.store(true, std::memory_order_release); }
+        }
+
+        std::shared_ptr<Channel> channel;
+        TextBuffer buffer;
+        std::ostream os;
+        bool isWriting = false; // the records logged while formatting another record are dropped.
+    };
+
+    static ThreadState& getThreadState() {
+        thread_local ThreadState state;
+        if (!state.channel) { state.channel = Hub::instance().open(); }
+        return state;
+    }
+
+public:
+    // the record being written on the calling thread, which is committed on destruction.
+    class Writer {
+    public:
+        Writer(int level, const char *file, int line) : state(getThreadState()), record(nullptr) {
+            if (state.isWriting) { ++Hub::instance().droppedCount; return; }
+            Channel &channel(*state.channel);
+            head = channel.head.load(std::memory_order_relaxed);
+            if (head - channel.tail.load(std::memory_order_acquire) >= RecordCapacity) { ++Hub::instance().droppedCount; return; }
+            record = &channel.records[head % RecordCapacity];
+            record->time = CoarseClock::now();
+            record->level = level;
+            record->thread = channel.thread;
+            record->file = file;
+            record->line = line;
+            state.isWriting = true;
+            state.buffer.reset(record->text, record->text + TextCapacity - 1);
+            state.os.clear();
+        }
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        ~Writer() {
+            if (!record) { return; }
+            int length = state.buffer.length();
+            while ((length > 0) && (record->text[length - 1] == '\n')) { --length; }
+            record->text[length] = '\0';
+            record->length = length;
+            state.isWriting = false;
+            state.channel->head.store(head + 1, std::memory_order_release);
+        }
+
+        template<typename T>
+        Writer& operator<<(const T &obj) {
+            if (record) { state.os << obj; }
+            return *this;
+        }
+        Writer& operator<<(Manipulator manip) {
+            if (record) { state.os << manip; }
+            return *this;
+        }
+
+    protected:
+        ThreadState &state;
+        Record *record; // nullptr if the record is dropped.
+        std::uint64_t head;
+    };
+
+    // turn the record into a void expression to fit the conditional operator in the macro.
+    struct Voidify {
+        void operator&(const Writer&) {}
+    };
+};
+
 }
 
 
+// the operands are not evaluated unless the level is enabled, which is decided at compile time.
+#define Log(level)  !szx::Log::isEnabled(level) ? (void)0 : szx::Log::Voidify() & szx::Log::Writer((level), __FILE__, __LINE__)
+
+
 #endif // AGAIN_SZX_MP_SOLVER_H
@@ -7,7 +7,73 @@ using namespace std;
 using namespace szx;
 
 
+// the cutoff of each objective in priority mode refers to the columns merged by presolve.
+bool checkPriorityObjectivesAfterPresolve() {
+    MpSolver::Configuration cfg;
+    MpSolver solver(cfg);
+    // x and y are identical in the row and both objectives, so they are merged.
+    MpSolver::DecisionVar x = solver.addVar(MpSolver::VariableType::Bool, 0, 1, 0, "x");
+    MpSolver::DecisionVar y = solver.addVar(MpSolver::VariableType::Bool, 0, 1, 0, "y");
+    MpSolver::DecisionVar z = solver.addVar(MpSolver::VariableType::Bool, 0, 1, 0, "z");
+    solver.addConstraint(x + y + z <= 2);
+    solver.addObjective(x + y + 2 * z, MpSolver::Maximize, 2);
+    solver.addObjective(x + y, MpSolver::Minimize, 1);
+
+    const Presolver::Statistics &stat(solver.presolve());
+    if (!solver.optimize()) { return false; }
+    double xy = solver.getValue(x) + solver.getValue(y);
+    bool isCorrect = (stat.duplicateColNum == 1) && (abs(xy - 1) < 1e-6) && solver.isTrue(z);
+    cout << "priority objectives after presolve: " << (isCorrect ? "ok" : "wrong") << endl;
+    return isCorrect;
+}
+
+// the callback location is set by hand, so that the dispatch is measured without the optimizer.
+struct ReplayedEvent : public MpSolver::MpEvent {
+    ReplayedEvent(MpSolver::OnMipSln onMipSln) : MpEvent(onMipSln) {}
+    void replay(int location, long long times) {
+        where = location;
+        for (long long t = 0; t < times; ++t) { callback(); }
+    }
+};
+
+struct SolutionCounter {
+    static constexpr int Events = MpSolver::MpEvent::MipSolution;
+    void onMipSolution(MpSolver::MpEvent &) { ++count; }
+    long long count = 0;
+};
+
+template<typename Handler>
+struct ReplayedSink : public MpSolver::MpEventSink<Handler> {
+    ReplayedSink(Handler &handler) : MpSolver::MpEventSink<Handler>(handler) {}
+    void replay(int location, long long times) {
+        this->where = location;
+        for (long long t = 0; t < times; ++t) { this->callback(); }
+    }
+};
+
+// the nanoseconds per callback of the runtime dispatch through std::function and the compile time dispatch
+// through setEventHandler(), at the nodes which are not subscribed and at the solutions which are.
+void benchmarkEventDispatch(long long callbackNum = 10000000) {
+    long long count = 0;
+    ReplayedEvent event([&](MpSolver::MpEvent &) { ++count; });
+    SolutionCounter counter;
+    ReplayedSink<SolutionCounter> sink(counter);
+
+    auto measure = [&](const char *item, std::function<void(void)> replay) {
+        Timer timer(0ms); // only for the elapsed time.
+        replay();
+        cout << "event dispatch: " << item << " " << (timer.elapsedSeconds() * 1e9 / callbackNum) << "ns" << endl;
+    };
+    measure("function.node", [&]() { event.replay(GRB_CB_MIPNODE, callbackNum); });
+    measure("sink.node", [&]() { sink.replay(GRB_CB_MIPNODE, callbackNum); });
+    measure("function.solution", [&]() { event.replay(GRB_CB_MIPSOL, callbackNum); });
+    measure("sink.solution", [&]() { sink.replay(GRB_CB_MIPSOL, callbackNum); });
+    cout << "event dispatch: solutions=" << count << "/" << counter.count << endl;
+}
+
+
 int main() {
-    
-    return 0;
+    bool isCorrect = checkPriorityObjectivesAfterPresolve();
+    benchmarkEventDispatch();
+    return isCorrect ? 0 : 1;
 }